@@ -0,0 +1,125 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <inttypes.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "driver/twai.h"
+#include "esp_timer.h"
+
+#include "bench_twai.h"
+#include "can_bench_stats.h"
+
+// Quadros enviados e ainda não recebidos. Precisa caber na fila de RX.
+#define BENCH_JANELA 8
+#define BENCH_FILA_TX 4
+#define BENCH_FILA_RX 16
+
+// Sem envio nem recepção por este tempo, a rodada é encerrada
+#define BENCH_TIMEOUT_US 100000
+
+static void preenche_quadro(twai_message_t *message, uint32_t seq, uint8_t dlc) {
+    memset(message, 0, sizeof(twai_message_t));
+    message->identifier = seq & CAN_BENCH_ID_MASK;
+    message->data_length_code = dlc;
+    message->self = 1; // Recebe o próprio quadro sem precisar de ACK
+    can_bench_fill_payload(message->data, seq, dlc);
+}
+
+static bool mede_dlc(uint8_t dlc, uint32_t quadros, can_bench_result_t *r) {
+    can_bench_window_t janela;
+    if (!can_bench_window_init(&janela, r, dlc, quadros, BENCH_JANELA)) {
+        printf("Sem memória para %" PRIu32 " latências.\n", quadros);
+        return false;
+    }
+
+    twai_message_t tx, rx;
+    bool tx_pendente = false;
+
+    int64_t inicio = esp_timer_get_time();
+    int64_t ultimo_progresso = inicio;
+
+    while (r->received < quadros) {
+        if (can_bench_window_can_send(&janela)) {
+            if (!tx_pendente) {
+                preenche_quadro(&tx, can_bench_window_next_seq(&janela), dlc);
+                tx_pendente = true;
+            }
+
+            int64_t t0 = esp_timer_get_time();
+            esp_err_t err = twai_transmit(&tx, 0);
+            int64_t t1 = esp_timer_get_time();
+            r->driver_us += t1 - t0;
+
+            if (err == ESP_OK) {
+                can_bench_window_sent(&janela, t0);
+                tx_pendente = false;
+                ultimo_progresso = t1;
+            }
+        }
+
+        int64_t t0 = esp_timer_get_time();
+        esp_err_t err = twai_receive(&rx, 0);
+        int64_t t1 = esp_timer_get_time();
+        r->driver_us += t1 - t0;
+
+        if (err == ESP_OK) {
+            can_bench_window_received(&janela, rx.identifier, rx.data_length_code, rx.data, t1);
+            ultimo_progresso = t1;
+        } else if (t1 - ultimo_progresso > BENCH_TIMEOUT_US) {
+            printf("DLC %d: sem progresso, %" PRIu32 " quadros não voltaram.\n",
+                   dlc, r->sent - r->received);
+            break;
+        }
+    }
+
+    can_bench_window_finish(&janela, esp_timer_get_time() - inicio);
+    return true;
+}
+
+uint32_t bench_twai_executa(gpio_num_t tx, gpio_num_t rx, uint32_t quadros_por_dlc) {
+    twai_general_config_t g_config = TWAI_GENERAL_CONFIG_DEFAULT(tx, rx, TWAI_MODE_NO_ACK);
+    g_config.tx_queue_len = BENCH_FILA_TX;
+    g_config.rx_queue_len = BENCH_FILA_RX;
+    twai_timing_config_t t_config = TWAI_TIMING_CONFIG_500KBITS();
+    twai_filter_config_t f_config = TWAI_FILTER_CONFIG_ACCEPT_ALL();
+
+    uint32_t total = quadros_por_dlc * (TWAI_FRAME_MAX_DLC + 1);
+
+    if (twai_driver_install(&g_config, &t_config, &f_config) != ESP_OK) {
+        printf("Erro ao instalar TWAI.\n");
+        return total;
+    }
+
+    if (twai_start() != ESP_OK) {
+        printf("Erro ao iniciar TWAI.\n");
+        twai_driver_uninstall();
+        return total;
+    }
+
+    printf("Benchmark TWAI em auto-teste (NO_ACK): %" PRIu32 " quadros por DLC\n", quadros_por_dlc);
+
+    uint32_t falhas = 0;
+    for (uint8_t dlc = 0; dlc <= TWAI_FRAME_MAX_DLC; dlc++) {
+        can_bench_result_t resultado;
+        if (!mede_dlc(dlc, quadros_por_dlc, &resultado)) {
+            falhas = total;
+            break;
+        }
+
+        char linha[256];
+        can_bench_format(&resultado, linha, sizeof(linha));
+        printf("%s\n", linha);
+        falhas += (quadros_por_dlc - resultado.received) + resultado.corrupted;
+
+        // Descarta o que sobrou antes do próximo DLC
+        twai_message_t descarte;
+        while (twai_receive(&descarte, pdMS_TO_TICKS(10)) == ESP_OK) {
+        }
+    }
+
+    twai_stop();
+    twai_driver_uninstall();
+
+    return falhas;
+}
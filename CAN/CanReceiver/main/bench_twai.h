@@ -0,0 +1,21 @@
+#ifndef BENCH_TWAI_H_
+#define BENCH_TWAI_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "driver/gpio.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Instala o TWAI em modo NO_ACK (auto-teste), mede todos os DLCs (0..8)
+// e imprime a tabela de resultados. Desinstala o driver ao final.
+// Retorna o número de quadros perdidos ou corrompidos no total.
+uint32_t bench_twai_executa(gpio_num_t tx, gpio_num_t rx, uint32_t quadros_por_dlc);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* BENCH_TWAI_H_ */
@@ -6,6 +6,12 @@
 #include "driver/twai.h"
 #include "driver/gpio.h"
 
+#include "sdkconfig.h"
+#include "tabela_nos.h"
+#include "bench_twai.h"
+#include "sincronismo.h"
+#include "esp_timer.h"
+
 #define TX_GPIO_NUM ((gpio_num_t)5)
 #define RX_GPIO_NUM ((gpio_num_t)4)
 #define LED_GPIO ((gpio_num_t)17)
@@ -16,17 +22,253 @@
 #define MIN_FREQUENCY_HZ 1.0
 #define MAX_FREQUENCY_HZ 10.0
 
-// Tempo máximo sem mensagem antes de considerar desconectado (em ms)
+// Tempo máximo sem mensagem antes de considerar um nó desconectado (em ms)
 #define TIMEOUT_SEM_MENSAGEM_MS 1000
 
+// Como combinar as leituras de vários sensores para acionar o LED
+#define POLITICA_AGREGACAO AGREGACAO_MAIS_PROXIMO
+
+// Período do laço de controle do LED (em ms)
+#define PERIODO_LED_MS 10
+
+// ==================== DIMENSIONAMENTO DA RECEPÇÃO ====================
+// A 500 kbit/s com o barramento 100% ocupado chegam cerca de 4000 quadros/s
+// (quadros padrão de 8 bytes têm ~125 bits com stuffing).
+#define TAXA_ALVO_QUADROS_S 4000
+
+// Pior atraso entre duas drenagens da fila: um período do LED mais a
+// impressão das estatísticas. A fila precisa absorver esse intervalo.
+#define LATENCIA_MAX_DRENAGEM_MS 25
+
+// Margem de segurança sobre o número de quadros acumulados no pior caso
+#define FATOR_SEGURANCA_FILA 2
+
+#define RX_QUEUE_LEN (((TAXA_ALVO_QUADROS_S * LATENCIA_MAX_DRENAGEM_MS) / 1000) * FATOR_SEGURANCA_FILA)
+
+// Máximo de quadros lidos por rajada antes de voltar a atender o LED
+#define RX_RAJADA_MAX 64
+
+// Intervalo de impressão das estatísticas (em ms)
+#define PERIODO_ESTATISTICAS_MS 1000
+
+// DLC pedido nos RTRs: o mesmo da resposta, para que RTRs simultâneos
+// de consumidores diferentes sejam idênticos e não colidam
+#define DLC_LEITURA 6
+
+// Tarefa que lê os alertas do TWAI com o mestre de sincronismo ativo.
+// Fica acima do laço principal (prioridade 1) para carimbar o SYNC na hora.
+#define PRIORIDADE_ALERTAS 10
+#define PILHA_ALERTAS 3072
+
+// Imprime cada quadro recebido. Não acompanha o barramento em carga alta.
+#define LOG_CADA_QUADRO 0
+
+#define ALERTAS_RX (TWAI_ALERT_RX_DATA | TWAI_ALERT_RX_QUEUE_FULL | TWAI_ALERT_RX_FIFO_OVERRUN | \
+                    TWAI_ALERT_BUS_ERROR | TWAI_ALERT_ERR_PASS | TWAI_ALERT_BUS_OFF | TWAI_ALERT_BUS_RECOVERED)
+
+#if CONFIG_CAN_SINCRONISMO_MESTRE
+#define ALERTAS_HABILITADOS (ALERTAS_RX | ALERTAS_SINCRONISMO)
+#else
+#define ALERTAS_HABILITADOS ALERTAS_RX
+#endif
+
+typedef struct {
+    uint32_t quadros;          // Quadros lidos da fila
+    uint32_t rajadas;          // Drenagens que encontraram quadros na fila
+    uint32_t maior_rajada;     // Maior número de quadros lidos numa drenagem
+    uint32_t alertas_fila_cheia;
+    uint32_t erros_barramento;
+    uint32_t bus_off;
+    uint32_t perdidos_fila;    // rx_missed_count acumulado pelo driver
+    uint32_t perdidos_fifo;    // rx_overrun_count acumulado pelo driver
+} estatisticas_rx_t;
+
+static tabela_nos_t tabela;
+
+#if CONFIG_CAN_SINCRONISMO_MESTRE
+static sincronismo_mestre_t sincronismo;
+#endif
+
+static float calcula_frequencia(float distancia) {
+    if (distancia <= MIN_DISTANCE_CM) {
+        return MAX_FREQUENCY_HZ;
+    } else if (distancia >= MAX_DISTANCE_CM) {
+        return 0; // LED desligado
+    }
+
+    return MIN_FREQUENCY_HZ +
+           (MAX_FREQUENCY_HZ - MIN_FREQUENCY_HZ) *
+           (1 - (distancia - MIN_DISTANCE_CM) /
+           (MAX_DISTANCE_CM - MIN_DISTANCE_CM));
+}
+
+static void processa_mensagem(const twai_message_t *message, TickType_t agora) {
+    tabela_nos_atualiza(&tabela, message, agora);
+
+#if LOG_CADA_QUADRO
+    printf("====================================\n");
+    printf("Mensagem recebida:\n");
+    printf("ID: 0x%" PRIX32 "\n", message->identifier);
+    printf("DLC: %d\n", message->data_length_code);
+
+    if (message->data_length_code >= 5) {
+        float distancia;
+        memcpy(&distancia, &message->data[1], sizeof(float));
+        printf("Status: %d\n", message->data[0]);
+        printf("Distância: %.2f cm\n", distancia);
+    }
+
+    printf("Dados brutos: ");
+    for (int i = 0; i < message->data_length_code; i++) {
+        printf("%02X ", message->data[i]);
+    }
+    printf("\n====================================\n");
+#endif
+}
+
+// Esvazia a fila de recepção em rajada, sem bloquear.
+// Retorna true se a rajada parou no limite e ainda pode haver quadros na fila.
+static bool drena_fila(estatisticas_rx_t *stats) {
+    twai_message_t message;
+    uint32_t lidos = 0;
+    TickType_t agora = xTaskGetTickCount();
+
+    while (lidos < RX_RAJADA_MAX && twai_receive(&message, 0) == ESP_OK) {
+        processa_mensagem(&message, agora);
+        lidos++;
+    }
+
+    if (lidos > 0) {
+        stats->quadros += lidos;
+        stats->rajadas++;
+        if (lidos > stats->maior_rajada) {
+            stats->maior_rajada = lidos;
+        }
+    }
+
+    return lidos == RX_RAJADA_MAX;
+}
+
+static void trata_alertas(uint32_t alerts, estatisticas_rx_t *stats) {
+    if (alerts & TWAI_ALERT_RX_QUEUE_FULL) {
+        stats->alertas_fila_cheia++;
+    }
+
+    if (alerts & TWAI_ALERT_BUS_ERROR) {
+        stats->erros_barramento++;
+    }
+
+    if (alerts & TWAI_ALERT_ERR_PASS) {
+        printf("TWAI em modo erro passivo.\n");
+    }
+
+    if (alerts & TWAI_ALERT_BUS_OFF) {
+        stats->bus_off++;
+        printf("TWAI em bus-off. Iniciando recuperação...\n");
+        twai_initiate_recovery();
+    }
+
+    if (alerts & TWAI_ALERT_BUS_RECOVERED) {
+        printf("TWAI recuperado. Reiniciando...\n");
+        twai_start();
+    }
+}
+
+#if CONFIG_CAN_SINCRONISMO_MESTRE
+// Único leitor dos alertas do TWAI. O TX_SUCCESS do SYNC é carimbado assim
+// que a transmissão termina, sem esperar a drenagem da fila, o LED e as
+// estatísticas do laço principal. Os demais alertas seguem para o laço
+// principal como bits de notificação.
+static void tarefa_alertas(void *arg) {
+    TaskHandle_t laco_principal = (TaskHandle_t)arg;
+
+    while (1) {
+        uint32_t alerts = 0;
+        if (twai_read_alerts(&alerts, portMAX_DELAY) != ESP_OK) {
+            continue;
+        }
+        int64_t instante_us = esp_timer_get_time();
+
+        sincronismo_trata_alertas(&sincronismo, alerts, instante_us);
+
+        if (alerts & ~ALERTAS_SINCRONISMO) {
+            xTaskNotify(laco_principal, alerts & ~ALERTAS_SINCRONISMO, eSetBits);
+        }
+    }
+}
+#endif
+
+#if CONFIG_CAN_RTR_CONSULTA
+static void solicita_leituras(void) {
+    twai_message_t rtr = {0};
+    rtr.rtr = 1;
+    rtr.data_length_code = DLC_LEITURA;
+
+    for (uint32_t i = 0; i < CONFIG_CAN_RTR_NUM_NOS; i++) {
+        rtr.identifier = (CONFIG_CAN_RTR_ID_BASE + i) & TWAI_STD_ID_MASK;
+        if (twai_transmit(&rtr, 0) != ESP_OK) {
+            printf("Fila de TX cheia: RTR para 0x%" PRIX32 " descartado.\n", rtr.identifier);
+        }
+    }
+}
+#endif
+
+static void imprime_estatisticas(estatisticas_rx_t *stats, estatisticas_rx_t *anterior, uint32_t periodo_ms) {
+    twai_status_info_t status;
+    if (twai_get_status_info(&status) == ESP_OK) {
+        stats->perdidos_fila = status.rx_missed_count;
+        stats->perdidos_fifo = status.rx_overrun_count;
+    }
+
+    uint32_t lacunas = 0;
+    for (uint8_t i = 0; i < tabela.total_nos; i++) {
+        lacunas += tabela.nos[i].lacunas;
+    }
+
+    uint32_t quadros = stats->quadros - anterior->quadros;
+    uint32_t perdidos = (stats->perdidos_fila - anterior->perdidos_fila) +
+                        (stats->perdidos_fifo - anterior->perdidos_fifo);
+
+    printf("RX: %" PRIu32 " quadros/s | perdidos: %" PRIu32 "/s (fila %" PRIu32 ", fifo %" PRIu32 ") | "
+           "rajada máx: %" PRIu32 "/%d | fila cheia: %" PRIu32 " | erros: %" PRIu32 " | "
+           "nós: %d/%d ativos, %" PRIu32 " lacunas de sequência\n",
+           quadros * 1000 / periodo_ms,
+           perdidos * 1000 / periodo_ms,
+           stats->perdidos_fila - anterior->perdidos_fila,
+           stats->perdidos_fifo - anterior->perdidos_fifo,
+           stats->maior_rajada, RX_RAJADA_MAX,
+           stats->alertas_fila_cheia - anterior->alertas_fila_cheia,
+           stats->erros_barramento - anterior->erros_barramento,
+           tabela.nos_ativos, tabela.total_nos, lacunas);
+
+#if CONFIG_CAN_SINCRONISMO_MESTRE
+    printf("SYNC/TIME: %" PRIu32 " ciclos, %" PRIu32 " falhas, %" PRIu32 " adiados\n",
+           sincronismo.ciclos, sincronismo.falhas, sincronismo.adiados);
+#endif
+
+    stats->maior_rajada = 0;
+    *anterior = *stats;
+}
+
 void app_main(void) {
+#if CONFIG_CAN_APP_BENCHMARK
+    uint32_t falhas = bench_twai_executa(TX_GPIO_NUM, RX_GPIO_NUM, CONFIG_CAN_BENCH_FRAMES_PER_DLC);
+    printf("Benchmark concluído: %" PRIu32 " quadros perdidos ou corrompidos.\n", falhas);
+    return;
+#endif
+
     // Configura GPIO do LED
     gpio_reset_pin(LED_GPIO);
     gpio_set_direction(LED_GPIO, GPIO_MODE_OUTPUT);
     gpio_set_level(LED_GPIO, 0);
 
+    tabela_nos_inicializa(&tabela, TIMEOUT_SEM_MENSAGEM_MS, POLITICA_AGREGACAO, CONFIG_CAN_NOS_ID_BASE,
+                          CONFIG_CAN_NOS_QUANTIDADE);
+
     // Configura TWAI (CAN)
     twai_general_config_t g_config = TWAI_GENERAL_CONFIG_DEFAULT(TX_GPIO_NUM, RX_GPIO_NUM, TWAI_MODE_NORMAL);
+    g_config.rx_queue_len = RX_QUEUE_LEN;
+    g_config.alerts_enabled = ALERTAS_HABILITADOS;
     twai_timing_config_t t_config = TWAI_TIMING_CONFIG_500KBITS();
     twai_filter_config_t f_config = TWAI_FILTER_CONFIG_ACCEPT_ALL();
 
@@ -40,89 +282,103 @@ void app_main(void) {
         return;
     }
 
-    printf("Aguardando mensagens no barramento CAN...\n");
+    printf("Aguardando mensagens no barramento CAN (fila RX: %d quadros)...\n", RX_QUEUE_LEN);
+
+#if CONFIG_CAN_SINCRONISMO_MESTRE
+    sincronismo_inicializa(&sincronismo, CONFIG_CAN_SYNC_PERIODO_MS);
+    // No mesmo núcleo do app_main, onde a ISR do TWAI foi instalada
+    if (xTaskCreatePinnedToCore(tarefa_alertas, "alertas_twai", PILHA_ALERTAS, xTaskGetCurrentTaskHandle(),
+                                PRIORIDADE_ALERTAS, NULL, xPortGetCoreID()) != pdPASS) {
+        printf("Erro ao criar a tarefa de alertas.\n");
+        return;
+    }
+    printf("Mestre de sincronismo: SYNC a cada %d ms.\n", CONFIG_CAN_SYNC_PERIODO_MS);
+#endif
 
-    float distancia_atual = 0;
-    float frequencia_led = 0;
     TickType_t ultimo_toggle = xTaskGetTickCount();
-    TickType_t tempo_sem_mensagem = 0;
+    TickType_t ultima_agregacao = xTaskGetTickCount();
+    TickType_t ultima_estatistica = xTaskGetTickCount();
+#if CONFIG_CAN_RTR_CONSULTA
+    TickType_t ultima_consulta = xTaskGetTickCount();
+#endif
     bool led_estado = false;
-    bool recebeu_mensagem = false;
+    bool fila_pendente = false;
+    float frequencia_led = 0;
+    estatisticas_rx_t stats = {0};
+    estatisticas_rx_t stats_anterior = {0};
 
     while (1) {
-        twai_message_t message;
+        uint32_t alerts = 0;
 
         // ====================== ESCUTA CAN ======================
-        if (twai_receive(&message, pdMS_TO_TICKS(100)) == ESP_OK) {
-            recebeu_mensagem = true;
-            tempo_sem_mensagem = 0;
-
-            printf("====================================\n");
-            printf("Mensagem recebida:\n");
-            printf("ID: 0x%" PRIX32 "\n", message.identifier);
-            printf("DLC: %d\n", message.data_length_code);
-
-            if (message.data_length_code >= 5) {
-                uint8_t status = message.data[0];
-                memcpy(&distancia_atual, &message.data[1], sizeof(float));
-
-                printf("Status: %d\n", status);
-                printf("Distância: %.2f cm\n", distancia_atual);
-
-                // Cálculo da frequência
-                if (distancia_atual <= MIN_DISTANCE_CM) {
-                    frequencia_led = MAX_FREQUENCY_HZ;
-                } else if (distancia_atual >= MAX_DISTANCE_CM) {
-                    frequencia_led = 0; // LED desligado
-                } else {
-                    frequencia_led = MIN_FREQUENCY_HZ + 
-                                     (MAX_FREQUENCY_HZ - MIN_FREQUENCY_HZ) * 
-                                     (1 - (distancia_atual - MIN_DISTANCE_CM) / 
-                                     (MAX_DISTANCE_CM - MIN_DISTANCE_CM));
-                }
-
-                printf("Frequência LED: %.1f Hz\n", frequencia_led);
-            }
+        // Bloqueia até chegar um alerta ou até o próximo passo do LED.
+        // Se a última rajada parou no limite, só consulta os alertas.
+        TickType_t espera = fila_pendente ? 0 : pdMS_TO_TICKS(PERIODO_LED_MS);
+#if CONFIG_CAN_SINCRONISMO_MESTRE
+        // Os alertas chegam pela tarefa de alertas
+        bool alertado = xTaskNotifyWait(0, UINT32_MAX, &alerts, espera) == pdTRUE;
+#else
+        bool alertado = twai_read_alerts(&alerts, espera) == ESP_OK;
+#endif
+        if (alertado) {
+            trata_alertas(alerts, &stats);
+        }
 
-            printf("Dados brutos: ");
-            for (int i = 0; i < message.data_length_code; i++) {
-                printf("%02X ", message.data[i]);
-            }
-            printf("\n====================================\n");
+        // Os alertas se acumulam: um único TWAI_ALERT_RX_DATA pode
+        // representar vários quadros, então a fila é drenada em rajada.
+        fila_pendente = drena_fila(&stats);
 
-        } else {
-            // Sem mensagem neste ciclo (100ms)
-            tempo_sem_mensagem += 100;
-
-            if (tempo_sem_mensagem >= TIMEOUT_SEM_MENSAGEM_MS) {
-                if (recebeu_mensagem) {
-                    printf("Nenhuma mensagem recebida. Aguardando...\n");
-                }
-                recebeu_mensagem = false;
-                frequencia_led = 0;
-                gpio_set_level(LED_GPIO, 0); // LED apagado
-                led_estado = false;
-            }
+        TickType_t agora = xTaskGetTickCount();
+
+        // Timeouts por nó: a roda só visita os slots vencidos
+        if (tabela_nos_avanca(&tabela, agora) > 0 && tabela.nos_ativos == 0) {
+            printf("Nenhuma mensagem recebida. Aguardando...\n");
+        }
+
+#if CONFIG_CAN_SINCRONISMO_MESTRE
+        // ================== SINCRONISMO ==================
+        sincronismo_processa(&sincronismo, agora);
+#endif
+
+#if CONFIG_CAN_RTR_CONSULTA
+        // ================== CONSULTA POR RTR ==================
+        // Com o mestre ativo, os RTRs esperam o par SYNC/TIME terminar
+        if (agora - ultima_consulta >= pdMS_TO_TICKS(CONFIG_CAN_RTR_PERIODO_MS)
+#if CONFIG_CAN_SINCRONISMO_MESTRE
+            && sincronismo_ocioso(&sincronismo)
+#endif
+        ) {
+            solicita_leituras();
+            ultima_consulta = agora;
         }
+#endif
 
         // =================== CONTROLE DO LED ===================
-        if (recebeu_mensagem) {
-            if (frequencia_led == 0) {
-                gpio_set_level(LED_GPIO, 0); // LED desligado
-                led_estado = false;
-            } else {
-                TickType_t intervalo = (TickType_t)(1000 / frequencia_led / 2 / portTICK_PERIOD_MS);
-                if (xTaskGetTickCount() - ultimo_toggle >= intervalo) {
-                    led_estado = !led_estado;
-                    gpio_set_level(LED_GPIO, led_estado);
-                    ultimo_toggle = xTaskGetTickCount();
-                }
-            }
+        // A agregação roda uma vez por período do LED, não por quadro
+        if (agora - ultima_agregacao >= pdMS_TO_TICKS(PERIODO_LED_MS)) {
+            float distancia;
+            // LED sempre desligado sem leituras válidas
+            frequencia_led = tabela_nos_agrega(&tabela, &distancia) ? calcula_frequencia(distancia) : 0;
+            ultima_agregacao = agora;
+        }
+
+        if (frequencia_led == 0) {
+            gpio_set_level(LED_GPIO, 0); // LED desligado
+            led_estado = false;
         } else {
-            gpio_set_level(LED_GPIO, 0); // LED sempre desligado sem mensagens
+            TickType_t intervalo = (TickType_t)(1000 / frequencia_led / 2 / portTICK_PERIOD_MS);
+            if (agora - ultimo_toggle >= intervalo) {
+                led_estado = !led_estado;
+                gpio_set_level(LED_GPIO, led_estado);
+                ultimo_toggle = agora;
+            }
         }
 
-        vTaskDelay(pdMS_TO_TICKS(10));
+        // ================== ESTATÍSTICAS ==================
+        if (agora - ultima_estatistica >= pdMS_TO_TICKS(PERIODO_ESTATISTICAS_MS)) {
+            imprime_estatisticas(&stats, &stats_anterior, (agora - ultima_estatistica) * portTICK_PERIOD_MS);
+            ultima_estatistica = agora;
+        }
     }
 
     twai_stop();
@@ -0,0 +1,108 @@
+#include <string.h>
+
+#include "sincronismo.h"
+
+void sincronismo_inicializa(sincronismo_mestre_t *mestre, uint32_t periodo_ms) {
+    memset(mestre, 0, sizeof(sincronismo_mestre_t));
+    mestre->periodo = pdMS_TO_TICKS(periodo_ms);
+    mestre->estado = SINCRONISMO_OCIOSO;
+    mestre->contador = 1;
+    mestre->ultimo_sync = xTaskGetTickCount();
+    mestre->trava = xSemaphoreCreateMutex();
+}
+
+bool sincronismo_ocioso(const sincronismo_mestre_t *mestre) {
+    return mestre->estado == SINCRONISMO_OCIOSO;
+}
+
+void sincronismo_processa(sincronismo_mestre_t *mestre, TickType_t agora) {
+    if (!sincronismo_ocioso(mestre)) {
+        // Sem ACK ou barramento ocupado por mais de um período: desiste do ciclo
+        xSemaphoreTake(mestre->trava, portMAX_DELAY);
+        if (mestre->estado != SINCRONISMO_OCIOSO && agora - mestre->enviado_em > mestre->periodo) {
+            mestre->estado = SINCRONISMO_OCIOSO;
+            mestre->falhas++;
+        }
+        xSemaphoreGive(mestre->trava);
+        return;
+    }
+
+    if (agora - mestre->ultimo_sync < mestre->periodo) {
+        return;
+    }
+
+    // Um quadro ainda na fila confundiria o TX_SUCCESS do SYNC
+    twai_status_info_t status;
+    if (twai_get_status_info(&status) != ESP_OK || status.msgs_to_tx > 0) {
+        mestre->adiados++;
+        return;
+    }
+
+    twai_message_t sync = {0};
+    sync.identifier = ID_SYNC;
+    sync.data_length_code = 1;
+    sync.data[0] = mestre->contador;
+
+    // O estado muda antes do envio: o TX_SUCCESS pode chegar antes de
+    // twai_transmit retornar, e a tarefa de alertas espera pela trava
+    xSemaphoreTake(mestre->trava, portMAX_DELAY);
+    mestre->estado = SINCRONISMO_AGUARDA_SYNC;
+    mestre->enviado_em = agora;
+    if (twai_transmit(&sync, 0) != ESP_OK) {
+        mestre->estado = SINCRONISMO_OCIOSO;
+        mestre->falhas++;
+    }
+    mestre->ultimo_sync = agora;
+    xSemaphoreGive(mestre->trava);
+}
+
+void sincronismo_trata_alertas(sincronismo_mestre_t *mestre, uint32_t alertas, int64_t instante_us) {
+    if (!(alertas & ALERTAS_SINCRONISMO)) {
+        return;
+    }
+
+    xSemaphoreTake(mestre->trava, portMAX_DELAY);
+
+    if (alertas & TWAI_ALERT_TX_FAILED) {
+        if (mestre->estado != SINCRONISMO_OCIOSO) {
+            mestre->estado = SINCRONISMO_OCIOSO;
+            mestre->falhas++;
+        }
+        xSemaphoreGive(mestre->trava);
+        return;
+    }
+
+    switch (mestre->estado) {
+        case SINCRONISMO_AGUARDA_SYNC: {
+            twai_message_t quadro_time = {0};
+            quadro_time.identifier = ID_TIME;
+            quadro_time.data_length_code = 8;
+            quadro_time.data[0] = mestre->contador;
+
+            uint64_t instante = (uint64_t)instante_us;
+            for (int i = 1; i < 8; i++) {
+                quadro_time.data[i] = (uint8_t)(instante & 0xFF);
+                instante >>= 8;
+            }
+
+            if (twai_transmit(&quadro_time, 0) == ESP_OK) {
+                mestre->estado = SINCRONISMO_AGUARDA_TIME;
+            } else {
+                mestre->estado = SINCRONISMO_OCIOSO;
+                mestre->falhas++;
+            }
+            break;
+        }
+
+        case SINCRONISMO_AGUARDA_TIME:
+            mestre->estado = SINCRONISMO_OCIOSO;
+            mestre->ciclos++;
+            mestre->contador = mestre->contador % SYNC_CONTADOR_MAX + 1;
+            break;
+
+        default:
+            break;
+    }
+
+    xSemaphoreGive(mestre->trava);
+}
@@ -0,0 +1,63 @@
+#ifndef SINCRONISMO_H_
+#define SINCRONISMO_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/semphr.h"
+#include "driver/twai.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Quadros no estilo CANopen (mesmo formato de time_sync.h no transmissor):
+// SYNC: DLC 1, contador 1..240
+// TIME: DLC 8, contador do SYNC + instante em que o SYNC saiu (us, 56 bits LE)
+#define ID_SYNC 0x080
+#define ID_TIME 0x100
+#define SYNC_CONTADOR_MAX 240
+
+// Alertas que precisam estar habilitados para o mestre
+#define ALERTAS_SINCRONISMO (TWAI_ALERT_TX_SUCCESS | TWAI_ALERT_TX_FAILED)
+
+typedef enum {
+    SINCRONISMO_OCIOSO = 0,
+    SINCRONISMO_AGUARDA_SYNC, // SYNC na fila, esperando TX_SUCCESS
+    SINCRONISMO_AGUARDA_TIME, // TIME na fila, esperando TX_SUCCESS
+} estado_sincronismo_t;
+
+typedef struct {
+    TickType_t periodo;
+    estado_sincronismo_t estado;
+    uint8_t contador;
+    TickType_t ultimo_sync;
+    TickType_t enviado_em;
+    SemaphoreHandle_t trava; // Serializa o laço principal e a tarefa de alertas
+
+    uint32_t ciclos;   // Pares SYNC/TIME concluídos
+    uint32_t falhas;   // Transmissões que falharam ou não terminaram em um período
+    uint32_t adiados;  // SYNCs adiados porque havia outro quadro na fila de TX
+} sincronismo_mestre_t;
+
+void sincronismo_inicializa(sincronismo_mestre_t *mestre, uint32_t periodo_ms);
+
+// Envia o SYNC quando o período vence e não há outro quadro na fila de TX.
+// O TX_SUCCESS de um quadro anterior precisa já ter sido tratado (com o
+// mestre ocioso ele é ignorado): quem lê os alertas roda acima de quem
+// chama esta função, no mesmo núcleo da ISR do TWAI.
+void sincronismo_processa(sincronismo_mestre_t *mestre, TickType_t agora);
+
+// Trata TX_SUCCESS/TX_FAILED. instante_us é o momento em que o alerta foi
+// lido, usado como instante de transmissão do SYNC; deve ser tomado logo
+// após twai_read_alerts retornar.
+void sincronismo_trata_alertas(sincronismo_mestre_t *mestre, uint32_t alertas, int64_t instante_us);
+
+// Outros quadros só podem ser transmitidos com o mestre ocioso
+bool sincronismo_ocioso(const sincronismo_mestre_t *mestre);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* SINCRONISMO_H_ */
@@ -0,0 +1,218 @@
+#include <string.h>
+#include "tabela_nos.h"
+
+// Duração de um slot da roda em ticks (no mínimo 1 tick)
+#define RODA_RESOLUCAO_TICKS (pdMS_TO_TICKS(NOS_RODA_RESOLUCAO_MS) > 0 ? pdMS_TO_TICKS(NOS_RODA_RESOLUCAO_MS) : 1)
+
+static inline uint8_t slot_do_instante(TickType_t instante) {
+    return (uint8_t)((instante / RODA_RESOLUCAO_TICKS) % NOS_RODA_SLOTS);
+}
+
+static void roda_remove(tabela_nos_t *tabela, uint8_t indice) {
+    no_sensor_t *no = &tabela->nos[indice];
+
+    if (no->anterior != NO_INDICE_INVALIDO) {
+        tabela->nos[no->anterior].proximo = no->proximo;
+    } else {
+        tabela->roda[no->slot] = no->proximo;
+    }
+
+    if (no->proximo != NO_INDICE_INVALIDO) {
+        tabela->nos[no->proximo].anterior = no->anterior;
+    }
+
+    no->anterior = NO_INDICE_INVALIDO;
+    no->proximo = NO_INDICE_INVALIDO;
+    no->slot = NO_INDICE_INVALIDO;
+}
+
+static void roda_insere(tabela_nos_t *tabela, uint8_t indice, TickType_t expira_em) {
+    no_sensor_t *no = &tabela->nos[indice];
+    uint8_t slot = slot_do_instante(expira_em);
+
+    no->expira_em = expira_em;
+    no->slot = slot;
+    no->anterior = NO_INDICE_INVALIDO;
+    no->proximo = tabela->roda[slot];
+
+    if (no->proximo != NO_INDICE_INVALIDO) {
+        tabela->nos[no->proximo].anterior = indice;
+    }
+    tabela->roda[slot] = indice;
+}
+
+void tabela_nos_inicializa(tabela_nos_t *tabela, uint32_t timeout_ms, politica_agregacao_t politica,
+                           uint32_t id_base, uint32_t id_quantidade) {
+    memset(tabela->indice_por_id, NO_INDICE_INVALIDO, sizeof(tabela->indice_por_id));
+    memset(tabela->roda, NO_INDICE_INVALIDO, sizeof(tabela->roda));
+    memset(tabela->nos, 0, sizeof(tabela->nos));
+
+    tabela->total_nos = 0;
+    tabela->nos_ativos = 0;
+    tabela->timeout = pdMS_TO_TICKS(timeout_ms);
+    tabela->roda_cursor = xTaskGetTickCount();
+    tabela->politica = politica;
+    tabela->id_base = id_base;
+    tabela->id_quantidade = id_quantidade;
+    tabela->ultimo_no = NO_INDICE_INVALIDO;
+    tabela->descartados = 0;
+
+    // O timeout precisa caber numa volta da roda
+    configASSERT(tabela->timeout < (TickType_t)(NOS_RODA_SLOTS * RODA_RESOLUCAO_TICKS));
+}
+
+void tabela_nos_atualiza(tabela_nos_t *tabela, const twai_message_t *message, TickType_t agora) {
+    uint32_t id = message->identifier & TWAI_STD_ID_MASK;
+
+    // Heartbeats, quadros empacotados e SYNC/TIME também são quadros padrão:
+    // só a faixa dos sensores, com o formato de leitura, vira nó
+    if (message->extd || message->rtr || id - tabela->id_base >= tabela->id_quantidade ||
+        message->data_length_code < NO_DLC_LEITURA || message->data[0] < NO_STATUS_OK ||
+        message->data[0] > NO_STATUS_INVALIDO) {
+        tabela->descartados++;
+        return;
+    }
+
+    uint8_t indice = tabela->indice_por_id[id];
+
+    if (indice == NO_INDICE_INVALIDO) {
+        if (tabela->total_nos >= NOS_MAX) {
+            tabela->descartados++;
+            return;
+        }
+
+        indice = tabela->total_nos++;
+        tabela->indice_por_id[id] = indice;
+
+        no_sensor_t *novo = &tabela->nos[indice];
+        novo->id = id;
+        novo->slot = NO_INDICE_INVALIDO;
+        novo->anterior = NO_INDICE_INVALIDO;
+        novo->proximo = NO_INDICE_INVALIDO;
+    }
+
+    no_sensor_t *no = &tabela->nos[indice];
+
+    float distancia;
+    no->status = message->data[0];
+    memcpy(&distancia, &message->data[1], sizeof(float));
+
+    // Leituras que falharam trazem distância negativa: o nó mantém a
+    // última válida, ou fica fora da agregação se ainda não tem nenhuma
+    if (no->status != NO_STATUS_INVALIDO && distancia >= 0) {
+        no->distancia = distancia;
+        no->tem_distancia = true;
+    }
+
+    if (message->data_length_code >= 6) {
+        uint8_t sequencia = message->data[5];
+        if (no->tem_sequencia && no->ativo) {
+            // Diferença módulo 256; 1 significa nenhum quadro perdido
+            uint8_t salto = (uint8_t)(sequencia - no->sequencia);
+            if (salto > 1) {
+                no->lacunas += salto - 1;
+            }
+        }
+        no->sequencia = sequencia;
+        no->tem_sequencia = true;
+    }
+
+    no->recebidos++;
+    no->ultima_mensagem = agora;
+
+    if (!no->ativo) {
+        no->ativo = true;
+        tabela->nos_ativos++;
+    }
+
+    // Reagenda o timeout do nó: remoção e inserção O(1) na roda
+    if (no->slot != NO_INDICE_INVALIDO) {
+        roda_remove(tabela, indice);
+    }
+    roda_insere(tabela, indice, agora + tabela->timeout);
+
+    tabela->ultimo_no = indice;
+}
+
+uint32_t tabela_nos_avanca(tabela_nos_t *tabela, TickType_t agora) {
+    uint32_t expirados = 0;
+    uint32_t slots_visitados = 0;
+
+    // Um slot só é processado quando todo o seu intervalo já passou
+    while ((int32_t)(agora - (tabela->roda_cursor + RODA_RESOLUCAO_TICKS - 1)) >= 0) {
+        uint8_t slot = slot_do_instante(tabela->roda_cursor);
+        uint8_t indice = tabela->roda[slot];
+
+        while (indice != NO_INDICE_INVALIDO) {
+            no_sensor_t *no = &tabela->nos[indice];
+            uint8_t proximo = no->proximo;
+
+            // Nós agendados para uma volta futura da roda permanecem no slot
+            if ((int32_t)(agora - no->expira_em) >= 0) {
+                roda_remove(tabela, indice);
+                no->ativo = false;
+                tabela->nos_ativos--;
+                expirados++;
+            }
+
+            indice = proximo;
+        }
+
+        tabela->roda_cursor += RODA_RESOLUCAO_TICKS;
+
+        // Depois de uma volta completa todos os slots já foram vistos
+        if (++slots_visitados >= NOS_RODA_SLOTS) {
+            tabela->roda_cursor = agora - (agora % RODA_RESOLUCAO_TICKS);
+            break;
+        }
+    }
+
+    return expirados;
+}
+
+static inline bool no_agregavel(const no_sensor_t *no) {
+    return no->ativo && no->tem_distancia;
+}
+
+bool tabela_nos_agrega(const tabela_nos_t *tabela, float *distancia) {
+    if (tabela->nos_ativos == 0) {
+        return false;
+    }
+
+    switch (tabela->politica) {
+        case AGREGACAO_MAIS_RECENTE:
+            if (tabela->ultimo_no == NO_INDICE_INVALIDO || !no_agregavel(&tabela->nos[tabela->ultimo_no])) {
+                return false;
+            }
+            *distancia = tabela->nos[tabela->ultimo_no].distancia;
+            return true;
+
+        case AGREGACAO_MEDIA: {
+            float soma = 0;
+            uint32_t validos = 0;
+            for (uint8_t i = 0; i < tabela->total_nos; i++) {
+                if (no_agregavel(&tabela->nos[i])) {
+                    soma += tabela->nos[i].distancia;
+                    validos++;
+                }
+            }
+            if (validos == 0) {
+                return false;
+            }
+            *distancia = soma / validos;
+            return true;
+        }
+
+        case AGREGACAO_MAIS_PROXIMO:
+        default: {
+            bool encontrou = false;
+            for (uint8_t i = 0; i < tabela->total_nos; i++) {
+                if (no_agregavel(&tabela->nos[i]) && (!encontrou || tabela->nos[i].distancia < *distancia)) {
+                    *distancia = tabela->nos[i].distancia;
+                    encontrou = true;
+                }
+            }
+            return encontrou;
+        }
+    }
+}
@@ -0,0 +1,95 @@
+#ifndef TABELA_NOS_H_
+#define TABELA_NOS_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "freertos/FreeRTOS.h"
+#include "driver/twai.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Máximo de sensores acompanhados ao mesmo tempo
+#define NOS_MAX 64
+
+// Resolução e tamanho da roda de temporização. A roda precisa cobrir o
+// maior timeout configurado: NOS_RODA_SLOTS * NOS_RODA_RESOLUCAO_MS.
+#define NOS_RODA_RESOLUCAO_MS 10
+#define NOS_RODA_SLOTS 128
+
+#define NO_INDICE_INVALIDO 0xFF
+
+// Byte de status de uma leitura, como o transmissor envia
+#define NO_STATUS_OK            0x01
+#define NO_STATUS_FORA_DE_FAIXA 0x02 // Distância acima do alcance
+#define NO_STATUS_INVALIDO      0x03 // Timeout ou erro do sensor; distância negativa
+
+// Quadro de leitura: status (1 byte) + distância float (4 bytes)
+#define NO_DLC_LEITURA 5
+
+// Política que decide qual valor controla o LED
+typedef enum {
+    AGREGACAO_MAIS_PROXIMO = 0, // Obstáculo mais próximo entre os nós ativos
+    AGREGACAO_MEDIA,            // Média das distâncias dos nós ativos
+    AGREGACAO_MAIS_RECENTE,     // Último quadro recebido de qualquer nó
+} politica_agregacao_t;
+
+typedef struct {
+    uint32_t id;             // Identificador CAN (11 bits)
+    float distancia;         // Última distância recebida (cm)
+    uint8_t status;          // Byte de status do último quadro
+    uint8_t sequencia;       // Último contador de sequência recebido
+    bool tem_sequencia;      // Quadro traz contador de sequência (DLC >= 6)
+    bool tem_distancia;      // Já recebeu ao menos uma distância válida
+    bool ativo;              // Recebeu mensagem dentro do timeout
+    uint32_t recebidos;      // Quadros recebidos deste nó
+    uint32_t lacunas;        // Quadros perdidos detectados pela sequência
+    TickType_t ultima_mensagem;
+
+    // Encadeamento na roda de temporização
+    TickType_t expira_em;
+    uint8_t slot;
+    uint8_t anterior;
+    uint8_t proximo;
+} no_sensor_t;
+
+typedef struct {
+    // Índice direto ID -> posição em nos[]; busca O(1)
+    uint8_t indice_por_id[TWAI_STD_ID_MASK + 1];
+    no_sensor_t nos[NOS_MAX];
+    uint8_t total_nos;
+    uint8_t nos_ativos;
+
+    // Roda de temporização: uma lista de nós por slot
+    uint8_t roda[NOS_RODA_SLOTS];
+    TickType_t roda_cursor;
+    TickType_t timeout;
+
+    politica_agregacao_t politica;
+    uint32_t id_base;     // Faixa de IDs aceita como sensor
+    uint32_t id_quantidade;
+    uint8_t ultimo_no;
+    uint32_t descartados; // Quadros ignorados (fora da faixa, formato inválido ou tabela cheia)
+} tabela_nos_t;
+
+// Só quadros de dados com ID em [id_base, id_base + id_quantidade) viram nós
+void tabela_nos_inicializa(tabela_nos_t *tabela, uint32_t timeout_ms, politica_agregacao_t politica,
+                           uint32_t id_base, uint32_t id_quantidade);
+
+// Registra um quadro recebido. Custo constante, independe do número de nós.
+void tabela_nos_atualiza(tabela_nos_t *tabela, const twai_message_t *message, TickType_t agora);
+
+// Avança a roda até 'agora' e desativa os nós que ficaram em silêncio.
+// Retorna o número de nós que expiraram nesta chamada.
+uint32_t tabela_nos_avanca(tabela_nos_t *tabela, TickType_t agora);
+
+// Aplica a política de agregação sobre os nós ativos com distância válida.
+// Retorna false se nenhum deles tiver.
+bool tabela_nos_agrega(const tabela_nos_t *tabela, float *distancia);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* TABELA_NOS_H_ */
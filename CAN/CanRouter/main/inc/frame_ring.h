@@ -0,0 +1,67 @@
+#ifndef _FRAME_RING_H_
+#define _FRAME_RING_H_
+
+#include <stdint.h>
+#include <atomic>
+
+#include "can.h"
+
+struct RouterSlot {
+    struct can_frame frame;
+    int64_t rx_us; // Instante em que o quadro saiu do controlador de origem
+};
+
+/*
+ * Anel de quadros entre uma tarefa produtora e uma consumidora. Os
+ * controladores leem e escrevem direto nos slots, sem cópias
+ * intermediárias, e os índices só são publicados uma vez por lote.
+ */
+template <uint32_t N>
+class FrameRing
+{
+    static_assert(N >= 2 && (N & (N - 1)) == 0, "O tamanho do anel precisa ser potência de 2");
+
+    public:
+        FrameRing() : head(0), tail(0), writePos(0) {}
+
+        // Produtor: próximo slot livre, ou NULL com o anel cheio
+        RouterSlot *beginWrite(void)
+        {
+            if (writePos - tail.load(std::memory_order_acquire) >= N) {
+                return NULL;
+            }
+            return &slots[writePos & (N - 1)];
+        }
+
+        // Produtor: o slot de beginWrite() entra no lote corrente
+        void commitWrite(void) { writePos++; }
+
+        // Produtor: torna o lote visível ao consumidor
+        void publish(void) { head.store(writePos, std::memory_order_release); }
+
+        // Consumidor: quadros publicados e ainda não liberados
+        uint32_t readable(void) const
+        {
+            return head.load(std::memory_order_acquire) - tail.load(std::memory_order_relaxed);
+        }
+
+        // Consumidor: i-ésimo quadro disponível, i < readable()
+        RouterSlot *readSlot(uint32_t i)
+        {
+            return &slots[(tail.load(std::memory_order_relaxed) + i) & (N - 1)];
+        }
+
+        // Consumidor: devolve os n primeiros slots ao produtor
+        void release(uint32_t n)
+        {
+            tail.store(tail.load(std::memory_order_relaxed) + n, std::memory_order_release);
+        }
+
+    private:
+        RouterSlot slots[N];
+        std::atomic<uint32_t> head;
+        std::atomic<uint32_t> tail;
+        uint32_t writePos; // Só o produtor acessa
+};
+
+#endif
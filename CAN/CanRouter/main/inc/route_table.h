@@ -0,0 +1,99 @@
+#ifndef _ROUTE_TABLE_H_
+#define _ROUTE_TABLE_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "can.h"
+
+// Sentido do encaminhamento. Cada sentido tem sua própria tabela.
+enum RouterDirection {
+    DIR_MCP_TO_TWAI = 0,
+    DIR_TWAI_TO_MCP = 1,
+    DIR_COUNT
+};
+
+// Sentidos a que uma regra se aplica
+#define ROUTE_DIR_MCP_TO_TWAI (1 << DIR_MCP_TO_TWAI)
+#define ROUTE_DIR_TWAI_TO_MCP (1 << DIR_TWAI_TO_MCP)
+#define ROUTE_DIR_BOTH        (ROUTE_DIR_MCP_TO_TWAI | ROUTE_DIR_TWAI_TO_MCP)
+
+enum RouteAction {
+    ROUTE_PASS = 0,
+    ROUTE_DROP,
+    ROUTE_REMAP,      // Encaminha com ID = remap_base + (id - id_first)
+    ROUTE_RATE_LIMIT  // Encaminha até rate_per_s quadros/s, com rajadas de até burst
+};
+
+// Regra sobre uma faixa de IDs padrão (11 bits). Com faixas sobrepostas
+// vale a primeira regra da lista.
+struct RouteRule {
+    uint8_t     directions;
+    uint16_t    id_first;
+    uint16_t    id_last;
+    RouteAction action;
+    uint16_t    remap_base;
+    uint16_t    rate_per_s;
+    uint16_t    burst;
+};
+
+// Regras do roteador, em route_rules.cpp
+extern const RouteRule ROUTE_RULES[];
+extern const size_t ROUTE_RULE_COUNT;
+
+enum RouteVerdict {
+    VERDICT_FORWARD = 0,
+    VERDICT_REMAPPED,
+    VERDICT_DROPPED,
+    VERDICT_LIMITED
+};
+
+// Limite de regras de taxa; cada uma tem um balde por sentido
+#define ROUTE_MAX_LIMITERS 32
+
+#define ROUTE_STD_IDS (CAN_SFF_MASK + 1)
+
+/*
+ * Regras compiladas numa tabela de 2048 entradas por sentido, indexada
+ * pelo ID padrão. Cada quadro custa um acesso à tabela, independente do
+ * número de regras. IDs estendidos recebem a ação padrão.
+ */
+class RouteTable
+{
+    public:
+        RouteTable();
+
+        // Retorna false se alguma regra for inválida (a tabela fica com a ação padrão)
+        bool compile(const RouteRule *rules, size_t count, RouteAction default_action);
+
+        // Aplica a regra ao quadro, trocando o ID se for remapeado.
+        // Cada sentido deve ser roteado sempre pela mesma tarefa.
+        RouteVerdict route(RouterDirection dir, struct can_frame *frame, int64_t now_us);
+
+        // Quantos IDs padrão recebem cada ação no sentido dado
+        void countActions(RouterDirection dir, uint32_t counts[4]) const;
+
+    private:
+        struct Entry {
+            uint8_t  action;
+            uint8_t  limiter;  // Índice do balde em ROUTE_RATE_LIMIT
+            uint16_t id;       // Novo ID em ROUTE_REMAP
+        };
+
+        // Balde de fichas em microssegundos de crédito: cada quadro custa
+        // cost_us e o crédito acumulado é limitado a burst * cost_us.
+        struct Limiter {
+            int64_t  credit_us;
+            int64_t  last_us;
+            uint32_t cost_us;
+            int64_t  capacity_us; // Até 1 s * 65535 quadros: não cabe em 32 bits
+        };
+
+        Entry lut[DIR_COUNT][ROUTE_STD_IDS];
+        Limiter limiters[DIR_COUNT][ROUTE_MAX_LIMITERS];
+        uint8_t defaultAction;
+
+        bool take(Limiter *l, int64_t now_us);
+};
+
+#endif
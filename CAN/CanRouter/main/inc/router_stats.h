@@ -0,0 +1,42 @@
+#ifndef _ROUTER_STATS_H_
+#define _ROUTER_STATS_H_
+
+#include <stdint.h>
+
+// Histograma de latência: faixas de LATENCY_BUCKET_US, a última acumula o excesso
+#define LATENCY_BUCKET_US 25
+#define LATENCY_BUCKETS   80
+
+// Contadores de um sentido. Os de recepção são escritos só pela tarefa que
+// lê a origem e os de transmissão só pela que escreve no destino; o
+// relatório lê tudo sem travar, comparando com a amostra anterior. A
+// única exceção é latency_window, escrito só pelo relatório para fechar a
+// janela do máximo.
+struct RouterDirStats {
+    // Recepção
+    uint32_t received;
+    uint32_t remapped;
+    uint32_t dropped;     // Por regra
+    uint32_t limited;     // Acima da taxa da regra
+    uint32_t overflow;    // Anel cheio ou estouro no controlador de origem
+    uint32_t batches;
+
+    // Transmissão
+    uint32_t forwarded;
+    uint32_t tx_failed;
+    uint32_t tx_aborted;         // Sem confirmação do destino no prazo
+    // Latência do recebimento até a saída: no MCP2515 até o TX0IF, no
+    // TWAI até o driver aceitar o quadro na fila de transmissão
+    uint32_t latency_max_us;     // Máximo da janela latency_max_window
+    uint32_t latency_max_window;
+    uint32_t latency_window;     // Janela de relatório atual
+    uint32_t latency_hist[LATENCY_BUCKETS];
+};
+
+void router_stats_record_latency(RouterDirStats *stats, uint32_t latency_us);
+
+// Imprime o intervalo desde 'prev', atualiza 'prev' com 'now' e abre uma
+// nova janela para o máximo de latência
+void router_stats_report(const char *name, RouterDirStats *now, RouterDirStats *prev, int64_t interval_us);
+
+#endif
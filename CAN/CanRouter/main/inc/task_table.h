@@ -0,0 +1,19 @@
+#ifndef _TASK_TABLE_H_
+#define _TASK_TABLE_H_
+
+#include <stddef.h>
+
+#include "task_layout.h"
+
+// Entradas da tabela de tarefas
+#define TASK_MCP        "mcp_task"
+#define TASK_TWAI_TX    "twai_tx"
+#define TASK_TWAI_RX    "twai_rx"
+#define TASK_SUPERVISOR "supervisor"
+#define TASK_LOG        "log"
+#define TASK_MONITOR    "monitor"
+
+extern const task_layout_entry_t TASK_TABLE[];
+extern const size_t TASK_TABLE_COUNT;
+
+#endif
@@ -0,0 +1,417 @@
+#include <stdio.h>
+#include <string.h>
+#include "driver/spi_master.h"
+#include "driver/gpio.h"
+#include "driver/twai.h"
+#include "esp_err.h"
+#include "esp_log.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "esp_timer.h"
+
+#include "sdkconfig.h"
+#include "mcp2515.h"
+#include "frame_ring.h"
+#include "route_table.h"
+#include "router_stats.h"
+#include "task_table.h"
+
+#define TAG "CAN_ROUTER"
+
+// Configuração SPI (VSPI), igual ao CanTransmitter
+#define PIN_NUM_MISO 19
+#define PIN_NUM_MOSI 23
+#define PIN_NUM_CLK  18
+#define PIN_NUM_CS    5
+
+// Fila curta no driver TWAI: a espera fica no anel, onde a latência é medida
+#define TWAI_TX_QUEUE_LEN 4
+#define TWAI_RX_QUEUE_LEN 32
+#define TWAI_TX_TIMEOUT_MS 100
+
+// Bits de notificação da tarefa do MCP2515
+#define NOTIFY_MCP_INT  (1 << 0) // Borda de descida no INT
+#define NOTIFY_TO_MCP   (1 << 1) // Lote novo no anel TWAI -> MCP2515
+
+// Rede de segurança caso uma borda do INT se perca
+#define MCP_IDLE_TICKS pdMS_TO_TICKS(10)
+
+// Prazo para o TXB0 confirmar o quadro (TX0IF). Sem ACK, em bus-off ou
+// perdendo sempre a arbitragem o quadro é abortado e descartado.
+#define MCP_TX_TIMEOUT_MS 100
+
+// Buffer da saída do log, esvaziado pela tarefa de log no núcleo de manutenção
+#define LOG_BUFFER_BYTES 4096
+
+#if CONFIG_ROUTER_DEFAULT_DROP
+#define ROUTER_DEFAULT_ACTION ROUTE_DROP
+#else
+#define ROUTER_DEFAULT_ACTION ROUTE_PASS
+#endif
+
+spi_device_handle_t spi_handle;
+
+static MCP2515<> *mcp;
+static RouteTable routes;
+static FrameRing<CONFIG_ROUTER_RING_SIZE> to_twai;
+static FrameRing<CONFIG_ROUTER_RING_SIZE> to_mcp;
+static RouterDirStats stats[DIR_COUNT];
+
+static TaskHandle_t mcp_task_handle;
+static TaskHandle_t twai_tx_task_handle;
+
+static const char *const DIR_NAMES[DIR_COUNT] = {"MCP2515 -> TWAI", "TWAI -> MCP2515"};
+
+static void IRAM_ATTR mcp2515_int_isr(void *arg) {
+    BaseType_t woken = pdFALSE;
+    xTaskNotifyFromISR(mcp_task_handle, NOTIFY_MCP_INT, eSetBits, &woken);
+    portYIELD_FROM_ISR(woken);
+}
+
+// Aplica a regra a um quadro já no slot. Retorna true se ele deve seguir.
+static bool ingest(RouterDirection dir, RouterSlot *slot) {
+    RouterDirStats *s = &stats[dir];
+    s->received++;
+
+    switch (routes.route(dir, &slot->frame, slot->rx_us)) {
+        case VERDICT_REMAPPED:
+            s->remapped++;
+            return true;
+        case VERDICT_DROPPED:
+            s->dropped++;
+            return false;
+        case VERDICT_LIMITED:
+            s->limited++;
+            return false;
+        default:
+            return true;
+    }
+}
+
+static void twai_to_frame(const twai_message_t *msg, struct can_frame *frame) {
+    frame->can_id = msg->identifier;
+    if (msg->extd) {
+        frame->can_id |= CAN_EFF_FLAG;
+    }
+    if (msg->rtr) {
+        frame->can_id |= CAN_RTR_FLAG;
+    }
+    frame->can_dlc = msg->data_length_code > CAN_MAX_DLEN ? CAN_MAX_DLEN : msg->data_length_code;
+    memcpy(frame->data, msg->data, frame->can_dlc);
+}
+
+static void frame_to_twai(const struct can_frame *frame, twai_message_t *msg) {
+    memset(msg, 0, sizeof(twai_message_t));
+    msg->extd = (frame->can_id & CAN_EFF_FLAG) ? 1 : 0;
+    msg->rtr = (frame->can_id & CAN_RTR_FLAG) ? 1 : 0;
+    msg->identifier = frame->can_id & (msg->extd ? CAN_EFF_MASK : CAN_SFF_MASK);
+    msg->data_length_code = frame->can_dlc;
+    memcpy(msg->data, frame->data, frame->can_dlc);
+}
+
+// Lê até um lote do MCP2515 direto nos slots do anel MCP2515 -> TWAI
+static void mcp_drain_rx(void) {
+    RouterDirStats *s = &stats[DIR_MCP_TO_TWAI];
+    uint32_t queued = 0;
+    struct can_frame discard;
+
+    for (uint32_t n = 0; n < CONFIG_ROUTER_BATCH_SIZE; n++) {
+        RouterSlot *slot = to_twai.beginWrite();
+        if (slot == NULL) {
+            // Anel cheio: o quadro precisa sair do controlador mesmo assim
+            if (mcp->readMessage(&discard) != MCP2515<>::ERROR_OK) {
+                break;
+            }
+            s->received++;
+            s->overflow++;
+            continue;
+        }
+
+        if (mcp->readMessage(&slot->frame) != MCP2515<>::ERROR_OK) {
+            break;
+        }
+        slot->rx_us = esp_timer_get_time();
+
+        if (ingest(DIR_MCP_TO_TWAI, slot)) {
+            to_twai.commitWrite();
+            queued++;
+        }
+    }
+
+    if (queued > 0) {
+        to_twai.publish();
+        s->batches++;
+        xTaskNotifyGive(twai_tx_task_handle);
+    }
+}
+
+// Um quadro por vez no TXB0, como o driver mcp251x do Linux: com vários
+// buffers de mesma prioridade o MCP2515 pode inverter a ordem dos quadros.
+// O slot fica na cabeça do anel até o TX0IF, quando a latência é medida.
+static bool mcp_send_next(void) {
+    RouterDirStats *s = &stats[DIR_TWAI_TO_MCP];
+
+    while (to_mcp.readable() > 0) {
+        RouterSlot *slot = to_mcp.readSlot(0);
+
+        // Único erro permanente: um quadro que nunca caberia no buffer
+        if (slot->frame.can_dlc > CAN_MAX_DLEN) {
+            to_mcp.release(1);
+            s->tx_failed++;
+            continue;
+        }
+
+        // ERROR_FAILTX vem com o TXREQ já ativo: o controlador repete sozinho
+        // e o desfecho chega pelo TX0IF ou pelo prazo. Qualquer outra falha
+        // deixa o quadro no anel para a próxima passada.
+        MCP2515<>::ERROR err = mcp->sendMessage(MCP2515<>::TXB0, &slot->frame);
+        return err == MCP2515<>::ERROR_OK || err == MCP2515<>::ERROR_FAILTX;
+    }
+    return false;
+}
+
+// TX0IF: o quadro na cabeça do anel saiu
+static void mcp_send_done(void) {
+    RouterDirStats *s = &stats[DIR_TWAI_TO_MCP];
+
+    if (to_mcp.readable() > 0) {
+        RouterSlot *slot = to_mcp.readSlot(0);
+        s->forwarded++;
+        router_stats_record_latency(s, (uint32_t)(esp_timer_get_time() - slot->rx_us));
+        to_mcp.release(1);
+    }
+}
+
+// Dono do MCP2515: recebe, transmite e limpa os flags. Só esta tarefa usa o SPI.
+static void mcp_task(void *arg) {
+    bool tx_busy = false;
+    int64_t tx_loaded_us = 0;
+
+    while (1) {
+        xTaskNotifyWait(0, UINT32_MAX, NULL, MCP_IDLE_TICKS);
+
+        // O INT só gera nova borda depois que todos os flags forem limpos
+        do {
+            uint8_t intf = mcp->getInterrupts();
+
+            if (intf & (MCP2515<>::CANINTF_RX0IF | MCP2515<>::CANINTF_RX1IF)) {
+                mcp_drain_rx();
+            }
+
+            if (intf & MCP2515<>::CANINTF_TX0IF) {
+                mcp->clearTXInterrupts();
+                if (tx_busy) {
+                    mcp_send_done();
+                }
+                tx_busy = false;
+            }
+
+            if (intf & (MCP2515<>::CANINTF_ERRIF | MCP2515<>::CANINTF_MERRF)) {
+                if (mcp->getErrorFlags() & (MCP2515<>::EFLG_RX0OVR | MCP2515<>::EFLG_RX1OVR)) {
+                    stats[DIR_MCP_TO_TWAI].overflow++;
+                }
+                mcp->clearRXnOVR();
+                mcp->clearMERR();
+                mcp->clearERRIF();
+            }
+
+            // TXB0 preso: sem isso o sentido TWAI -> MCP2515 pararia de vez
+            if (tx_busy && esp_timer_get_time() - tx_loaded_us > MCP_TX_TIMEOUT_MS * 1000LL &&
+                mcp->abortTransmission(MCP2515<>::TXB0) == MCP2515<>::ERROR_OK) {
+                // Um TX0IF que tenha corrido com o abort é descartado junto
+                mcp->clearTXInterrupts();
+                to_mcp.release(1);
+                stats[DIR_TWAI_TO_MCP].tx_aborted++;
+                tx_busy = false;
+            }
+
+            if (!tx_busy) {
+                tx_busy = mcp_send_next();
+                tx_loaded_us = esp_timer_get_time();
+            }
+        } while (gpio_get_level((gpio_num_t)CONFIG_ROUTER_MCP_INT_GPIO) == 0);
+    }
+}
+
+// Lê o TWAI em lotes direto nos slots do anel TWAI -> MCP2515
+static void twai_rx_task(void *arg) {
+    RouterDirStats *s = &stats[DIR_TWAI_TO_MCP];
+    twai_message_t msg;
+
+    while (1) {
+        esp_err_t err = twai_receive(&msg, portMAX_DELAY);
+        if (err != ESP_OK) {
+            // Driver parado (bus-off): espera a recuperação
+            vTaskDelay(1);
+            continue;
+        }
+
+        uint32_t queued = 0;
+        uint32_t n = 0;
+        do {
+            RouterSlot *slot = to_mcp.beginWrite();
+            if (slot == NULL) {
+                s->received++;
+                s->overflow++;
+                continue;
+            }
+
+            twai_to_frame(&msg, &slot->frame);
+            slot->rx_us = esp_timer_get_time();
+
+            if (ingest(DIR_TWAI_TO_MCP, slot)) {
+                to_mcp.commitWrite();
+                queued++;
+            }
+        } while (++n < CONFIG_ROUTER_BATCH_SIZE && twai_receive(&msg, 0) == ESP_OK);
+
+        if (queued > 0) {
+            to_mcp.publish();
+            s->batches++;
+            xTaskNotify(mcp_task_handle, NOTIFY_TO_MCP, eSetBits);
+        }
+    }
+}
+
+// Esvazia o anel MCP2515 -> TWAI, liberando os slots lote a lote
+static void twai_tx_task(void *arg) {
+    RouterDirStats *s = &stats[DIR_MCP_TO_TWAI];
+    twai_message_t msg;
+
+    while (1) {
+        ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+
+        uint32_t n;
+        while ((n = to_twai.readable()) > 0) {
+            for (uint32_t i = 0; i < n; i++) {
+                RouterSlot *slot = to_twai.readSlot(i);
+                frame_to_twai(&slot->frame, &msg);
+
+                if (twai_transmit(&msg, pdMS_TO_TICKS(TWAI_TX_TIMEOUT_MS)) == ESP_OK) {
+                    s->forwarded++;
+                    router_stats_record_latency(s, (uint32_t)(esp_timer_get_time() - slot->rx_us));
+                } else {
+                    s->tx_failed++;
+                }
+            }
+            to_twai.release(n);
+        }
+    }
+}
+
+static void log_route_table(void) {
+    static const char *const ACTION_NAMES[] = {"encaminha", "descarta", "remapeia", "limita"};
+
+    for (int d = 0; d < DIR_COUNT; d++) {
+        uint32_t counts[4];
+        routes.countActions((RouterDirection)d, counts);
+        ESP_LOGI(TAG, "%s: %lu IDs %s, %lu %s, %lu %s, %lu %s", DIR_NAMES[d],
+                 (unsigned long)counts[ROUTE_PASS], ACTION_NAMES[ROUTE_PASS],
+                 (unsigned long)counts[ROUTE_DROP], ACTION_NAMES[ROUTE_DROP],
+                 (unsigned long)counts[ROUTE_REMAP], ACTION_NAMES[ROUTE_REMAP],
+                 (unsigned long)counts[ROUTE_RATE_LIMIT], ACTION_NAMES[ROUTE_RATE_LIMIT]);
+    }
+}
+
+// Recupera o TWAI e imprime os relatórios, fora do núcleo do caminho de dados
+static void supervisor_task(void *arg) {
+    RouterDirStats prev[DIR_COUNT];
+    memset(prev, 0, sizeof(prev));
+    int64_t last_report_us = esp_timer_get_time();
+    TickType_t last_wake = xTaskGetTickCount();
+
+    while (1) {
+        vTaskDelayUntil(&last_wake, task_layout_period(TASK_SUPERVISOR));
+
+        twai_status_info_t status;
+        if (twai_get_status_info(&status) == ESP_OK) {
+            if (status.state == TWAI_STATE_BUS_OFF) {
+                ESP_LOGW(TAG, "TWAI em bus-off, iniciando recuperação");
+                twai_initiate_recovery();
+            } else if (status.state == TWAI_STATE_STOPPED) {
+                twai_start();
+            }
+        }
+
+        int64_t now = esp_timer_get_time();
+        if (now - last_report_us >= (int64_t)CONFIG_ROUTER_REPORT_MS * 1000) {
+            for (int d = 0; d < DIR_COUNT; d++) {
+                router_stats_report(DIR_NAMES[d], &stats[d], &prev[d], now - last_report_us);
+            }
+            last_report_us = now;
+        }
+    }
+}
+
+extern "C" void app_main(void) {
+    ESP_ERROR_CHECK(task_layout_init(TASK_TABLE, TASK_TABLE_COUNT));
+    ESP_ERROR_CHECK(task_layout_defer_logging(TASK_LOG, LOG_BUFFER_BYTES));
+
+    if (!routes.compile(ROUTE_RULES, ROUTE_RULE_COUNT, ROUTER_DEFAULT_ACTION)) {
+        ESP_LOGE(TAG, "Tabela de rotas inválida");
+        while (1) { vTaskDelay(pdMS_TO_TICKS(1000)); }
+    }
+    log_route_table();
+
+    spi_bus_config_t bus_cfg = {};
+    bus_cfg.mosi_io_num = PIN_NUM_MOSI;
+    bus_cfg.miso_io_num = PIN_NUM_MISO;
+    bus_cfg.sclk_io_num = PIN_NUM_CLK;
+    bus_cfg.quadwp_io_num = -1;
+    bus_cfg.quadhd_io_num = -1;
+    ESP_ERROR_CHECK(spi_bus_initialize(SPI2_HOST, &bus_cfg, SPI_DMA_CH_AUTO));
+
+    spi_device_interface_config_t dev_cfg = {};
+    dev_cfg.mode = 0;
+    dev_cfg.clock_speed_hz = 10 * 1000 * 1000;
+    dev_cfg.spics_io_num = PIN_NUM_CS;
+    dev_cfg.queue_size = 7;
+    ESP_ERROR_CHECK(spi_bus_add_device(SPI2_HOST, &dev_cfg, &spi_handle));
+
+    static MCP2515<> mcp_can_controller(&spi_handle);
+    mcp = &mcp_can_controller;
+
+    ESP_LOGI(TAG, "Resetando MCP2515...");
+    if (mcp->reset() != MCP2515<>::ERROR_OK || mcp->setBitrate(CAN_500KBPS, MCP_8MHZ) != MCP2515<>::ERROR_OK) {
+        ESP_LOGE(TAG, "Falha ao configurar o MCP2515!");
+        while (1) { vTaskDelay(pdMS_TO_TICKS(1000)); }
+    }
+
+    // Fim de transmissão do TXB0 também acorda a tarefa
+    mcp->setInterruptMask(MCP2515<>::CANINTF_RX0IF | MCP2515<>::CANINTF_RX1IF | MCP2515<>::CANINTF_TX0IF |
+                          MCP2515<>::CANINTF_ERRIF | MCP2515<>::CANINTF_MERRF);
+
+    twai_general_config_t g_config = TWAI_GENERAL_CONFIG_DEFAULT((gpio_num_t)CONFIG_ROUTER_TWAI_TX_GPIO,
+                                                                 (gpio_num_t)CONFIG_ROUTER_TWAI_RX_GPIO,
+                                                                 TWAI_MODE_NORMAL);
+    g_config.tx_queue_len = TWAI_TX_QUEUE_LEN;
+    g_config.rx_queue_len = TWAI_RX_QUEUE_LEN;
+    twai_timing_config_t t_config = TWAI_TIMING_CONFIG_500KBITS();
+    twai_filter_config_t f_config = TWAI_FILTER_CONFIG_ACCEPT_ALL();
+    ESP_ERROR_CHECK(twai_driver_install(&g_config, &t_config, &f_config));
+    ESP_ERROR_CHECK(twai_start());
+
+    ESP_ERROR_CHECK(task_layout_create(TASK_MCP, mcp_task, NULL, &mcp_task_handle));
+    ESP_ERROR_CHECK(task_layout_create(TASK_TWAI_TX, twai_tx_task, NULL, &twai_tx_task_handle));
+    ESP_ERROR_CHECK(task_layout_create(TASK_TWAI_RX, twai_rx_task, NULL, NULL));
+
+    gpio_config_t io_conf_int = {};
+    io_conf_int.pin_bit_mask = (1ULL << CONFIG_ROUTER_MCP_INT_GPIO);
+    io_conf_int.mode = GPIO_MODE_INPUT;
+    io_conf_int.pull_up_en = GPIO_PULLUP_ENABLE;
+    io_conf_int.intr_type = GPIO_INTR_NEGEDGE;
+    gpio_config(&io_conf_int);
+    ESP_ERROR_CHECK(gpio_install_isr_service(0));
+    ESP_ERROR_CHECK(gpio_isr_handler_add((gpio_num_t)CONFIG_ROUTER_MCP_INT_GPIO, mcp2515_int_isr, NULL));
+
+    if (mcp->setNormalMode() != MCP2515<>::ERROR_OK) {
+        ESP_LOGE(TAG, "Falha ao configurar o modo normal do MCP2515");
+        while (1) { vTaskDelay(pdMS_TO_TICKS(1000)); }
+    }
+    xTaskNotify(mcp_task_handle, NOTIFY_MCP_INT, eSetBits);
+
+    ESP_LOGI(TAG, "Roteando entre MCP2515 e TWAI a 500 kbit/s");
+
+    ESP_ERROR_CHECK(task_layout_create(TASK_SUPERVISOR, supervisor_task, NULL, NULL));
+    ESP_ERROR_CHECK(task_layout_start_monitor(TASK_MONITOR));
+}
@@ -0,0 +1,19 @@
+#include "route_table.h"
+
+// Regras do roteador. A primeira regra que cobre um ID vale para ele;
+// IDs sem regra seguem a ação padrão do menuconfig.
+const RouteRule ROUTE_RULES[] = {
+    // O mestre do SYNC fica no segmento do TWAI; um SYNC vindo do outro lado não passa
+    { ROUTE_DIR_MCP_TO_TWAI, 0x080, 0x080, ROUTE_DROP,       0,     0,  0 },
+
+    // Leituras dos nós do segmento MCP2515 aparecem no outro como 0x500 + nó
+    { ROUTE_DIR_MCP_TO_TWAI, 0x120, 0x12F, ROUTE_REMAP,      0x520, 0,  0 },
+
+    // Heartbeats: no máximo 20 por segundo em cada sentido
+    { ROUTE_DIR_BOTH,        0x700, 0x77F, ROUTE_RATE_LIMIT, 0,     20, 10 },
+
+    // Diagnóstico fica no segmento de origem
+    { ROUTE_DIR_BOTH,        0x7E0, 0x7EF, ROUTE_DROP,       0,     0,  0 },
+};
+
+const size_t ROUTE_RULE_COUNT = sizeof(ROUTE_RULES) / sizeof(ROUTE_RULES[0]);
@@ -0,0 +1,120 @@
+#include <string.h>
+
+#include "esp_log.h"
+
+#include "route_table.h"
+
+#define TAG "ROUTE_TABLE"
+
+RouteTable::RouteTable()
+{
+    compile(NULL, 0, ROUTE_PASS);
+}
+
+bool RouteTable::compile(const RouteRule *rules, size_t count, RouteAction default_action)
+{
+    defaultAction = (uint8_t)default_action;
+    for (int d = 0; d < DIR_COUNT; d++) {
+        for (uint32_t id = 0; id < ROUTE_STD_IDS; id++) {
+            lut[d][id].action = defaultAction;
+            lut[d][id].limiter = 0;
+            lut[d][id].id = (uint16_t)id;
+        }
+    }
+    memset(limiters, 0, sizeof(limiters));
+
+    uint8_t n_limiters = 0;
+    for (size_t i = 0; i < count; i++) {
+        const RouteRule *r = &rules[i];
+        if (r->id_first > r->id_last || r->id_last > CAN_SFF_MASK ||
+            (r->action == ROUTE_REMAP && (uint32_t)(r->remap_base + r->id_last - r->id_first) > CAN_SFF_MASK) ||
+            (r->action == ROUTE_RATE_LIMIT && (r->rate_per_s == 0 || r->burst == 0))) {
+            ESP_LOGE(TAG, "Regra %u inválida (0x%03X-0x%03X)", (unsigned)i, r->id_first, r->id_last);
+            compile(NULL, 0, default_action);
+            return false;
+        }
+        if (r->action == ROUTE_RATE_LIMIT && n_limiters >= ROUTE_MAX_LIMITERS) {
+            ESP_LOGE(TAG, "Mais de %d regras de taxa", ROUTE_MAX_LIMITERS);
+            compile(NULL, 0, default_action);
+            return false;
+        }
+    }
+
+    // Aplica de trás para frente, para que a primeira regra da lista prevaleça
+    for (size_t i = count; i-- > 0; ) {
+        const RouteRule *r = &rules[i];
+        uint8_t limiter = 0;
+
+        if (r->action == ROUTE_RATE_LIMIT) {
+            limiter = n_limiters++;
+            for (int d = 0; d < DIR_COUNT; d++) {
+                Limiter *l = &limiters[d][limiter];
+                l->cost_us = 1000000 / r->rate_per_s;
+                l->capacity_us = (int64_t)l->cost_us * r->burst;
+                l->credit_us = l->capacity_us;
+            }
+        }
+
+        for (int d = 0; d < DIR_COUNT; d++) {
+            if (!(r->directions & (1 << d))) {
+                continue;
+            }
+            for (uint32_t id = r->id_first; id <= r->id_last; id++) {
+                Entry *e = &lut[d][id];
+                e->action = (uint8_t)r->action;
+                e->limiter = limiter;
+                e->id = r->action == ROUTE_REMAP ? (uint16_t)(r->remap_base + (id - r->id_first)) : (uint16_t)id;
+            }
+        }
+    }
+
+    return true;
+}
+
+bool RouteTable::take(Limiter *l, int64_t now_us)
+{
+    l->credit_us += now_us - l->last_us;
+    l->last_us = now_us;
+    if (l->credit_us > l->capacity_us) {
+        l->credit_us = l->capacity_us;
+    }
+
+    if (l->credit_us < l->cost_us) {
+        return false;
+    }
+    l->credit_us -= l->cost_us;
+    return true;
+}
+
+RouteVerdict RouteTable::route(RouterDirection dir, struct can_frame *frame, int64_t now_us)
+{
+    if (frame->can_id & CAN_EFF_FLAG) {
+        return defaultAction == ROUTE_DROP ? VERDICT_DROPPED : VERDICT_FORWARD;
+    }
+
+    const Entry *e = &lut[dir][frame->can_id & CAN_SFF_MASK];
+
+    switch (e->action) {
+        case ROUTE_DROP:
+            return VERDICT_DROPPED;
+
+        case ROUTE_REMAP:
+            // Mantém o bit de RTR
+            frame->can_id = (frame->can_id & ~CAN_SFF_MASK) | e->id;
+            return VERDICT_REMAPPED;
+
+        case ROUTE_RATE_LIMIT:
+            return take(&limiters[dir][e->limiter], now_us) ? VERDICT_FORWARD : VERDICT_LIMITED;
+
+        default:
+            return VERDICT_FORWARD;
+    }
+}
+
+void RouteTable::countActions(RouterDirection dir, uint32_t counts[4]) const
+{
+    memset(counts, 0, 4 * sizeof(uint32_t));
+    for (uint32_t id = 0; id < ROUTE_STD_IDS; id++) {
+        counts[lut[dir][id].action]++;
+    }
+}
@@ -0,0 +1,82 @@
+#include <string.h>
+
+#include "esp_log.h"
+
+#include "router_stats.h"
+
+#define TAG "ROUTER_STATS"
+
+void router_stats_record_latency(RouterDirStats *stats, uint32_t latency_us)
+{
+    uint32_t bucket = latency_us / LATENCY_BUCKET_US;
+    if (bucket >= LATENCY_BUCKETS) {
+        bucket = LATENCY_BUCKETS - 1;
+    }
+    stats->latency_hist[bucket]++;
+
+    // O relatório abriu outra janela: o máximo recomeça
+    uint32_t window = stats->latency_window;
+    if (stats->latency_max_window != window) {
+        stats->latency_max_window = window;
+        stats->latency_max_us = 0;
+    }
+    if (latency_us > stats->latency_max_us) {
+        stats->latency_max_us = latency_us;
+    }
+}
+
+// Limite superior da faixa que contém o percentil
+static uint32_t percentile(const uint32_t *hist, uint32_t total, uint32_t pct)
+{
+    if (total == 0) {
+        return 0;
+    }
+    uint32_t target = (uint32_t)(((uint64_t)total * pct + 99) / 100);
+    uint32_t seen = 0;
+    for (uint32_t i = 0; i < LATENCY_BUCKETS; i++) {
+        seen += hist[i];
+        if (seen >= target) {
+            return (i + 1) * LATENCY_BUCKET_US;
+        }
+    }
+    return LATENCY_BUCKETS * LATENCY_BUCKET_US;
+}
+
+void router_stats_report(const char *name, RouterDirStats *now, RouterDirStats *prev, int64_t interval_us)
+{
+    RouterDirStats snap;
+    memcpy(&snap, now, sizeof(RouterDirStats));
+    now->latency_window = snap.latency_window + 1;
+
+    // Sem latência registrada nesta janela, o máximo guardado é de outra
+    uint32_t latency_max = snap.latency_max_window == snap.latency_window ? snap.latency_max_us : 0;
+
+    uint32_t hist[LATENCY_BUCKETS];
+    uint32_t latency_total = 0;
+    for (uint32_t i = 0; i < LATENCY_BUCKETS; i++) {
+        hist[i] = snap.latency_hist[i] - prev->latency_hist[i];
+        latency_total += hist[i];
+    }
+
+    double seconds = interval_us > 0 ? interval_us / 1e6 : 1;
+    uint32_t received = snap.received - prev->received;
+    uint32_t batches = snap.batches - prev->batches;
+
+    ESP_LOGI(TAG, "%s | rx %6.0f q/s, enc %6.0f q/s | %.1f q/lote | remap %lu, regra %lu, taxa %lu, "
+             "estouro %lu, falha tx %lu, abortados %lu | latência p50 %lu p99 %lu us (máx %lu us)",
+             name,
+             received / seconds,
+             (snap.forwarded - prev->forwarded) / seconds,
+             batches > 0 ? (double)received / batches : 0.0,
+             (unsigned long)(snap.remapped - prev->remapped),
+             (unsigned long)(snap.dropped - prev->dropped),
+             (unsigned long)(snap.limited - prev->limited),
+             (unsigned long)(snap.overflow - prev->overflow),
+             (unsigned long)(snap.tx_failed - prev->tx_failed),
+             (unsigned long)(snap.tx_aborted - prev->tx_aborted),
+             (unsigned long)percentile(hist, latency_total, 50),
+             (unsigned long)percentile(hist, latency_total, 99),
+             (unsigned long)latency_max);
+
+    memcpy(prev, &snap, sizeof(RouterDirStats));
+}
@@ -0,0 +1,23 @@
+#include "sdkconfig.h"
+#include "task_table.h"
+
+/*
+ * Núcleo de tempo real: as três tarefas do caminho de dados. A ISR do INT
+ * do MCP2515 é instalada por app_main, também no núcleo 0, e a ISR do TWAI
+ * é alocada no núcleo que chama twai_driver_install.
+ *
+ * Núcleo de manutenção: recuperação do TWAI e relatórios (supervisor), saída
+ * do log e o monitor, que confere a pilha e o orçamento de CPU de cada
+ * entrada.
+ */
+const task_layout_entry_t TASK_TABLE[] = {
+    // nome           núcleo                         prio                       pilha (B)  período (ms)  CPU (%)
+    { TASK_MCP,        TASK_LAYOUT_CORE_RT,            configMAX_PRIORITIES - 2, 4096,        0,          40 },
+    { TASK_TWAI_TX,    TASK_LAYOUT_CORE_RT,            configMAX_PRIORITIES - 3, 4096,        0,          20 },
+    { TASK_TWAI_RX,    TASK_LAYOUT_CORE_RT,            configMAX_PRIORITIES - 3, 4096,        0,          20 },
+    { TASK_SUPERVISOR, TASK_LAYOUT_CORE_HOUSEKEEPING,  3,                        3072,      100,           5 },
+    { TASK_LOG,        TASK_LAYOUT_CORE_HOUSEKEEPING,  2,                        3072,        0,          10 },
+    { TASK_MONITOR,    TASK_LAYOUT_CORE_HOUSEKEEPING,  1,                        3072,    30000,           2 },
+};
+
+const size_t TASK_TABLE_COUNT = sizeof(TASK_TABLE) / sizeof(TASK_TABLE[0]);
@@ -0,0 +1,22 @@
+#include "cobs.h"
+
+size_t cobs_codifica(const uint8_t *entrada, size_t n, uint8_t *saida) {
+    size_t pos_codigo = 0;
+    size_t escrito = 1;
+    uint8_t codigo = 1;
+
+    for (size_t i = 0; i < n; i++) {
+        if (entrada[i] != 0) {
+            saida[escrito++] = entrada[i];
+            codigo++;
+        }
+        // Zero na entrada ou bloco de 254 bytes sem zeros: fecha o bloco
+        if (entrada[i] == 0 || codigo == 0xFF) {
+            saida[pos_codigo] = codigo;
+            pos_codigo = escrito++;
+            codigo = 1;
+        }
+    }
+    saida[pos_codigo] = codigo;
+    return escrito;
+}
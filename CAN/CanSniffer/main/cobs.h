@@ -0,0 +1,14 @@
+#ifndef COBS_H
+#define COBS_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+// Pior caso da codificação: um byte extra a cada 254 mais o primeiro código
+#define COBS_TAM_MAX(n) ((n) + (n) / 254 + 1)
+
+// Codifica n bytes de entrada em saida (COBS_TAM_MAX(n) bytes), sem o
+// delimitador 0x00 final. Retorna o número de bytes escritos.
+size_t cobs_codifica(const uint8_t *entrada, size_t n, uint8_t *saida);
+
+#endif // COBS_H
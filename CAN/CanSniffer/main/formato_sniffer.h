@@ -0,0 +1,59 @@
+#ifndef FORMATO_SNIFFER_H
+#define FORMATO_SNIFFER_H
+
+// Formato do fluxo binário do sniffer. Incluído também pelo decodificador
+// do computador (CAN/host), então só usa C padrão.
+//
+// Na UART cada lote é codificado em COBS e terminado por um byte 0x00, de
+// modo que o receptor ressincroniza no próximo zero depois de qualquer erro.
+//
+// Lote (antes do COBS, inteiros little-endian):
+//   0   u8   tipo (SNIFFER_TIPO_LOTE)
+//   1   u16  sequência do lote, incrementada a cada lote enviado
+//   3   u64  instante do primeiro quadro (us desde o boot do sniffer)
+//   11  u32  quadros perdidos até o fechamento do lote (total acumulado)
+//   15  ...  registros
+//   fim u16  CRC-16/CCITT-FALSE de todos os bytes anteriores
+//
+// Registro de um quadro:
+//   u8      bits 0-3 DLC, bit 4 RTR, bit 5 ID estendido
+//   varint  microssegundos desde o quadro anterior do lote (LEB128);
+//           o primeiro registro do lote tem delta 0
+//   ID      2 bytes (padrão) ou 4 bytes (estendido)
+//   dados   min(DLC, 8) bytes, ausentes em quadros RTR
+//
+// O total de perdidos é acumulado para que a perda de um lote inteiro não
+// esconda as perdas que ele reportava; lotes perdidos aparecem como saltos
+// na sequência.
+
+#include <stddef.h>
+#include <stdint.h>
+
+#define SNIFFER_TIPO_LOTE 0x01
+
+#define SNIFFER_OFS_TIPO 0
+#define SNIFFER_OFS_SEQUENCIA 1
+#define SNIFFER_OFS_INSTANTE 3
+#define SNIFFER_OFS_PERDIDOS 11
+#define SNIFFER_TAM_CABECALHO 15
+#define SNIFFER_TAM_CRC 2
+
+#define SNIFFER_REG_DLC 0x0F
+#define SNIFFER_REG_RTR 0x10
+#define SNIFFER_REG_EXT 0x20
+
+// Cabeçalho + delta de 32 bits em varint + ID estendido + 8 bytes
+#define SNIFFER_REGISTRO_MAX (1 + 5 + 4 + 8)
+
+static inline uint16_t sniffer_crc16(const uint8_t *dados, size_t n) {
+    uint16_t crc = 0xFFFF;
+    for (size_t i = 0; i < n; i++) {
+        crc ^= (uint16_t)dados[i] << 8;
+        for (int b = 0; b < 8; b++) {
+            crc = (crc & 0x8000) ? (uint16_t)((crc << 1) ^ 0x1021) : (uint16_t)(crc << 1);
+        }
+    }
+    return crc;
+}
+
+#endif // FORMATO_SNIFFER_H
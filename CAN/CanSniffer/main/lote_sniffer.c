@@ -0,0 +1,93 @@
+#include "lote_sniffer.h"
+
+#include <string.h>
+
+static void escreve_u16(uint8_t *p, uint16_t v) {
+    p[0] = (uint8_t)v;
+    p[1] = (uint8_t)(v >> 8);
+}
+
+static void escreve_u32(uint8_t *p, uint32_t v) {
+    for (int i = 0; i < 4; i++) {
+        p[i] = (uint8_t)(v >> (8 * i));
+    }
+}
+
+static void escreve_u64(uint8_t *p, uint64_t v) {
+    for (int i = 0; i < 8; i++) {
+        p[i] = (uint8_t)(v >> (8 * i));
+    }
+}
+
+void lote_inicializa(lote_sniffer_t *lote, uint8_t *buf, size_t capacidade) {
+    lote->buf = buf;
+    lote->capacidade = capacidade;
+    lote_descarta(lote);
+}
+
+void lote_descarta(lote_sniffer_t *lote) {
+    lote->usado = 0;
+    lote->quadros = 0;
+    lote->inicio_us = 0;
+    lote->ultimo_us = 0;
+}
+
+bool lote_adiciona(lote_sniffer_t *lote, uint32_t id, bool estendido, bool rtr,
+                   uint8_t dlc, const uint8_t *dados, int64_t instante_us) {
+    if (lote->usado == 0) {
+        if (lote->capacidade < SNIFFER_TAM_CABECALHO + SNIFFER_REGISTRO_MAX) {
+            return false;
+        }
+        lote->buf[SNIFFER_OFS_TIPO] = SNIFFER_TIPO_LOTE;
+        escreve_u64(&lote->buf[SNIFFER_OFS_INSTANTE], (uint64_t)instante_us);
+        lote->usado = SNIFFER_TAM_CABECALHO;
+        lote->inicio_us = instante_us;
+        lote->ultimo_us = instante_us;
+    } else if (lote->usado + SNIFFER_REGISTRO_MAX > lote->capacidade) {
+        return false;
+    }
+
+    uint8_t *p = &lote->buf[lote->usado];
+    uint8_t n_dados = rtr ? 0 : (dlc > 8 ? 8 : dlc);
+
+    *p++ = (uint8_t)((dlc & SNIFFER_REG_DLC) | (rtr ? SNIFFER_REG_RTR : 0) |
+                     (estendido ? SNIFFER_REG_EXT : 0));
+
+    // Delta em varint: 1 byte até 127 us, 2 bytes até 16 ms
+    int64_t delta_us = instante_us - lote->ultimo_us;
+    uint32_t delta = delta_us < 0 ? 0 : (delta_us > UINT32_MAX ? UINT32_MAX : (uint32_t)delta_us);
+    while (delta >= 0x80) {
+        *p++ = (uint8_t)(delta | 0x80);
+        delta >>= 7;
+    }
+    *p++ = (uint8_t)delta;
+
+    if (estendido) {
+        escreve_u32(p, id);
+        p += 4;
+    } else {
+        escreve_u16(p, (uint16_t)id);
+        p += 2;
+    }
+
+    memcpy(p, dados, n_dados);
+    p += n_dados;
+
+    lote->usado = (size_t)(p - lote->buf);
+    lote->ultimo_us = instante_us;
+    lote->quadros++;
+    return true;
+}
+
+size_t lote_fecha(lote_sniffer_t *lote, uint16_t sequencia, uint32_t perdidos, uint8_t *saida) {
+    escreve_u16(&lote->buf[SNIFFER_OFS_SEQUENCIA], sequencia);
+    escreve_u32(&lote->buf[SNIFFER_OFS_PERDIDOS], perdidos);
+
+    escreve_u16(&lote->buf[lote->usado], sniffer_crc16(lote->buf, lote->usado));
+
+    size_t n = cobs_codifica(lote->buf, lote->usado + SNIFFER_TAM_CRC, saida);
+    saida[n++] = 0x00;
+
+    lote_descarta(lote);
+    return n;
+}
@@ -0,0 +1,43 @@
+#ifndef LOTE_SNIFFER_H
+#define LOTE_SNIFFER_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "cobs.h"
+#include "formato_sniffer.h"
+
+// Bytes que lote_fecha() pode escrever para um lote de n bytes: CRC, COBS
+// e o delimitador
+#define LOTE_TAM_SAIDA(n) (COBS_TAM_MAX((n) + SNIFFER_TAM_CRC) + 1)
+
+// Lote em montagem. Os registros são escritos direto no buffer bruto;
+// sequência e perdidos só são conhecidos no fechamento.
+typedef struct {
+    uint8_t *buf;
+    size_t capacidade;
+    size_t usado;        // 0 = lote vazio
+    int64_t inicio_us;   // instante do primeiro quadro
+    int64_t ultimo_us;   // instante do quadro anterior, base do delta
+    uint32_t quadros;
+} lote_sniffer_t;
+
+// buf precisa de capacidade + SNIFFER_TAM_CRC bytes: o CRC é gravado logo
+// depois do último registro antes da codificação
+void lote_inicializa(lote_sniffer_t *lote, uint8_t *buf, size_t capacidade);
+
+// Acrescenta um quadro. Retorna false se o registro não cabe no lote;
+// nesse caso o chamador fecha o lote e tenta de novo.
+bool lote_adiciona(lote_sniffer_t *lote, uint32_t id, bool estendido, bool rtr,
+                   uint8_t dlc, const uint8_t *dados, int64_t instante_us);
+
+// Fecha o lote: grava sequência e perdidos no cabeçalho, acrescenta o CRC,
+// codifica em COBS para saida (LOTE_TAM_SAIDA(capacidade) bytes) com o 0x00
+// final e esvazia o lote. Retorna o número de bytes em saida.
+size_t lote_fecha(lote_sniffer_t *lote, uint16_t sequencia, uint32_t perdidos, uint8_t *saida);
+
+// Esvazia o lote sem enviar (lote descartado por falta de buffer de saída)
+void lote_descarta(lote_sniffer_t *lote);
+
+#endif // LOTE_SNIFFER_H
@@ -0,0 +1,219 @@
+#include <stdio.h>
+#include <inttypes.h>
+#include <string.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/queue.h"
+#include "driver/twai.h"
+#include "driver/uart.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+
+#include "sdkconfig.h"
+#include "lote_sniffer.h"
+
+#define TX_GPIO_NUM ((gpio_num_t)CONFIG_SNIFFER_TWAI_TX_GPIO)
+#define RX_GPIO_NUM ((gpio_num_t)CONFIG_SNIFFER_TWAI_RX_GPIO)
+
+#define UART_FLUXO ((uart_port_t)CONFIG_SNIFFER_UART_NUM)
+#define UART_TX_GPIO (CONFIG_SNIFFER_UART_TX_GPIO < 0 ? UART_PIN_NO_CHANGE : CONFIG_SNIFFER_UART_TX_GPIO)
+
+// ==================== DIMENSIONAMENTO ====================
+// A 500 kbit/s com 100% de ocupação chegam até ~10000 quadros/s com DLC 0
+// e ~4000 quadros/s com DLC 8. Os registros ocupam 5 a 15 bytes, ou seja,
+// no máximo ~60 kB/s, contra 200 kB/s de uma UART a 2 Mbaud.
+
+// Fila do driver: absorve um lote inteiro sendo fechado (CRC + COBS de
+// 1 kB leva ~100 us) com folga
+#define RX_QUEUE_LEN 128
+
+// Buffer circular do driver da UART: dois lotes codificados, para que a
+// próxima escrita já encontre espaço enquanto a anterior sai pelo FIFO
+#define UART_TX_BUFFER (2 * LOTE_TAM_SAIDA(CONFIG_SNIFFER_LOTE_BYTES))
+
+#define FLUSH_US ((int64_t)CONFIG_SNIFFER_FLUSH_MS * 1000)
+
+// Intervalo de impressão das estatísticas (em ms), só fora da UART0
+#define PERIODO_ESTATISTICAS_MS 1000
+
+#define PRIORIDADE_CAPTURA (configMAX_PRIORITIES - 2)
+#define PRIORIDADE_UART (configMAX_PRIORITIES - 3)
+
+typedef struct {
+    size_t tamanho;
+    uint8_t dados[LOTE_TAM_SAIDA(CONFIG_SNIFFER_LOTE_BYTES)];
+} lote_saida_t;
+
+typedef struct {
+    uint32_t quadros;
+    uint32_t lotes;
+    uint32_t bytes;
+    uint32_t descartados;    // quadros de lotes sem buffer de saída livre
+    uint32_t perdidos_fila;  // fila RX do driver cheia
+    uint32_t perdidos_fifo;  // FIFO do controlador transbordou
+} estatisticas_sniffer_t;
+
+static lote_saida_t lotes_saida[CONFIG_SNIFFER_NUM_LOTES];
+static QueueHandle_t fila_livres;
+static QueueHandle_t fila_prontos;
+
+static uint8_t buf_lote[CONFIG_SNIFFER_LOTE_BYTES + SNIFFER_TAM_CRC];
+static lote_sniffer_t lote;
+static uint16_t sequencia;
+
+static estatisticas_sniffer_t stats;
+
+// Fecha o lote corrente e o entrega à tarefa da UART. Sem buffer livre a
+// UART está atrasada: o lote é descartado e seus quadros contam como perda,
+// reportada no próximo lote que sair.
+static void envia_lote(void) {
+    twai_status_info_t status;
+    if (twai_get_status_info(&status) == ESP_OK) {
+        stats.perdidos_fila = status.rx_missed_count;
+        stats.perdidos_fifo = status.rx_overrun_count;
+    }
+
+    uint8_t indice;
+    if (xQueueReceive(fila_livres, &indice, 0) != pdTRUE) {
+        stats.descartados += lote.quadros;
+        lote_descarta(&lote);
+        return;
+    }
+
+    uint32_t perdidos = stats.descartados + stats.perdidos_fila + stats.perdidos_fifo;
+    stats.quadros += lote.quadros;
+    lotes_saida[indice].tamanho = lote_fecha(&lote, sequencia++, perdidos, lotes_saida[indice].dados);
+    xQueueSend(fila_prontos, &indice, portMAX_DELAY);
+}
+
+// Drena a fila do TWAI e monta os lotes. O instante de cada quadro é lido
+// assim que ele sai da fila do driver, que não registra o momento da
+// recepção; com esta tarefa na prioridade mais alta a fila fica quase
+// sempre vazia e o atraso é de poucos microssegundos.
+static void tarefa_captura(void *arg) {
+    twai_message_t msg;
+
+    while (1) {
+        // Com um lote aberto, espera só até o prazo de envio dele
+        TickType_t espera = portMAX_DELAY;
+        if (lote.usado > 0) {
+            int64_t restante_us = lote.inicio_us + FLUSH_US - esp_timer_get_time();
+            espera = restante_us > 0 ? pdMS_TO_TICKS(restante_us / 1000) + 1 : 0;
+        }
+
+        if (twai_receive(&msg, espera) == ESP_OK) {
+            int64_t agora = esp_timer_get_time();
+            if (!lote_adiciona(&lote, msg.identifier, msg.extd, msg.rtr, msg.data_length_code, msg.data, agora)) {
+                envia_lote();
+                lote_adiciona(&lote, msg.identifier, msg.extd, msg.rtr, msg.data_length_code, msg.data, agora);
+            }
+        }
+
+        if (lote.usado > 0 && esp_timer_get_time() - lote.inicio_us >= FLUSH_US) {
+            envia_lote();
+        }
+    }
+}
+
+// Escreve os lotes prontos na UART. uart_write_bytes copia o lote inteiro
+// para o buffer circular do driver; a interrupção da UART alimenta o FIFO.
+static void tarefa_uart(void *arg) {
+    uint8_t indice;
+
+    while (1) {
+        xQueueReceive(fila_prontos, &indice, portMAX_DELAY);
+        uart_write_bytes(UART_FLUXO, lotes_saida[indice].dados, lotes_saida[indice].tamanho);
+        stats.lotes++;
+        stats.bytes += lotes_saida[indice].tamanho;
+        xQueueSend(fila_livres, &indice, portMAX_DELAY);
+    }
+}
+
+#if CONFIG_SNIFFER_UART_NUM != 0
+static void imprime_estatisticas(const estatisticas_sniffer_t *atual, estatisticas_sniffer_t *anterior, uint32_t periodo_ms) {
+    uint32_t perdidos = (atual->descartados - anterior->descartados) +
+                        (atual->perdidos_fila - anterior->perdidos_fila) +
+                        (atual->perdidos_fifo - anterior->perdidos_fifo);
+
+    printf("Sniffer: %" PRIu32 " quadros/s | %" PRIu32 " lotes/s | %" PRIu32 " B/s | "
+           "perdidos: %" PRIu32 " (descartados %" PRIu32 ", fila %" PRIu32 ", fifo %" PRIu32 ")\n",
+           (atual->quadros - anterior->quadros) * 1000 / periodo_ms,
+           (atual->lotes - anterior->lotes) * 1000 / periodo_ms,
+           (atual->bytes - anterior->bytes) * 1000 / periodo_ms,
+           perdidos,
+           atual->descartados - anterior->descartados,
+           atual->perdidos_fila - anterior->perdidos_fila,
+           atual->perdidos_fifo - anterior->perdidos_fifo);
+
+    *anterior = *atual;
+}
+#endif
+
+void app_main(void) {
+    // Configura a UART do fluxo de captura
+    uart_config_t uart_config = {
+        .baud_rate = CONFIG_SNIFFER_UART_BAUD,
+        .data_bits = UART_DATA_8_BITS,
+        .parity = UART_PARITY_DISABLE,
+        .stop_bits = UART_STOP_BITS_1,
+        .flow_ctrl = UART_HW_FLOWCTRL_DISABLE,
+        .source_clk = UART_SCLK_DEFAULT,
+    };
+
+    // O driver exige um buffer de RX mesmo sem recepção
+    if (uart_driver_install(UART_FLUXO, 256, UART_TX_BUFFER, 0, NULL, 0) != ESP_OK ||
+        uart_param_config(UART_FLUXO, &uart_config) != ESP_OK ||
+        uart_set_pin(UART_FLUXO, UART_TX_GPIO, UART_PIN_NO_CHANGE, UART_PIN_NO_CHANGE, UART_PIN_NO_CHANGE) != ESP_OK) {
+        printf("Erro ao configurar a UART %d.\n", CONFIG_SNIFFER_UART_NUM);
+        return;
+    }
+
+    // Configura TWAI (CAN) em modo somente-escuta: não confirma quadros nem
+    // gera erros, então não altera o barramento observado
+    twai_general_config_t g_config = TWAI_GENERAL_CONFIG_DEFAULT(TX_GPIO_NUM, RX_GPIO_NUM, TWAI_MODE_LISTEN_ONLY);
+    g_config.rx_queue_len = RX_QUEUE_LEN;
+    g_config.tx_queue_len = 0;
+    twai_timing_config_t t_config = TWAI_TIMING_CONFIG_500KBITS();
+    twai_filter_config_t f_config = TWAI_FILTER_CONFIG_ACCEPT_ALL();
+
+    if (twai_driver_install(&g_config, &t_config, &f_config) != ESP_OK) {
+        printf("Erro ao instalar TWAI.\n");
+        return;
+    }
+
+    fila_livres = xQueueCreate(CONFIG_SNIFFER_NUM_LOTES, sizeof(uint8_t));
+    fila_prontos = xQueueCreate(CONFIG_SNIFFER_NUM_LOTES, sizeof(uint8_t));
+    for (uint8_t i = 0; i < CONFIG_SNIFFER_NUM_LOTES; i++) {
+        xQueueSend(fila_livres, &i, 0);
+    }
+    lote_inicializa(&lote, buf_lote, CONFIG_SNIFFER_LOTE_BYTES);
+
+    // Antes da troca da UART0: depois dela nenhum texto pode sair no stdout.
+    // Os quadros que chegarem até a captura começar esperam na fila do driver.
+    if (twai_start() != ESP_OK) {
+        printf("Erro ao iniciar TWAI.\n");
+        return;
+    }
+
+    printf("Sniffer: UART%d a %d baud, lotes de %d bytes, envio a cada %d ms.\n",
+           CONFIG_SNIFFER_UART_NUM, CONFIG_SNIFFER_UART_BAUD, CONFIG_SNIFFER_LOTE_BYTES, CONFIG_SNIFFER_FLUSH_MS);
+
+#if CONFIG_SNIFFER_UART_NUM == 0
+    // Daqui em diante a UART0 só transporta o fluxo binário
+    fflush(stdout);
+    uart_wait_tx_done(UART_FLUXO, portMAX_DELAY);
+    esp_log_level_set("*", ESP_LOG_NONE);
+#endif
+
+    xTaskCreate(tarefa_uart, "sniffer_uart", 3072, NULL, PRIORIDADE_UART, NULL);
+    xTaskCreate(tarefa_captura, "sniffer_captura", 4096, NULL, PRIORIDADE_CAPTURA, NULL);
+
+#if CONFIG_SNIFFER_UART_NUM != 0
+    estatisticas_sniffer_t anterior = {0};
+    while (1) {
+        vTaskDelay(pdMS_TO_TICKS(PERIODO_ESTATISTICAS_MS));
+        estatisticas_sniffer_t atual = stats;
+        imprime_estatisticas(&atual, &anterior, PERIODO_ESTATISTICAS_MS);
+    }
+#endif
+}
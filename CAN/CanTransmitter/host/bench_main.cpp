@@ -0,0 +1,117 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "esp_timer.h"
+
+#include "mcp2515.h"
+#include "can_bench.h"
+#include "mcp2515_sim.h"
+#include "sim_transport.h"
+
+#define TRACE_RECORDS 32
+
+/*
+ * Runs the loopback benchmark of the firmware against the simulated
+ * controller. Exits with a non-zero status when frames are lost or
+ * corrupted, so driver regressions fail before reaching hardware.
+ *
+ * It then times the same loopback round trip through the spi_master shim
+ * (the firmware transport) and through a direct transport, and with
+ * --trace prints the SPI transactions of one round trip.
+ *
+ *   mcp2515_bench [frames_per_dlc] [--trace]
+ */
+
+template <class Transport>
+static bool bring_up(MCP2515<Transport> &mcp)
+{
+    return mcp.reset() == MCP2515<Transport>::ERROR_OK &&
+           mcp.setBitrate(CAN_500KBPS, MCP_8MHZ) == MCP2515<Transport>::ERROR_OK &&
+           mcp.setLoopbackMode() == MCP2515<Transport>::ERROR_OK;
+}
+
+// Sends and reads back one 8 byte frame at a time; returns ns per round trip
+template <class Transport>
+static double round_trip_ns(MCP2515<Transport> &mcp, uint32_t frames)
+{
+    struct can_frame tx, rx;
+    memset(&tx, 0, sizeof(tx));
+    tx.can_id = 0x123;
+    tx.can_dlc = CAN_MAX_DLEN;
+
+    int64_t start = esp_timer_get_time();
+    for (uint32_t i = 0; i < frames; i++) {
+        tx.data[0] = (uint8_t)i;
+        mcp.sendMessage(&tx);
+        mcp.readMessage(&rx);
+    }
+    return (double)(esp_timer_get_time() - start) * 1000.0 / (frames > 0 ? frames : 1);
+}
+
+int main(int argc, char **argv)
+{
+    uint32_t frames = 2000;
+    bool trace_round_trip = false;
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--trace") == 0) {
+            trace_round_trip = true;
+        } else {
+            frames = strtoul(argv[i], NULL, 0);
+        }
+    }
+
+    Mcp2515Sim sim;
+    spi_device_handle_t handle = sim.handle();
+    MCP2515<> mcp(&handle);
+
+    if (mcp.reset() != MCP2515<>::ERROR_OK) {
+        fprintf(stderr, "reset failed\n");
+        return 2;
+    }
+    if (mcp.setBitrate(CAN_500KBPS, MCP_8MHZ) != MCP2515<>::ERROR_OK) {
+        fprintf(stderr, "setBitrate failed\n");
+        return 2;
+    }
+
+    uint32_t bytes_start = (uint32_t)sim.bytes();
+    uint32_t tx_start = sim.transactions();
+
+    uint32_t failures = can_bench_run(mcp, frames);
+
+    uint32_t total = frames * (CAN_MAX_DLEN + 1);
+    printf("simulator: %.2f SPI bytes/frame, %.2f transactions/frame, %u RX overflows\n",
+           (double)((uint32_t)sim.bytes() - bytes_start) / total,
+           (double)(sim.transactions() - tx_start) / total,
+           sim.overflows());
+
+    Mcp2515Sim direct_sim;
+    HostSimTransport direct_transport(&direct_sim);
+    MCP2515<HostSimTransport> direct(direct_transport);
+    if (!bring_up(mcp) || !bring_up(direct)) {
+        fprintf(stderr, "loopback setup failed\n");
+        return 2;
+    }
+    printf("round trip: %.0f ns via spi_master shim, %.0f ns via direct transport\n",
+           round_trip_ns(mcp, total), round_trip_ns(direct, total));
+
+    SpiTraceRecord records[TRACE_RECORDS];
+    SpiTrace trace(records, TRACE_RECORDS);
+    Mcp2515Sim traced_sim;
+    TracingTransport<HostSimTransport> traced_transport(HostSimTransport(&traced_sim), &trace);
+    MCP2515<TracingTransport<HostSimTransport> > traced(traced_transport);
+    if (!bring_up(traced)) {
+        fprintf(stderr, "loopback setup failed\n");
+        return 2;
+    }
+    trace.clear();
+    round_trip_ns(traced, 1);
+    printf("one round trip: %u SPI transactions\n", (unsigned)trace.total());
+    if (trace_round_trip) {
+        trace.dump();
+    }
+
+    printf("%s: %u of %u frames lost or corrupted\n", failures ? "FAIL" : "PASS", failures, total);
+
+    return failures ? 1 : 0;
+}
@@ -0,0 +1,7 @@
+#include "mcp2515.h"
+#include "mcp2515_impl.h"
+#include "sim_transport.h"
+
+// Host-only transports; the ESP-IDF ones are instantiated in mcp2515.cpp
+template class MCP2515<HostSimTransport>;
+template class MCP2515<TracingTransport<HostSimTransport> >;
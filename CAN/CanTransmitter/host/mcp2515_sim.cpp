@@ -0,0 +1,401 @@
+#include <string.h>
+#include <vector>
+
+#include "mcp2515_sim.h"
+
+struct spi_device_t {
+    Mcp2515Sim *sim;
+};
+
+// Register map (see MCP2515 datasheet, table 11-1)
+static const uint8_t TXRTSCTRL = 0x0D;
+static const uint8_t CANSTAT  = 0x0E;
+static const uint8_t CANCTRL  = 0x0F;
+static const uint8_t RXM0SIDH = 0x20;
+static const uint8_t RXM1SIDH = 0x24;
+static const uint8_t CANINTF  = 0x2C;
+static const uint8_t EFLG     = 0x2D;
+static const uint8_t TXB0CTRL = 0x30;
+static const uint8_t RXB0CTRL = 0x60;
+static const uint8_t RXB1CTRL = 0x70;
+
+static const uint8_t RXF_SIDH[6] = {0x00, 0x04, 0x08, 0x10, 0x14, 0x18};
+
+static const uint8_t MODE_MASK     = 0xE0;
+static const uint8_t MODE_NORMAL   = 0x00;
+static const uint8_t MODE_LOOPBACK = 0x40;
+static const uint8_t MODE_LISTEN   = 0x60;
+static const uint8_t MODE_CONFIG   = 0x80;
+
+static const uint8_t TXREQ      = 0x08;
+static const uint8_t TXP_MASK   = 0x03;
+static const uint8_t TX_RO_MASK = 0x70; // ABTF, MLOA, TXERR
+
+static const uint8_t SIDL_SRR   = 0x10;
+static const uint8_t SIDL_IDE   = 0x08;
+static const uint8_t DLC_RTR    = 0x40;
+static const uint8_t RXM_MASK   = 0x60;
+static const uint8_t RXM_ANY    = 0x60;
+static const uint8_t RXM_STD    = 0x20;
+static const uint8_t RXM_EXT    = 0x40;
+static const uint8_t RXRTR      = 0x08;
+static const uint8_t BUKT       = 0x04;
+static const uint8_t BUKT1      = 0x02;
+
+static const uint8_t RX0IF  = 0x01;
+static const uint8_t RX1IF  = 0x02;
+static const uint8_t ERRIF  = 0x20;
+static const uint8_t RX0OVR = 0x40;
+static const uint8_t RX1OVR = 0x80;
+
+Mcp2515Sim::Mcp2515Sim()
+{
+    peer = NULL;
+    dev = new spi_device_t;
+    dev->sim = this;
+    nTransactions = 0;
+    nBytes = 0;
+    nOverflows = 0;
+    nRtsPulses = 0;
+    powerOnReset();
+}
+
+spi_device_handle_t Mcp2515Sim::handle(void)
+{
+    return dev;
+}
+
+void Mcp2515Sim::connect(Mcp2515Sim *p)
+{
+    peer = p;
+}
+
+void Mcp2515Sim::powerOnReset(void)
+{
+    memset(regs, 0, sizeof(regs));
+    regs[CANCTRL] = 0x87;
+    regs[CANSTAT] = 0x80;
+}
+
+uint8_t Mcp2515Sim::read(uint8_t addr)
+{
+    addr &= 0x7F;
+
+    // CANSTAT and CANCTRL are mirrored at the end of every 16 byte block
+    if ((addr & 0x0F) == CANSTAT || (addr & 0x0F) == CANCTRL) {
+        return regs[addr & 0x0F];
+    }
+    return regs[addr];
+}
+
+void Mcp2515Sim::write(uint8_t addr, uint8_t value)
+{
+    addr &= 0x7F;
+
+    if ((addr & 0x0F) == CANSTAT) {
+        return;
+    }
+
+    if ((addr & 0x0F) == CANCTRL) {
+        regs[CANCTRL] = value;
+        regs[CANSTAT] = (regs[CANSTAT] & ~MODE_MASK) | (value & MODE_MASK);
+        transmitPending();
+        return;
+    }
+
+    switch (addr) {
+        case TXB0CTRL:
+        case TXB0CTRL + 0x10:
+        case TXB0CTRL + 0x20:
+            regs[addr] = (regs[addr] & TX_RO_MASK) | (value & (TXREQ | TXP_MASK));
+            if (value & TXREQ) {
+                regs[addr] &= ~TX_RO_MASK;
+                transmitPending();
+            }
+            break;
+
+        case TXRTSCTRL:
+            // Only the BnBFM bits are writable, and only in configuration mode
+            if ((regs[CANSTAT] & MODE_MASK) == MODE_CONFIG) {
+                regs[addr] = value & 0x07;
+            }
+            break;
+
+        case RXB0CTRL:
+            regs[addr] = (regs[addr] & ~(RXM_MASK | BUKT)) | (value & (RXM_MASK | BUKT));
+            break;
+
+        case RXB1CTRL:
+            regs[addr] = (regs[addr] & ~RXM_MASK) | (value & RXM_MASK);
+            break;
+
+        default:
+            regs[addr] = value;
+            break;
+    }
+}
+
+uint8_t Mcp2515Sim::readStatus(void)
+{
+    uint8_t intf = regs[CANINTF];
+    uint8_t status = intf & (RX0IF | RX1IF);
+
+    for (int n = 0; n < 3; n++) {
+        if (regs[TXB0CTRL + 0x10 * n] & TXREQ) {
+            status |= 0x04 << (2 * n);
+        }
+        if (intf & (0x04 << n)) {
+            status |= 0x08 << (2 * n);
+        }
+    }
+    return status;
+}
+
+uint8_t Mcp2515Sim::rxStatus(void)
+{
+    uint8_t intf = regs[CANINTF];
+    uint8_t status = (intf & (RX0IF | RX1IF)) << 6;
+    int rxb = (intf & RX0IF) ? 0 : ((intf & RX1IF) ? 1 : -1);
+
+    if (rxb >= 0) {
+        uint8_t base = RXB0CTRL + 0x10 * rxb;
+        bool ext = regs[base + 2] & SIDL_IDE;
+        bool rtr = regs[base] & RXRTR;
+        status |= (ext ? 0x10 : 0) | (rtr ? 0x08 : 0);
+        status |= rxb == 0 ? (regs[base] & 0x01) : (regs[base] & 0x07);
+    }
+    return status;
+}
+
+void Mcp2515Sim::pulseRts(int txb)
+{
+    // A falling edge on TXnRTS requests TXBn only when the pin is in request mode
+    if (txb < 0 || txb > 2 || !(regs[TXRTSCTRL] & (1 << txb))) {
+        return;
+    }
+    nRtsPulses++;
+    regs[TXB0CTRL + 0x10 * txb] |= TXREQ;
+    transmitPending();
+}
+
+void Mcp2515Sim::transmitPending(void)
+{
+    uint8_t mode = regs[CANSTAT] & MODE_MASK;
+    if (mode != MODE_NORMAL && mode != MODE_LOOPBACK) {
+        return;
+    }
+
+    while (true) {
+        // Highest TXP wins; on a tie the higher buffer number goes first
+        int next = -1;
+        for (int n = 2; n >= 0; n--) {
+            uint8_t ctrl = regs[TXB0CTRL + 0x10 * n];
+            if ((ctrl & TXREQ) &&
+                (next < 0 || (ctrl & TXP_MASK) > (regs[TXB0CTRL + 0x10 * next] & TXP_MASK))) {
+                next = n;
+            }
+        }
+        if (next < 0) {
+            return;
+        }
+
+        const uint8_t *buf = &regs[TXB0CTRL + 0x10 * next + 1];
+        if (mode == MODE_LOOPBACK) {
+            receive(buf);
+        } else if (peer != NULL) {
+            peer->receive(buf);
+        } else {
+            // Nobody acknowledges: the frame stays pending, as on a real bus
+            return;
+        }
+
+        regs[TXB0CTRL + 0x10 * next] &= ~TXREQ;
+        regs[CANINTF] |= 0x04 << next;
+    }
+}
+
+bool Mcp2515Sim::filterMatch(uint8_t f, uint8_t m, const uint8_t *buf)
+{
+    bool ext = buf[1] & SIDL_IDE;
+    if (ext != ((regs[f + 1] & SIDL_IDE) != 0)) {
+        return false;
+    }
+
+    uint16_t sid  = (buf[0] << 3) | (buf[1] >> 5);
+    uint16_t fsid = (regs[f] << 3) | (regs[f + 1] >> 5);
+    uint16_t msid = (regs[m] << 3) | (regs[m + 1] >> 5);
+    if ((sid ^ fsid) & msid) {
+        return false;
+    }
+
+    if (ext) {
+        uint32_t eid  = ((buf[1] & 0x03) << 16) | (buf[2] << 8) | buf[3];
+        uint32_t feid = ((regs[f + 1] & 0x03) << 16) | (regs[f + 2] << 8) | regs[f + 3];
+        uint32_t meid = ((regs[m + 1] & 0x03) << 16) | (regs[m + 2] << 8) | regs[m + 3];
+        if ((eid ^ feid) & meid) {
+            return false;
+        }
+    }
+    return true;
+}
+
+void Mcp2515Sim::storeRx(int rxb, uint8_t filhit, const uint8_t *buf)
+{
+    uint8_t base = RXB0CTRL + 0x10 * rxb;
+    bool ext = buf[1] & SIDL_IDE;
+    bool rtr = buf[4] & DLC_RTR;
+    uint8_t dlc = buf[4] & 0x0F;
+
+    regs[base + 1] = buf[0];
+    regs[base + 2] = (buf[1] & ~SIDL_SRR) | ((rtr && !ext) ? SIDL_SRR : 0);
+    regs[base + 3] = buf[2];
+    regs[base + 4] = buf[3];
+    regs[base + 5] = dlc | ((rtr && ext) ? DLC_RTR : 0);
+    memcpy(&regs[base + 6], &buf[5], dlc > 8 ? 8 : dlc);
+
+    if (rxb == 0) {
+        regs[base] = (regs[base] & (RXM_MASK | BUKT)) | (rtr ? RXRTR : 0) | (filhit & 0x01);
+    } else {
+        regs[base] = (regs[base] & RXM_MASK) | (rtr ? RXRTR : 0) | (filhit & 0x07);
+    }
+
+    regs[CANINTF] |= rxb == 0 ? RX0IF : RX1IF;
+}
+
+void Mcp2515Sim::receive(const uint8_t *buf)
+{
+    uint8_t mode = regs[CANSTAT] & MODE_MASK;
+    if (mode != MODE_NORMAL && mode != MODE_LOOPBACK && mode != MODE_LISTEN) {
+        return;
+    }
+
+    bool ext = buf[1] & SIDL_IDE;
+
+    for (int rxb = 0; rxb < 2; rxb++) {
+        uint8_t ctrl = regs[RXB0CTRL + 0x10 * rxb];
+        uint8_t rxm = ctrl & RXM_MASK;
+        int first = rxb == 0 ? 0 : 2;
+        int last  = rxb == 0 ? 1 : 5;
+        int hit = -1;
+
+        if (rxm == RXM_ANY) {
+            hit = first;
+        } else if ((rxm == RXM_STD && ext) || (rxm == RXM_EXT && !ext)) {
+            continue;
+        } else {
+            for (int f = first; f <= last && hit < 0; f++) {
+                if (filterMatch(RXF_SIDH[f], rxb == 0 ? RXM0SIDH : RXM1SIDH, buf)) {
+                    hit = f;
+                }
+            }
+        }
+
+        if (hit < 0) {
+            continue;
+        }
+
+        if (!(regs[CANINTF] & (rxb == 0 ? RX0IF : RX1IF))) {
+            storeRx(rxb, hit, buf);
+        } else if (rxb == 0 && (ctrl & BUKT) && !(regs[CANINTF] & RX1IF)) {
+            // Rollover: RXB1 reports the RXB0 filter that matched
+            storeRx(1, hit, buf);
+            regs[RXB0CTRL] |= BUKT1;
+        } else {
+            regs[EFLG] |= rxb == 0 ? RX0OVR : RX1OVR;
+            regs[CANINTF] |= ERRIF;
+            nOverflows++;
+        }
+        return;
+    }
+}
+
+void Mcp2515Sim::transfer(const uint8_t *tx, uint8_t *rx, size_t len)
+{
+    nTransactions++;
+    nBytes += len;
+
+    // Write-only transfers may pass no receive buffer
+    std::vector<uint8_t> discard;
+    if (rx == NULL) {
+        discard.resize(len);
+        rx = discard.data();
+    }
+    memset(rx, 0, len);
+
+    if (len == 0) {
+        return;
+    }
+
+    uint8_t ins = tx[0];
+
+    if (ins == 0xC0) {
+        powerOnReset();
+    } else if (ins == 0x03 && len >= 2) {
+        uint8_t addr = tx[1];
+        for (size_t i = 2; i < len; i++) {
+            rx[i] = read(addr++);
+        }
+    } else if (ins == 0x02 && len >= 2) {
+        uint8_t addr = tx[1];
+        for (size_t i = 2; i < len; i++) {
+            write(addr++, tx[i]);
+        }
+    } else if (ins == 0x05 && len >= 4) {
+        uint8_t addr = tx[1];
+        write(addr, (read(addr) & ~tx[2]) | (tx[3] & tx[2]));
+    } else if (ins == 0xA0) {
+        for (size_t i = 1; i < len; i++) {
+            rx[i] = readStatus();
+        }
+    } else if (ins == 0xB0) {
+        for (size_t i = 1; i < len; i++) {
+            rx[i] = rxStatus();
+        }
+    } else if ((ins & 0xF8) == 0x40 && (ins & 0x07) <= 0x05) {
+        // LOAD TX BUFFER: 0b01000abc
+        uint8_t addr = TXB0CTRL + 0x10 * ((ins >> 1) & 0x03) + ((ins & 0x01) ? 6 : 1);
+        for (size_t i = 1; i < len; i++) {
+            write(addr++, tx[i]);
+        }
+    } else if ((ins & 0xF8) == 0x80) {
+        // RTS: 0b10000nnn
+        for (int n = 0; n < 3; n++) {
+            if (ins & (1 << n)) {
+                regs[TXB0CTRL + 0x10 * n] = (regs[TXB0CTRL + 0x10 * n] & ~TX_RO_MASK) | TXREQ;
+            }
+        }
+        transmitPending();
+    } else if ((ins & 0xF9) == 0x90) {
+        // READ RX BUFFER: 0b10010nm0, the flag clears when CS is raised
+        int rxb = (ins >> 2) & 0x01;
+        uint8_t addr = RXB0CTRL + 0x10 * rxb + ((ins & 0x02) ? 6 : 1);
+        for (size_t i = 1; i < len; i++) {
+            rx[i] = read(addr++);
+        }
+        regs[CANINTF] &= ~(rxb == 0 ? RX0IF : RX1IF);
+    }
+}
+
+extern "C" esp_err_t spi_device_transmit(spi_device_handle_t handle, spi_transaction_t *t)
+{
+    size_t len = t->length / 8;
+    std::vector<uint8_t> tx(len, 0), rx(len, 0);
+
+    const uint8_t *src = (t->flags & SPI_TRANS_USE_TXDATA) ? t->tx_data : (const uint8_t *)t->tx_buffer;
+    if (src != NULL) {
+        memcpy(tx.data(), src, len);
+    }
+
+    handle->sim->transfer(tx.data(), rx.data(), len);
+
+    uint8_t *dst = (t->flags & SPI_TRANS_USE_RXDATA) ? t->rx_data : (uint8_t *)t->rx_buffer;
+    if (dst != NULL) {
+        memcpy(dst, rx.data(), len);
+    }
+    return ESP_OK;
+}
+
+extern "C" esp_err_t spi_device_polling_transmit(spi_device_handle_t handle, spi_transaction_t *t)
+{
+    return spi_device_transmit(handle, t);
+}
@@ -0,0 +1,61 @@
+#ifndef _MCP2515_SIM_H_
+#define _MCP2515_SIM_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "driver/spi_master.h"
+
+/*
+ * Register-level model of the MCP2515 behind the SPI instruction set.
+ *
+ * Modes are entered immediately, frames requested for transmission are
+ * delivered at once (to its own receive buffers in loopback, to the peer
+ * in normal mode) and acceptance filtering, rollover and overflow follow
+ * the datasheet. Bus timing is not modelled.
+ */
+class Mcp2515Sim
+{
+    public:
+        Mcp2515Sim();
+
+        // Handle to pass to the MCP2515 driver
+        spi_device_handle_t handle(void);
+
+        // Frames sent in normal mode are received by the peer
+        void connect(Mcp2515Sim *peer);
+
+        // One chip select cycle: tx is shifted in while rx is shifted out (rx may be NULL)
+        void transfer(const uint8_t *tx, uint8_t *rx, size_t len);
+
+        // Falling edge on the TXnRTS pin of buffer txb
+        void pulseRts(int txb);
+
+        uint32_t transactions(void) const { return nTransactions; }
+        uint64_t bytes(void) const { return nBytes; }
+        uint32_t overflows(void) const { return nOverflows; }
+        uint32_t rtsPulses(void) const { return nRtsPulses; }
+
+    private:
+        uint8_t regs[128];
+        Mcp2515Sim *peer;
+        struct spi_device_t *dev;
+
+        uint32_t nTransactions;
+        uint64_t nBytes;
+        uint32_t nOverflows;
+        uint32_t nRtsPulses;
+
+        void powerOnReset(void);
+        uint8_t read(uint8_t addr);
+        void write(uint8_t addr, uint8_t value);
+        uint8_t readStatus(void);
+        uint8_t rxStatus(void);
+
+        void transmitPending(void);
+        void receive(const uint8_t *buf);
+        bool filterMatch(uint8_t filterAddr, uint8_t maskAddr, const uint8_t *buf);
+        void storeRx(int rxb, uint8_t filhit, const uint8_t *buf);
+};
+
+#endif
@@ -0,0 +1,10 @@
+#ifndef HOST_SHIM_ESP_ERR_H_
+#define HOST_SHIM_ESP_ERR_H_
+
+typedef int esp_err_t;
+
+#define ESP_OK          0
+#define ESP_FAIL        -1
+#define ESP_ERR_NO_MEM  0x101
+
+#endif
@@ -0,0 +1,13 @@
+#ifndef HOST_SHIM_FREERTOS_H_
+#define HOST_SHIM_FREERTOS_H_
+
+#include <stdint.h>
+
+// Same tick rate as the project sdkconfig (CONFIG_FREERTOS_HZ=100)
+typedef uint32_t TickType_t;
+
+#define configTICK_RATE_HZ 100
+#define portTICK_PERIOD_MS (1000 / configTICK_RATE_HZ)
+#define pdMS_TO_TICKS(ms) ((TickType_t)(((uint64_t)(ms) * configTICK_RATE_HZ) / 1000))
+
+#endif
@@ -0,0 +1,13 @@
+#ifndef HOST_SHIM_TASK_H_
+#define HOST_SHIM_TASK_H_
+
+#include <unistd.h>
+
+#include "freertos/FreeRTOS.h"
+
+static inline void vTaskDelay(TickType_t ticks)
+{
+    usleep(ticks * portTICK_PERIOD_MS * 1000);
+}
+
+#endif
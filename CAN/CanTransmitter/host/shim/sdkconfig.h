@@ -0,0 +1,6 @@
+#ifndef HOST_SHIM_SDKCONFIG_H_
+#define HOST_SHIM_SDKCONFIG_H_
+
+// Host build: every firmware option off
+
+#endif
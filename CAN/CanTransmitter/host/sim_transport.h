@@ -0,0 +1,25 @@
+#ifndef _SIM_TRANSPORT_H_
+#define _SIM_TRANSPORT_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "mcp2515_sim.h"
+
+// Hands each transfer straight to the simulated controller, without going
+// through spi_transaction_t and the spi_master shim.
+class HostSimTransport
+{
+    public:
+        HostSimTransport(Mcp2515Sim *sim) : sim(sim) {}
+
+        inline void transfer(const uint8_t *tx, uint8_t *rx, size_t len)
+        {
+            sim->transfer(tx, rx, len);
+        }
+
+    private:
+        Mcp2515Sim *sim;
+};
+
+#endif
@@ -0,0 +1,19 @@
+#ifndef _CAN_BENCH_H_
+#define _CAN_BENCH_H_
+
+#include <stdint.h>
+
+#include "can_controller.h"
+#include "can_bench_stats.h"
+
+// Coloca o controlador em loopback e mede um DLC.
+// Retorna false se o modo loopback não puder ser ativado ou faltar memória.
+bool can_bench_run_dlc(CanController &mcp, uint8_t dlc, uint32_t frames, can_bench_result_t *result);
+
+void can_bench_print(const can_bench_result_t *result);
+
+// Mede todos os DLCs (0..8) e imprime a tabela de resultados.
+// Retorna o número de quadros perdidos ou corrompidos no total.
+uint32_t can_bench_run(CanController &mcp, uint32_t frames_per_dlc);
+
+#endif
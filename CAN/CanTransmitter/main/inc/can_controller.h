@@ -0,0 +1,26 @@
+#ifndef _CAN_CONTROLLER_H_
+#define _CAN_CONTROLLER_H_
+
+#include "sdkconfig.h"
+#include "mcp2515.h"
+
+#if CONFIG_CAN_NFC
+#include "freertos/FreeRTOS.h"
+#include "spi_bus_coordinator.h"
+
+// SPI compartilhado com o RC522: cada transação do MCP2515 passa pelo
+// coordenador. Chamadas diretas, resolvidas em tempo de compilação.
+struct CanSpiArbiter {
+    spi_bus_client_handle_t client;
+
+    inline void acquire(void) { spi_bus_client_acquire(client, portMAX_DELAY); }
+    inline void release(void) { spi_bus_client_release(client); }
+};
+
+typedef MCP2515<EspSpiPollingTransport<CanSpiArbiter> > CanController;
+#else
+// Barramento exclusivo: o árbitro vazio some na compilação
+typedef MCP2515<> CanController;
+#endif
+
+#endif
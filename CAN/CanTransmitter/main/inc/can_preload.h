@@ -0,0 +1,61 @@
+#ifndef _CAN_PRELOAD_H_
+#define _CAN_PRELOAD_H_
+
+#include <stdint.h>
+
+#include "driver/gpio.h"
+#include "driver/gptimer.h"
+#include "esp_err.h"
+#include "freertos/FreeRTOS.h"
+
+#include "can_controller.h"
+
+/*
+ * Quadro fixo em dois buffers de TX do MCP2515, disparado pelos pinos
+ * TXnRTS. Cada buffer tem seu próprio GPIO ligado ao TXnRTS correspondente
+ * (ativo em nível baixo); o disparo é só um pulso no pino, sem tráfego SPI.
+ *
+ * A atualização do conteúdo escreve no buffer inativo e só então o torna
+ * ativo, então um disparo nunca encontra um buffer pela metade.
+ */
+class PreloadedFrame
+{
+    public:
+        PreloadedFrame(CanController &mcp,
+                       CanController::TXBn txb_a, gpio_num_t rts_a,
+                       CanController::TXBn txb_b, gpio_num_t rts_b);
+
+        // Chamar com o MCP2515 em modo de configuração (deixa-o nesse modo).
+        // Liga os pinos TXnRTS e carrega o quadro nos dois buffers.
+        CanController::ERROR begin(const struct can_frame *frame);
+
+        // Carrega o novo conteúdo no buffer inativo e troca o buffer ativo.
+        // ERROR_ALLTXBUSY se o buffer inativo ainda tem transmissão pendente.
+        CanController::ERROR update(const struct can_frame *frame);
+
+        // Pulso no TXnRTS do buffer ativo. Pode ser chamada de ISR.
+        void trigger(void);
+
+        // Disparo periódico pelo gptimer, sem passar pela tarefa
+        esp_err_t startTimer(uint32_t period_us);
+        esp_err_t stopTimer(void);
+
+        uint32_t triggerCount(void) const { return triggers; }
+        uint32_t updateCount(void) const { return updates; }
+
+    private:
+        CanController &mcp;
+        CanController::TXBn txb[2];
+        gpio_num_t rts[2];
+
+        portMUX_TYPE mux;
+        volatile uint8_t active;
+        volatile uint32_t triggers;
+        uint32_t updates;
+
+        gptimer_handle_t timer;
+
+        static bool onAlarm(gptimer_handle_t timer, const gptimer_alarm_event_data_t *event, void *ctx);
+};
+
+#endif
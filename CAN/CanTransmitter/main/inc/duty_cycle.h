@@ -0,0 +1,65 @@
+#ifndef _DUTY_CYCLE_H_
+#define _DUTY_CYCLE_H_
+
+#include <stdint.h>
+
+#include "driver/gpio.h"
+#include "esp_err.h"
+
+// Correntes para a estimativa de consumo médio (uA). ESP32 com o rádio
+// desligado, valores típicos; MCP2515, máximos do datasheet. Transceptor
+// e sensor ficam de fora: dependem da placa.
+#define DUTY_ESP32_ACTIVE_UA      30000
+#define DUTY_ESP32_LIGHT_SLEEP_UA 800
+#define DUTY_MCP2515_ACTIVE_UA    10000
+#define DUTY_MCP2515_SLEEP_UA     5
+
+struct DutyCycleStats {
+    uint32_t timer_wakes;
+    uint32_t bus_wakes;
+    int64_t awake_us;
+    int64_t asleep_us;
+    uint32_t transmits;
+    int64_t latency_sum_us;   // despertar -> quadro transmitido
+    int64_t latency_max_us;
+};
+
+/*
+ * Sono leve do ESP32 entre amostras. Acorda pelo timer na hora da próxima
+ * amostra ou pelo pino INT do MCP2515 em nível baixo, que com o WAKIE
+ * ligado sinaliza atividade no barramento. Contabiliza o tempo acordado e
+ * dormindo para estimar a corrente média.
+ */
+class DutyCycle
+{
+    public:
+        enum Wake { WAKE_TIMER, WAKE_BUS };
+
+        explicit DutyCycle(gpio_num_t int_pin);
+
+        esp_err_t begin(void);
+
+        // Dorme até wake_at_us (relógio do esp_timer) ou até o INT descer.
+        // Com o INT já baixo volta na hora, sem perder o despertar.
+        Wake sleepUntil(int64_t wake_at_us);
+
+        // Instante em que o último sleepUntil() voltou
+        int64_t wokeAt(void) const { return woke_us; }
+
+        void recordTransmit(int64_t latency_us);
+
+        // Estatísticas desde a última chamada; contabiliza o tempo acordado
+        // até agora
+        void takeStats(DutyCycleStats *out);
+
+        // Corrente média estimada das estatísticas, em uA
+        static float averageCurrentUa(const DutyCycleStats &stats);
+
+    private:
+        gpio_num_t int_pin;
+        int64_t woke_us;
+        int64_t awake_since_us; // início do trecho acordado ainda não contabilizado
+        DutyCycleStats stats;
+};
+
+#endif
@@ -0,0 +1,30 @@
+#ifndef _NFC_READER_H_
+#define _NFC_READER_H_
+
+#include <stdint.h>
+
+#include "driver/gpio.h"
+#include "esp_err.h"
+#include "spi_bus_coordinator.h"
+#include "task_layout.h"
+
+/*
+ * Leitor RC522 no mesmo barramento SPI do MCP2515.
+ *
+ * O RC522 entra no coordenador com prioridade baixa e segura o barramento
+ * só durante um acesso a registrador (no máximo um FIFO de 64 bytes) ou o
+ * lote que prepara um comando ao cartão. Com o MCP2515 esperando, o
+ * barramento passa para ele ao fim desse acesso.
+ * Os cartões detectados são registrados no log. A tarefa de varredura
+ * segue a entrada task da tabela de tarefas (núcleo, prioridade, pilha e
+ * período de varredura) e é registrada nela para o monitor. Com irq_gpio
+ * >= 0 as esperas pelo cartão dormem no pino IRQ, sem tráfego no SPI.
+ */
+esp_err_t nfc_reader_start(spi_bus_coordinator_handle_t bus, gpio_num_t cs_gpio, gpio_num_t rst_gpio,
+                           gpio_num_t irq_gpio, uint32_t max_hold_us, const task_layout_entry_t *task);
+
+// Desde a última chamada: leituras de registrador, transações SPI por
+// leitura e acertos da sombra de registradores do RC522
+void nfc_reader_log_stats(void);
+
+#endif
@@ -0,0 +1,18 @@
+#ifndef _TASK_TABLE_H_
+#define _TASK_TABLE_H_
+
+#include <stddef.h>
+
+#include "task_layout.h"
+
+// Entradas da tabela de tarefas
+#define TASK_CAN       "can"
+#define TASK_RC522     "rc522"
+#define TASK_SPI_STATS "spi_stats"
+#define TASK_LOG       "log"
+#define TASK_MONITOR   "monitor"
+
+extern const task_layout_entry_t TASK_TABLE[];
+extern const size_t TASK_TABLE_COUNT;
+
+#endif
@@ -0,0 +1,89 @@
+#ifndef _TIME_SYNC_H_
+#define _TIME_SYNC_H_
+
+#include <stdint.h>
+
+#include "can.h"
+
+/*
+ * Sincronismo de tempo no estilo CANopen.
+ *
+ * O mestre envia SYNC (0x080, DLC 1: contador 1..240) e, logo depois da
+ * transmissão terminar, TIME (0x100, DLC 8: contador do SYNC a que se
+ * refere + instante de transmissão do SYNC em us, 56 bits little-endian).
+ * O seguidor marca a chegada do SYNC no seu relógio local e, quando recebe
+ * o TIME correspondente, corrige fase e frequência do relógio disciplinado.
+ */
+#define TIME_SYNC_COB_ID 0x080
+#define TIME_TIME_COB_ID 0x100
+
+// Erro acima deste valor reposiciona o relógio em vez de corrigi-lo aos poucos
+#define TIME_SYNC_STEP_US 1000
+
+// Erro abaixo deste valor conta como amostra boa; algumas seguidas = travado
+#define TIME_SYNC_LOCK_US 200
+#define TIME_SYNC_LOCK_SAMPLES 4
+
+// Estatísticas de uma janela de observação
+struct TimeSyncStats {
+    uint32_t samples;        // Pares SYNC/TIME aplicados
+    double offset_mean_us;   // Erro médio do relógio disciplinado no SYNC
+    double offset_jitter_us; // Desvio padrão desse erro
+    int64_t offset_max_us;   // Maior erro absoluto
+    uint32_t steps;          // Reposicionamentos do relógio
+    double drift_ppm;        // Frequência do mestre em relação à local (positivo: relógio local atrasa)
+
+    uint32_t slots;          // Amostragens disparadas em slot
+    double slot_mean_us;     // Atraso médio do disparo em relação ao início do slot
+    int64_t slot_max_us;     // Maior atraso absoluto
+};
+
+class TimeSyncFollower
+{
+    public:
+        TimeSyncFollower();
+        void reset(void);
+
+        // Instante local (us) em que o SYNC chegou. Retorna false se o quadro não é SYNC.
+        bool onSync(const struct can_frame *frame, int64_t local_us);
+
+        // Aplica o TIME se corresponder ao último SYNC. Retorna true se o relógio foi corrigido.
+        bool onTime(const struct can_frame *frame);
+
+        bool locked(void) const;
+        int64_t toMaster(int64_t local_us) const;
+        int64_t toLocal(int64_t master_us) const;
+
+        // Registra o erro de disparo de uma amostragem (real - previsto, em us locais)
+        void recordSlotError(int64_t error_us);
+
+        // Copia as estatísticas da janela atual e começa outra
+        void takeStats(TimeSyncStats *stats);
+
+    private:
+        // master = refMaster + (local - refLocal) * (1 + rate)
+        int64_t refLocal;
+        int64_t refMaster;
+        double rate;
+        bool started;
+        uint32_t goodSamples;
+
+        uint8_t syncCounter;
+        int64_t syncLocal;
+        bool syncPending;
+
+        uint32_t nOffset;
+        double sumOffset;
+        double sumOffset2;
+        int64_t maxOffset;
+        uint32_t nSteps;
+
+        uint32_t nSlot;
+        double sumSlot;
+        int64_t maxSlot;
+
+        void apply(int64_t local_us, int64_t master_us);
+        void clearStats(void);
+};
+
+#endif
@@ -0,0 +1,92 @@
+#ifndef _ULTRASONIC_SCHEDULER_H_
+#define _ULTRASONIC_SCHEDULER_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "driver/gpio.h"
+#include "driver/rmt_rx.h"
+#include "esp_err.h"
+#include "esp_timer.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/semphr.h"
+
+// Um canal RMT de recepção por eco; o ESP32 tem 8
+#define ULTRASONIC_MAX_SENSORS 8
+
+// Par TRIGGER/ECHO e o slot em que dispara. Sensores do mesmo slot
+// disparam juntos, então precisam estar montados de modo a não ouvir o
+// eco uns dos outros; sensores que se interferem ficam em slots distintos.
+struct UltrasonicSensor {
+    gpio_num_t trigger;
+    gpio_num_t echo;
+    uint8_t slot;
+};
+
+struct UltrasonicReading {
+    float distance_cm;  // negativo quando não houve eco no slot
+    int64_t fired_us;   // instante do disparo
+};
+
+// Tabela dos sensores do nó, em src/ultrasonic_sensors.cpp
+extern const UltrasonicSensor ULTRASONIC_SENSORS[];
+extern const size_t ULTRASONIC_SENSOR_COUNT;
+
+/*
+ * Dispara os sensores slot a slot. Cada eco é medido por um canal RMT de
+ * recepção, que registra a largura do pulso em hardware com resolução de
+ * 1 us, sem depender da latência de interrupções ou da tarefa.
+ *
+ * Cada slot dura slot_us a partir do disparo, marcado por um esp_timer,
+ * para que ecos tardios de um grupo não cheguem durante o seguinte. Uma
+ * rodada mede todos os sensores em slotCount() * slot_us, então a taxa
+ * agregada cresce com o número de sensores que podem disparar juntos.
+ */
+class UltrasonicScheduler
+{
+    public:
+        // O RMT só encerra a recepção depois de a linha ficar parada pelo
+        // mesmo tempo que a maior largura aceita, então o eco mais longo
+        // medido é (slot_us - atraso do sensor) / 2, até ~32 ms. Ecos mais
+        // longos saem truncados nesse limite.
+        UltrasonicScheduler(const UltrasonicSensor *sensors, size_t count, uint32_t slot_us);
+
+        esp_err_t begin(void);
+
+        size_t sensorCount(void) const { return count; }
+        uint32_t maxEchoUs(void) const { return max_echo_us; }
+        size_t slotCount(void) const { return slots; }
+        uint32_t roundUs(void) const { return (uint32_t)slots * slot_us; }
+
+        // Mede todos os sensores, um slot após o outro. readings precisa de
+        // sensorCount() posições, na ordem da tabela. Bloqueia por roundUs().
+        void runRound(UltrasonicReading *readings);
+
+    private:
+        // Um pulso de eco ocupa um símbolo; o mínimo por canal no ESP32 é 64
+        static const size_t SYMBOLS = 64;
+
+        struct EchoChannel {
+            UltrasonicScheduler *owner;
+            rmt_channel_handle_t rx;
+            rmt_symbol_word_t symbols[SYMBOLS];
+            volatile uint32_t width_us;
+            volatile bool done;
+        };
+
+        const UltrasonicSensor *sensors;
+        size_t count;
+        size_t slots;
+        uint32_t slot_us;
+        uint32_t max_echo_us;
+        EchoChannel channels[ULTRASONIC_MAX_SENSORS];
+        esp_timer_handle_t slot_timer;
+        SemaphoreHandle_t slot_end;
+
+        void fireSlot(uint8_t slot, UltrasonicReading *readings);
+
+        static bool onEcho(rmt_channel_handle_t rx, const rmt_rx_done_event_data_t *edata, void *ctx);
+        static void onSlotEnd(void *arg);
+};
+
+#endif
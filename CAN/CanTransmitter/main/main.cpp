@@ -9,7 +9,16 @@
 #include "esp_timer.h"
 #include "esp32/rom/ets_sys.h"
 
-#include "mcp2515.h"
+#include "sdkconfig.h"
+#include "can_controller.h"
+#include "can_bench.h"
+#include "time_sync.h"
+#include "can_preload.h"
+#include "ultrasonic_scheduler.h"
+#include "duty_cycle.h"
+#include "spi_bus_coordinator.h"
+#include "nfc_reader.h"
+#include "task_table.h"
 
 #define TAG "CAN_ULTRASONIC_CPP"
 
@@ -29,10 +38,160 @@
 #define MAX_DISTANCE_CM 50.0f
 #define MIN_DISTANCE_CM 0.0f
 
+// Byte de status do quadro de leitura, em ordem crescente de gravidade
+#define STATUS_OK            0x01
+#define STATUS_OUT_OF_RANGE  0x02 // Distância acima de MAX_DISTANCE_CM
+#define STATUS_INVALID       0x03 // Timeout ou erro do sensor
+
+#define READING_DLC 6 // 1 byte status + 4 bytes float + 1 byte sequência
+
+// Leituras agrupadas do escalonador: até 3 sensores por quadro, no ID
+// CAN_MULTI_ID + índice do quadro na rodada
+//   data[0]    sequência da rodada, igual em todos os quadros dela
+//   data[1]    índice do primeiro sensor do quadro na tabela
+//   data[2..]  distância de cada sensor em mm (u16 little-endian), ou um
+//              dos códigos abaixo
+#define PACKED_READINGS_PER_FRAME 3
+#define PACKED_INVALID            0xFFFF // Sem eco no slot
+#define PACKED_OUT_OF_RANGE       0xFFFE // Acima de MAX_DISTANCE_CM
+
+// Espera por um buffer de TX livre entre os quadros de uma rodada
+#define PACKED_TX_TIMEOUT_US 2000
+
+// Intervalo entre relatórios do escalonador
+#define SCHEDULER_REPORT_US 10000000
+
+// Intervalo entre relatórios do ciclo de trabalho
+#define LOW_POWER_REPORT_US 60000000
+
+// Espera pelo INT entre consultas na janela acordada após atividade no barramento
+#define LOW_POWER_POLL_US 200
+
+// Buffer das linhas de log a caminho da tarefa de saída
+#define LOG_BUFFER_BYTES 4096
+
+// Reserva do prazo de resposta para montar e enviar o quadro
+#define RTR_TX_MARGIN_US 2000
+
+// O nó só lê o MCP2515 quando atende RTRs ou segue o sincronismo. No
+// ciclo de trabalho o INT é fonte de despertar do sono leve (por nível) e
+// é consultado depois de acordar, sem a interrupção por borda.
+#define CAN_RX_ENABLED  (!CONFIG_CAN_TX_PERIODIC || CONFIG_CAN_TIME_SYNC || CONFIG_CAN_LOW_POWER)
+#define CAN_RX_USES_INT (CAN_RX_ENABLED && CONFIG_CAN_INT_GPIO >= 0 && !CONFIG_CAN_LOW_POWER)
+
+#if CONFIG_CAN_TIME_SYNC && CONFIG_CAN_INT_GPIO < 0
+#error "O sincronismo precisa do pino INT para marcar a chegada do SYNC"
+#endif
+
+// Bits de notificação da tarefa principal
+#define NOTIFY_CAN_RX (1 << 0) // Borda de descida no INT do MCP2515
+#define NOTIFY_SLOT   (1 << 1) // Início do slot de amostragem
+
+// Heartbeat: estado do nó + status da última leitura
+#define HEARTBEAT_DLC               2
+#define HEARTBEAT_STATE_OPERATIONAL 0x05
+
+// Intervalo entre relatórios do sincronismo
+#define TIME_SYNC_REPORT_US 10000000
+
 spi_device_handle_t spi_handle;
 
-// Função para medir a distância
-float measure_distance() {
+#if CONFIG_CAN_NFC
+// SPI compartilhado com o RC522: o MCP2515 tem prioridade e cada
+// transação dele passa pelo coordenador
+static spi_bus_coordinator_handle_t spi_bus;
+static spi_bus_client_handle_t can_spi_client;
+
+static void spi_stats_task(void *arg) {
+    TickType_t last_wake = xTaskGetTickCount();
+    while (1) {
+        vTaskDelayUntil(&last_wake, task_layout_period(TASK_SPI_STATS));
+        spi_bus_coordinator_log_stats(spi_bus);
+        nfc_reader_log_stats();
+    }
+}
+#endif
+
+// Segura o barramento durante um envio inteiro, para o RC522 não entrar
+// entre as transações de um mesmo quadro. Sem o RC522 não faz nada.
+class SpiBurst {
+    public:
+        SpiBurst() {
+#if CONFIG_CAN_NFC
+            spi_bus_client_acquire(can_spi_client, portMAX_DELAY);
+#endif
+        }
+        ~SpiBurst() {
+#if CONFIG_CAN_NFC
+            spi_bus_client_release(can_spi_client);
+#endif
+        }
+};
+
+#if CAN_RX_USES_INT
+static TaskHandle_t can_task;
+
+static portMUX_TYPE int_mux = portMUX_INITIALIZER_UNLOCKED;
+static int64_t int_edge_us;
+
+// Pino INT do MCP2515 (ativo em nível baixo): marca o instante e acorda a tarefa
+static void IRAM_ATTR mcp2515_int_isr(void *arg) {
+    int64_t now = esp_timer_get_time();
+    portENTER_CRITICAL_ISR(&int_mux);
+    int_edge_us = now;
+    portEXIT_CRITICAL_ISR(&int_mux);
+
+    BaseType_t woken = pdFALSE;
+    xTaskNotifyFromISR(can_task, NOTIFY_CAN_RX, eSetBits, &woken);
+    portYIELD_FROM_ISR(woken);
+}
+
+static int64_t last_int_edge(void) {
+    portENTER_CRITICAL(&int_mux);
+    int64_t edge = int_edge_us;
+    portEXIT_CRITICAL(&int_mux);
+    return edge;
+}
+#endif
+
+#if CONFIG_CAN_HEARTBEAT
+static PreloadedFrame *heartbeat;
+static uint8_t heartbeat_status = STATUS_INVALID;
+
+static void fill_heartbeat(struct can_frame *frame, uint8_t status) {
+    memset(frame, 0, sizeof(struct can_frame));
+    frame->can_id = CONFIG_CAN_HEARTBEAT_ID;
+    frame->can_dlc = HEARTBEAT_DLC;
+    frame->data[0] = HEARTBEAT_STATE_OPERATIONAL;
+    frame->data[1] = status;
+}
+#endif
+
+// Só gasta SPI com o heartbeat quando o status muda
+static void update_heartbeat(uint8_t status) {
+#if CONFIG_CAN_HEARTBEAT
+    if (status == heartbeat_status) {
+        return;
+    }
+    struct can_frame frame;
+    fill_heartbeat(&frame, status);
+    // Com o buffer inativo ainda na fila, tenta de novo na próxima leitura
+    if (heartbeat->update(&frame) == CanController::ERROR_OK) {
+        heartbeat_status = status;
+    }
+#endif
+}
+
+#if CONFIG_CAN_TIME_SYNC
+static TimeSyncFollower time_sync;
+
+static void slot_timer_cb(void *arg) {
+    xTaskNotify(can_task, NOTIFY_SLOT, eSetBits);
+}
+#endif
+
+// Função para medir a distância. O timeout vale para cada fase do eco.
+float measure_distance(uint32_t timeout_us) {
     gpio_set_level((gpio_num_t)TRIGGER_GPIO, 0);
     ets_delay_us(2);
     gpio_set_level((gpio_num_t)TRIGGER_GPIO, 1);
@@ -44,7 +203,7 @@ float measure_distance() {
 
     timeout_start_us = esp_timer_get_time();
     while (gpio_get_level((gpio_num_t)ECHO_GPIO) == 0) {
-        if ((esp_timer_get_time() - timeout_start_us) > ULTRASONIC_TIMEOUT_US) {
+        if ((esp_timer_get_time() - timeout_start_us) > timeout_us) {
             ESP_LOGW(TAG, "Timeout esperando ECHO HIGH");
             return -1.0f;
         }
@@ -53,7 +212,7 @@ float measure_distance() {
 
     timeout_start_us = esp_timer_get_time();
     while (gpio_get_level((gpio_num_t)ECHO_GPIO) == 1) {
-        if ((esp_timer_get_time() - timeout_start_us) > ULTRASONIC_TIMEOUT_US) {
+        if ((esp_timer_get_time() - timeout_start_us) > timeout_us) {
             ESP_LOGW(TAG, "Timeout esperando ECHO LOW");
             return -1.0f;
         }
@@ -68,7 +227,245 @@ float measure_distance() {
     return -1.0f;
 }
 
+#if !CONFIG_CAN_TX_PERIODIC || CONFIG_CAN_ULTRASONIC_MULTI || CONFIG_CAN_LOW_POWER
+static uint8_t reading_status(float distance) {
+    if (distance < MIN_DISTANCE_CM) {
+        return STATUS_INVALID;
+    }
+    return distance > MAX_DISTANCE_CM ? STATUS_OUT_OF_RANGE : STATUS_OK;
+}
+#endif
+
+static CanController::ERROR send_reading(CanController &mcp, uint8_t status, float distance, uint8_t *sequence) {
+    struct can_frame tx_frame;
+    memset(&tx_frame, 0, sizeof(struct can_frame));
+    tx_frame.can_id = CONFIG_CAN_NODE_ID;
+    tx_frame.can_dlc = READING_DLC;
+
+    tx_frame.data[0] = status; // Status ou código da mensagem
+
+    memcpy(&tx_frame.data[1], &distance, sizeof(float));
+
+    tx_frame.data[5] = (*sequence)++; // Permite ao receptor detectar quadros perdidos
+
+    SpiBurst burst;
+    update_heartbeat(status);
+
+    return mcp.sendMessage(&tx_frame);
+}
+
+#if CONFIG_CAN_ULTRASONIC_MULTI || CONFIG_CAN_LOW_POWER
+// TXB0 ainda pode estar com o quadro anterior da rodada (~250 us a 500 kbit/s)
+static CanController::ERROR send_when_free(CanController &mcp, const struct can_frame *frame) {
+    int64_t deadline = esp_timer_get_time() + PACKED_TX_TIMEOUT_US;
+    CanController::ERROR err;
+    while (true) {
+        {
+            SpiBurst burst;
+            err = mcp.sendMessage(frame);
+        }
+        if (err != CanController::ERROR_ALLTXBUSY || esp_timer_get_time() >= deadline) {
+            return err;
+        }
+        ets_delay_us(50);
+    }
+}
+
+// Publica uma rodada do escalonador. O heartbeat leva o pior status.
+static void send_packed_readings(CanController &mcp, const UltrasonicReading *readings, size_t count, uint8_t sequence) {
+    uint8_t worst = STATUS_OK;
+
+    for (size_t first = 0; first < count; first += PACKED_READINGS_PER_FRAME) {
+        size_t n = count - first < PACKED_READINGS_PER_FRAME ? count - first : PACKED_READINGS_PER_FRAME;
+
+        struct can_frame tx_frame;
+        memset(&tx_frame, 0, sizeof(struct can_frame));
+        tx_frame.can_id = CONFIG_CAN_MULTI_ID + first / PACKED_READINGS_PER_FRAME;
+        tx_frame.can_dlc = 2 + 2 * n;
+        tx_frame.data[0] = sequence;
+        tx_frame.data[1] = (uint8_t)first;
+
+        for (size_t k = 0; k < n; k++) {
+            float distance = readings[first + k].distance_cm;
+            uint8_t status = reading_status(distance);
+            uint16_t value = PACKED_INVALID;
+            if (status == STATUS_OK) {
+                value = (uint16_t)(distance * 10.0f + 0.5f);
+            } else if (status == STATUS_OUT_OF_RANGE) {
+                value = PACKED_OUT_OF_RANGE;
+            }
+            if (status > worst) {
+                worst = status;
+            }
+            tx_frame.data[2 + 2 * k] = (uint8_t)value;
+            tx_frame.data[3 + 2 * k] = (uint8_t)(value >> 8);
+        }
+
+        if (send_when_free(mcp, &tx_frame) != CanController::ERROR_OK) {
+            ESP_LOGE(TAG, "Falha ao enviar as leituras %u..%u.", (unsigned)first, (unsigned)(first + n - 1));
+        }
+    }
+
+    update_heartbeat(worst);
+}
+#endif
+
+#if CONFIG_CAN_LOW_POWER
+// Espera os buffers de TX esvaziarem: o MCP2515 só deve dormir depois de
+// transmitir, e a latência despertar -> TX conta até o quadro sair
+static bool wait_tx_idle(CanController &mcp, int64_t timeout_us) {
+    int64_t deadline = esp_timer_get_time() + timeout_us;
+    while (mcp.isTxPending(CanController::TXB0) || mcp.isTxPending(CanController::TXB1) ||
+           mcp.isTxPending(CanController::TXB2)) {
+        if (esp_timer_get_time() >= deadline) {
+            return false;
+        }
+        ets_delay_us(50);
+    }
+    return true;
+}
+#endif
+
+#if CONFIG_CAN_TX_PERIODIC && !CONFIG_CAN_ULTRASONIC_MULTI && !CONFIG_CAN_LOW_POWER
+// Modo periódico: só leituras dentro do limite vão para o barramento
+static void sample_and_send(CanController &mcp, uint32_t timeout_us, uint8_t *sequence) {
+    float distance = measure_distance(timeout_us);
+    ESP_LOGI(TAG, "Distância medida: %.2f cm", distance);
+
+    if (distance >= MIN_DISTANCE_CM && distance <= MAX_DISTANCE_CM) {
+        if (send_reading(mcp, STATUS_OK, distance, sequence) == CanController::ERROR_OK) {
+            ESP_LOGI(TAG, "Mensagem CAN enviada. ID: 0x%X, Distância: %.2f cm",
+                     CONFIG_CAN_NODE_ID, distance);
+        } else {
+            ESP_LOGE(TAG, "Falha ao enviar mensagem CAN.");
+        }
+    } else if (distance < 0) {
+        ESP_LOGW(TAG, "Leitura inválida do sensor ultrassônico.");
+        update_heartbeat(STATUS_INVALID);
+    } else if (distance > MAX_DISTANCE_CM) {
+        ESP_LOGW(TAG, "Distância fora do limite máximo de %.2f cm. Ignorada.", MAX_DISTANCE_CM);
+        update_heartbeat(STATUS_OUT_OF_RANGE);
+    }
+}
+#endif
+
+#if CAN_RX_ENABLED
+// Só passam pelos filtros os quadros do nó (RTR) e, com sincronismo, SYNC
+// e TIME no RXB0. O resto do tráfego nunca chega aos buffers de RX nem
+// gera transações SPI.
+static CanController::ERROR configure_rx_filters(CanController &mcp) {
+    const CanController::RXF filters[] = {CanController::RXF0, CanController::RXF1, CanController::RXF2,
+                                    CanController::RXF3, CanController::RXF4, CanController::RXF5};
+    CanController::ERROR err;
+
+    if ((err = mcp.setFilterMask(CanController::MASK0, false, CAN_SFF_MASK)) != CanController::ERROR_OK ||
+        (err = mcp.setFilterMask(CanController::MASK1, false, CAN_SFF_MASK)) != CanController::ERROR_OK) {
+        return err;
+    }
+
+    for (int i = 0; i < 6; i++) {
+        uint32_t id = CONFIG_CAN_NODE_ID;
+#if CONFIG_CAN_TIME_SYNC
+        if (filters[i] == CanController::RXF0) {
+            id = TIME_SYNC_COB_ID;
+        } else if (filters[i] == CanController::RXF1) {
+            id = TIME_TIME_COB_ID;
+        }
+#endif
+        if ((err = mcp.setFilter(filters[i], false, id)) != CanController::ERROR_OK) {
+            return err;
+        }
+    }
+    return CanController::ERROR_OK;
+}
+
+// Lê tudo o que passou pelos filtros. Retorna true se havia um RTR para
+// este nó; vários RTRs pendentes são atendidos por uma única resposta.
+// edge_us é o instante da borda do INT que acordou a tarefa.
+static bool drain_rx(CanController &mcp, int64_t edge_us) {
+    struct can_frame rx_frame;
+    bool requested = false;
+#if CONFIG_CAN_TIME_SYNC
+    bool first = true;
+#endif
+
+    while (mcp.readMessage(&rx_frame) == CanController::ERROR_OK) {
+#if CONFIG_CAN_TIME_SYNC
+        // A borda só pertence ao SYNC se ele foi o primeiro quadro pendente
+        if (rx_frame.can_id == TIME_SYNC_COB_ID) {
+            if (first) {
+                time_sync.onSync(&rx_frame, edge_us);
+            }
+        } else if (rx_frame.can_id == TIME_TIME_COB_ID) {
+            time_sync.onTime(&rx_frame);
+        }
+#endif
+        if ((rx_frame.can_id & CAN_RTR_FLAG) && !(rx_frame.can_id & CAN_EFF_FLAG) &&
+            (rx_frame.can_id & CAN_SFF_MASK) == CONFIG_CAN_NODE_ID) {
+            requested = true;
+        }
+#if CONFIG_CAN_TIME_SYNC
+        first = false;
+#endif
+    }
+
+    // ERRIF/MERRF também seguram o INT em nível baixo; limpa para não perder a próxima borda
+    if (mcp.getInterrupts() & (CanController::CANINTF_ERRIF | CanController::CANINTF_MERRF)) {
+        mcp.clearRXnOVR();
+        mcp.clearMERR();
+        mcp.clearERRIF();
+    }
+
+    return requested;
+}
+#endif
+
+#if !CONFIG_CAN_TX_PERIODIC
+enum class RtrWait {
+    REQUESTED, // Chegou um RTR para este nó
+    WOKEN,     // Acordou antes do prazo sem RTR (outro quadro ou notificação)
+    TIMED_OUT,
+};
+
+// Espera um RTR por até 'timeout' ticks (portMAX_DELAY = sem limite)
+static RtrWait wait_for_rtr(CanController &mcp, TickType_t timeout) {
+#if CONFIG_CAN_INT_GPIO >= 0
+    // Um quadro que chegou antes de dormir já deixou a notificação pendente
+    uint32_t bits = 0;
+    if (xTaskNotifyWait(0, UINT32_MAX, &bits, timeout) != pdTRUE) {
+        return RtrWait::TIMED_OUT;
+    }
+    if (!(bits & NOTIFY_CAN_RX)) {
+        return RtrWait::WOKEN;
+    }
+    return drain_rx(mcp, last_int_edge()) ? RtrWait::REQUESTED : RtrWait::WOKEN;
+#else
+    TickType_t poll = pdMS_TO_TICKS(CONFIG_CAN_RTR_POLL_MS) > 0 ? pdMS_TO_TICKS(CONFIG_CAN_RTR_POLL_MS) : 1;
+    TickType_t start = xTaskGetTickCount();
+
+    while (true) {
+        if (mcp.checkReceive() && drain_rx(mcp, esp_timer_get_time())) {
+            return RtrWait::REQUESTED;
+        }
+        if (timeout != portMAX_DELAY && xTaskGetTickCount() - start >= timeout) {
+            return RtrWait::TIMED_OUT;
+        }
+        vTaskDelay(poll);
+    }
+#endif
+}
+#endif
+
 extern "C" void app_main(void) {
+    ESP_ERROR_CHECK(task_layout_init(TASK_TABLE, TASK_TABLE_COUNT));
+    // A saída do log fica no núcleo de manutenção; no laço do CAN um
+    // ESP_LOG só formata e copia a linha
+    ESP_ERROR_CHECK(task_layout_defer_logging(TASK_LOG, LOG_BUFFER_BYTES));
+    if (task_layout_adopt(TASK_CAN) != ESP_OK) {
+        ESP_LOGW(TAG, "Laço do CAN fora do núcleo de tempo real");
+    }
+
+#if !CONFIG_CAN_ULTRASONIC_MULTI
     gpio_config_t io_conf_trigger = {};
     io_conf_trigger.pin_bit_mask = (1ULL << TRIGGER_GPIO);
     io_conf_trigger.mode = GPIO_MODE_OUTPUT;
@@ -78,6 +475,7 @@ extern "C" void app_main(void) {
     io_conf_echo.pin_bit_mask = (1ULL << ECHO_GPIO);
     io_conf_echo.mode = GPIO_MODE_INPUT;
     gpio_config(&io_conf_echo);
+#endif
 
     spi_bus_config_t bus_cfg = {};
     bus_cfg.mosi_io_num = PIN_NUM_MOSI;
@@ -85,8 +483,20 @@ extern "C" void app_main(void) {
     bus_cfg.sclk_io_num = PIN_NUM_CLK;
     bus_cfg.quadwp_io_num = -1;
     bus_cfg.quadhd_io_num = -1;
+#if CONFIG_CAN_NFC
+    // O coordenador inicializa o barramento uma vez; cada driver adiciona
+    // o seu dispositivo, com CS e clock próprios
+    esp_err_t ret = spi_bus_coordinator_create(SPI2_HOST, &bus_cfg, SPI_DMA_CH_AUTO, &spi_bus);
+    ESP_ERROR_CHECK(ret);
+
+    spi_bus_client_config_t can_client_cfg = {};
+    can_client_cfg.name = "mcp2515";
+    can_client_cfg.priority = SPI_BUS_PRIORITY_HIGH;
+    ESP_ERROR_CHECK(spi_bus_coordinator_add_client(spi_bus, &can_client_cfg, &can_spi_client));
+#else
     esp_err_t ret = spi_bus_initialize(SPI2_HOST, &bus_cfg, SPI_DMA_CH_AUTO);
     ESP_ERROR_CHECK(ret);
+#endif
 
     spi_device_interface_config_t dev_cfg = {};
     dev_cfg.mode = 0;
@@ -96,55 +506,359 @@ extern "C" void app_main(void) {
     ret = spi_bus_add_device(SPI2_HOST, &dev_cfg, &spi_handle);
     ESP_ERROR_CHECK(ret);
 
-    MCP2515 mcp_can_controller(&spi_handle);
+#if CONFIG_CAN_NFC
+    CanSpiArbiter can_bus_arbiter = { can_spi_client };
+    CanController mcp_can_controller(EspSpiPollingTransport<CanSpiArbiter>(&spi_handle, can_bus_arbiter));
+#else
+    CanController mcp_can_controller(&spi_handle);
+#endif
 
     ESP_LOGI(TAG, "Resetando MCP2515...");
-    if (mcp_can_controller.reset() != MCP2515::ERROR_OK) {
+    if (mcp_can_controller.reset() != CanController::ERROR_OK) {
         ESP_LOGE(TAG, "Falha no reset do MCP2515!");
         while (1) { vTaskDelay(pdMS_TO_TICKS(1000)); }
     }
     vTaskDelay(pdMS_TO_TICKS(100));
 
     ESP_LOGI(TAG, "Configurando bitrate...");
-    if (mcp_can_controller.setBitrate(CAN_500KBPS, MCP_8MHZ) != MCP2515::ERROR_OK) {
+    if (mcp_can_controller.setBitrate(CAN_500KBPS, MCP_8MHZ) != CanController::ERROR_OK) {
         ESP_LOGE(TAG, "Erro na configuração do bitrate!");
         while (1) { vTaskDelay(pdMS_TO_TICKS(1000)); }
     }
 
+#if CONFIG_CAN_APP_BENCHMARK
+    uint32_t failures = can_bench_run(mcp_can_controller, CONFIG_CAN_BENCH_FRAMES_PER_DLC);
+    ESP_LOGI(TAG, "Benchmark concluído: %lu quadros perdidos ou corrompidos", (unsigned long)failures);
+    while (1) { vTaskDelay(pdMS_TO_TICKS(1000)); }
+#endif
+
+#if CAN_RX_ENABLED
+    ESP_LOGI(TAG, "Configurando filtros de recepção (ID 0x%X)...", CONFIG_CAN_NODE_ID);
+    if (configure_rx_filters(mcp_can_controller) != CanController::ERROR_OK) {
+        ESP_LOGE(TAG, "Falha ao configurar os filtros do MCP2515");
+        while (1) { vTaskDelay(pdMS_TO_TICKS(1000)); }
+    }
+#endif
+
+#if CONFIG_CAN_LOW_POWER
+    // CNF3 só aceita escrita em modo de configuração
+    if (mcp_can_controller.setWakeupFilter(true) != CanController::ERROR_OK) {
+        ESP_LOGE(TAG, "Falha ao ligar o filtro de despertar do MCP2515");
+        while (1) { vTaskDelay(pdMS_TO_TICKS(1000)); }
+    }
+#endif
+
+#if CONFIG_CAN_HEARTBEAT
+    // O MCP2515 ainda está em modo de configuração, exigido pelo TXRTSCTRL
+    ESP_LOGI(TAG, "Pré-carregando heartbeat (ID 0x%X) em TXB1/TXB2...", CONFIG_CAN_HEARTBEAT_ID);
+    PreloadedFrame heartbeat_frame(mcp_can_controller,
+                                   CanController::TXB1, (gpio_num_t)CONFIG_CAN_TX1RTS_GPIO,
+                                   CanController::TXB2, (gpio_num_t)CONFIG_CAN_TX2RTS_GPIO);
+    heartbeat = &heartbeat_frame;
+    struct can_frame hb_frame;
+    fill_heartbeat(&hb_frame, heartbeat_status);
+    if (heartbeat->begin(&hb_frame) != CanController::ERROR_OK) {
+        ESP_LOGE(TAG, "Falha ao pré-carregar o heartbeat");
+        while (1) { vTaskDelay(pdMS_TO_TICKS(1000)); }
+    }
+#endif
+
+#if CAN_RX_USES_INT
+    can_task = xTaskGetCurrentTaskHandle();
+
+    gpio_config_t io_conf_int = {};
+    io_conf_int.pin_bit_mask = (1ULL << CONFIG_CAN_INT_GPIO);
+    io_conf_int.mode = GPIO_MODE_INPUT;
+    io_conf_int.pull_up_en = GPIO_PULLUP_ENABLE;
+    io_conf_int.intr_type = GPIO_INTR_NEGEDGE;
+    gpio_config(&io_conf_int);
+    ESP_ERROR_CHECK(gpio_install_isr_service(0));
+    ESP_ERROR_CHECK(gpio_isr_handler_add((gpio_num_t)CONFIG_CAN_INT_GPIO, mcp2515_int_isr, NULL));
+#endif
+
     ESP_LOGI(TAG, "Configurando modo normal...");
-    if (mcp_can_controller.setNormalMode() != MCP2515::ERROR_OK) {
+    if (mcp_can_controller.setNormalMode() != CanController::ERROR_OK) {
         ESP_LOGE(TAG, "Falha ao configurar o modo normal do MCP2515");
         while (1) { vTaskDelay(pdMS_TO_TICKS(1000)); }
     }
 
-    struct can_frame tx_frame;
+#if CONFIG_CAN_HEARTBEAT
+    ESP_ERROR_CHECK(heartbeat->startTimer((uint32_t)CONFIG_CAN_HEARTBEAT_PERIOD_MS * 1000));
+#endif
+
+#if CONFIG_CAN_NFC
+    // O RC522 só entra no barramento depois de o MCP2515 estar configurado
+    if (nfc_reader_start(spi_bus, (gpio_num_t)CONFIG_CAN_NFC_CS_GPIO, (gpio_num_t)CONFIG_CAN_NFC_RST_GPIO,
+                         (gpio_num_t)CONFIG_CAN_NFC_IRQ_GPIO, CONFIG_CAN_NFC_MAX_HOLD_US,
+                         task_layout_get(TASK_RC522)) != ESP_OK) {
+        ESP_LOGE(TAG, "Leitor NFC indisponível; seguindo só com o CAN");
+    }
+    ESP_ERROR_CHECK(task_layout_create(TASK_SPI_STATS, spi_stats_task, NULL, NULL));
+#endif
+    ESP_ERROR_CHECK(task_layout_start_monitor(TASK_MONITOR));
+
+    uint8_t sequence = 0;
+
+#if CAN_RX_ENABLED
+    // Quadros recebidos antes do modo normal mantêm o INT baixo sem gerar borda
+    drain_rx(mcp_can_controller, esp_timer_get_time());
+#endif
+
+#if CONFIG_CAN_TX_PERIODIC && CONFIG_CAN_TIME_SYNC
+    // Amostragem no slot do nó, no tempo do mestre:
+    // início = k * ciclo + CAN_SYNC_SLOT * largura do slot
+    const int64_t cycle_us = (int64_t)CONFIG_CAN_SYNC_CYCLE_MS * 1000;
+    const int64_t slot_us = (int64_t)CONFIG_CAN_SYNC_SLOT_MS * 1000;
+    const int64_t slot_offset_us = (int64_t)CONFIG_CAN_SYNC_SLOT * slot_us;
+    const uint32_t slot_timeout_us = slot_us / 2 < ULTRASONIC_TIMEOUT_US ? slot_us / 2 : ULTRASONIC_TIMEOUT_US;
+
+    if (slot_offset_us + slot_us > cycle_us) {
+        ESP_LOGE(TAG, "Slot %d não cabe no ciclo de %d ms", CONFIG_CAN_SYNC_SLOT, CONFIG_CAN_SYNC_CYCLE_MS);
+        while (1) { vTaskDelay(pdMS_TO_TICKS(1000)); }
+    }
+
+    esp_timer_handle_t slot_timer;
+    esp_timer_create_args_t slot_timer_args = {};
+    slot_timer_args.callback = slot_timer_cb;
+    slot_timer_args.name = "sync_slot";
+    ESP_ERROR_CHECK(esp_timer_create(&slot_timer_args, &slot_timer));
+
+    bool armed = false;
+    int64_t slot_local_us = 0;
+    int64_t last_report_us = esp_timer_get_time();
+    TickType_t last_free_run = xTaskGetTickCount();
 
     while (1) {
-        float distance = measure_distance();
-        ESP_LOGI(TAG, "Distância medida: %.2f cm", distance);
+        if (!armed && time_sync.locked()) {
+            int64_t master_now = time_sync.toMaster(esp_timer_get_time());
+            int64_t next_slot = ((master_now - slot_offset_us) / cycle_us + 1) * cycle_us + slot_offset_us;
+            slot_local_us = time_sync.toLocal(next_slot);
 
-        if (distance >= MIN_DISTANCE_CM && distance <= MAX_DISTANCE_CM) {
-            memset(&tx_frame, 0, sizeof(struct can_frame));
-            tx_frame.can_id = 0x123;
+            int64_t delay_us = slot_local_us - esp_timer_get_time();
+            esp_timer_start_once(slot_timer, delay_us > 0 ? delay_us : 0);
+            armed = true;
+        }
 
-            tx_frame.can_dlc = 5; // 1 byte status + 4 bytes float
+        uint32_t bits = 0;
+        xTaskNotifyWait(0, UINT32_MAX, &bits, pdMS_TO_TICKS(CONFIG_CAN_TX_PERIOD_MS));
 
-            tx_frame.data[0] = 0x01; // Status ou código da mensagem
+        if (bits & NOTIFY_CAN_RX) {
+            drain_rx(mcp_can_controller, last_int_edge());
+        }
 
-            memcpy(&tx_frame.data[1], &distance, sizeof(float));
+        if (bits & NOTIFY_SLOT) {
+            armed = false;
+            time_sync.recordSlotError(esp_timer_get_time() - slot_local_us);
+            sample_and_send(mcp_can_controller, slot_timeout_us, &sequence);
+        } else if (!armed && xTaskGetTickCount() - last_free_run >= pdMS_TO_TICKS(CONFIG_CAN_TX_PERIOD_MS)) {
+            // Sem mestre (ou ainda travando): mantém a cadência livre
+            sample_and_send(mcp_can_controller, ULTRASONIC_TIMEOUT_US, &sequence);
+            last_free_run = xTaskGetTickCount();
+        }
+
+        if (esp_timer_get_time() - last_report_us >= TIME_SYNC_REPORT_US) {
+            TimeSyncStats st;
+            time_sync.takeStats(&st);
+            ESP_LOGI(TAG, "Sincronismo %s: %lu amostras | offset médio %.1f us, jitter %.1f us, máx %lld us | "
+                     "%lu reposicionamentos | deriva %.2f ppm | slot: %lu disparos, atraso médio %.1f us, máx %lld us",
+                     time_sync.locked() ? "travado" : "livre",
+                     (unsigned long)st.samples, st.offset_mean_us, st.offset_jitter_us, (long long)st.offset_max_us,
+                     (unsigned long)st.steps, st.drift_ppm,
+                     (unsigned long)st.slots, st.slot_mean_us, (long long)st.slot_max_us);
+            last_report_us = esp_timer_get_time();
+        }
+    }
+#elif CONFIG_CAN_ULTRASONIC_MULTI
+    UltrasonicScheduler scheduler(ULTRASONIC_SENSORS, ULTRASONIC_SENSOR_COUNT,
+                                  (uint32_t)CONFIG_CAN_ULTRASONIC_SLOT_MS * 1000);
+    if (scheduler.begin() != ESP_OK) {
+        ESP_LOGE(TAG, "Falha ao configurar o escalonador dos sensores");
+        while (1) { vTaskDelay(pdMS_TO_TICKS(1000)); }
+    }
 
-            if (mcp_can_controller.sendMessage(&tx_frame) == MCP2515::ERROR_OK) {
-                ESP_LOGI(TAG, "Mensagem CAN enviada. ID: 0x%lX, Distância: %.2f cm",
-                         (unsigned long)tx_frame.can_id, distance);
+    UltrasonicReading readings[ULTRASONIC_MAX_SENSORS];
+    uint32_t rounds = 0;
+    int64_t last_report_us = esp_timer_get_time();
+    TickType_t last_round = xTaskGetTickCount();
+
+    while (1) {
+        scheduler.runRound(readings);
+        send_packed_readings(mcp_can_controller, readings, scheduler.sensorCount(), sequence++);
+        rounds++;
+
+        int64_t now_us = esp_timer_get_time();
+        if (now_us - last_report_us >= SCHEDULER_REPORT_US) {
+            float seconds = (float)(now_us - last_report_us) / 1e6f;
+            ESP_LOGI(TAG, "Escalonador: %.1f rodadas/s, %.1f leituras/s (%u sensores, %u slots)",
+                     rounds / seconds, rounds * scheduler.sensorCount() / seconds,
+                     (unsigned)scheduler.sensorCount(), (unsigned)scheduler.slotCount());
+            rounds = 0;
+            last_report_us = now_us;
+        }
+
+        // Rodadas mais longas que o período emendam uma na outra
+        vTaskDelayUntil(&last_round, pdMS_TO_TICKS(CONFIG_CAN_TX_PERIOD_MS));
+    }
+#elif CONFIG_CAN_LOW_POWER
+    // Entre amostras o MCP2515 dorme com despertar pelo barramento e o
+    // ESP32 entra em sono leve. As leituras saem agrupadas a cada
+    // CAN_LOW_POWER_BATCH amostras; RTRs são atendidos na hora.
+    DutyCycle duty((gpio_num_t)CONFIG_CAN_INT_GPIO);
+    if (duty.begin() != ESP_OK) {
+        ESP_LOGE(TAG, "Falha ao configurar o sono leve");
+        while (1) { vTaskDelay(pdMS_TO_TICKS(1000)); }
+    }
+
+    const int64_t period_us = (int64_t)CONFIG_CAN_TX_PERIOD_MS * 1000;
+    const int64_t awake_window_us = (int64_t)CONFIG_CAN_LOW_POWER_AWAKE_MS * 1000;
+    UltrasonicReading batch[CONFIG_CAN_LOW_POWER_BATCH];
+    size_t batched = 0;
+    uint8_t batch_sequence = 0;
+    int64_t next_sample_us = esp_timer_get_time();
+    int64_t last_report_us = next_sample_us;
+
+    while (1) {
+        // Com o barramento ocupado o MCP2515 pode não dormir; o ESP32 dorme
+        // assim mesmo e acorda pelo INT se chegar um quadro para o nó
+        bool mcp_asleep = wait_tx_idle(mcp_can_controller, PACKED_TX_TIMEOUT_US) &&
+                          mcp_can_controller.setSleepMode(true) == CanController::ERROR_OK;
+
+        DutyCycle::Wake wake = duty.sleepUntil(next_sample_us);
+
+        if (mcp_asleep) {
+            // Acordado pelo barramento o MCP2515 fica em somente-escuta
+            mcp_can_controller.clearWAKIF();
+            if (mcp_can_controller.setNormalMode() != CanController::ERROR_OK) {
+                ESP_LOGE(TAG, "Falha ao acordar o MCP2515");
+            }
+        }
+
+        if (wake == DutyCycle::WAKE_BUS) {
+            // O quadro que acordou o MCP2515 não é recebido: fica acordado
+            // uma janela esperando a repetição do RTR
+            int64_t until = duty.wokeAt() + awake_window_us;
+            while (esp_timer_get_time() < until) {
+                if (gpio_get_level((gpio_num_t)CONFIG_CAN_INT_GPIO) == 0 &&
+                    drain_rx(mcp_can_controller, esp_timer_get_time())) {
+                    float distance = measure_distance(ULTRASONIC_TIMEOUT_US);
+                    if (send_reading(mcp_can_controller, reading_status(distance), distance, &sequence) == CanController::ERROR_OK &&
+                        wait_tx_idle(mcp_can_controller, PACKED_TX_TIMEOUT_US)) {
+                        duty.recordTransmit(esp_timer_get_time() - duty.wokeAt());
+                    }
+                    break;
+                }
+                ets_delay_us(LOW_POWER_POLL_US);
+            }
+        }
+
+        int64_t now_us = esp_timer_get_time();
+        if (now_us >= next_sample_us) {
+            batch[batched].fired_us = now_us;
+            batch[batched].distance_cm = measure_distance(ULTRASONIC_TIMEOUT_US);
+            batched++;
+
+            // Amostras perdidas numa janela acordada longa não são recuperadas
+            next_sample_us += period_us;
+            if (next_sample_us <= esp_timer_get_time()) {
+                next_sample_us = esp_timer_get_time() + period_us;
+            }
+
+            if (batched == CONFIG_CAN_LOW_POWER_BATCH) {
+                send_packed_readings(mcp_can_controller, batch, batched, batch_sequence++);
+                if (wait_tx_idle(mcp_can_controller, PACKED_TX_TIMEOUT_US)) {
+                    duty.recordTransmit(esp_timer_get_time() - duty.wokeAt());
+                }
+                batched = 0;
+            }
+        }
+
+        if (esp_timer_get_time() - last_report_us >= LOW_POWER_REPORT_US) {
+            DutyCycleStats st;
+            duty.takeStats(&st);
+            int64_t total_us = st.awake_us + st.asleep_us;
+            ESP_LOGI(TAG, "Ciclo de trabalho: acordado %.2f%% | despertares: %lu timer, %lu barramento | "
+                     "despertar->TX: %lu envios, média %lld us, máx %lld us | corrente média estimada %.0f uA",
+                     total_us > 0 ? 100.0 * (double)st.awake_us / (double)total_us : 0.0,
+                     (unsigned long)st.timer_wakes, (unsigned long)st.bus_wakes,
+                     (unsigned long)st.transmits,
+                     (long long)(st.transmits ? st.latency_sum_us / st.transmits : 0),
+                     (long long)st.latency_max_us, DutyCycle::averageCurrentUa(st));
+            last_report_us = esp_timer_get_time();
+        }
+    }
+#elif CONFIG_CAN_TX_PERIODIC
+    while (1) {
+        sample_and_send(mcp_can_controller, ULTRASONIC_TIMEOUT_US, &sequence);
+        vTaskDelay(pdMS_TO_TICKS(CONFIG_CAN_TX_PERIOD_MS));
+    }
+#else
+    // Resposta a RTR: a leitura sempre é enviada, com o status indicando se é válida
+#if CONFIG_CAN_TX_MIXED
+    const TickType_t background_period = pdMS_TO_TICKS(CONFIG_CAN_BACKGROUND_PERIOD_MS);
+    TickType_t next_push = xTaskGetTickCount() + background_period;
+#endif
+    uint32_t answered = 0;
+    uint32_t late = 0;
+    int64_t worst_response_us = 0;
+
+    while (1) {
+#if CONFIG_CAN_TX_MIXED
+        TickType_t now = xTaskGetTickCount();
+        TickType_t wait = (int32_t)(next_push - now) > 0 ? next_push - now : 0;
+#else
+        TickType_t wait = portMAX_DELAY;
+#endif
+
+        RtrWait got = wait_for_rtr(mcp_can_controller, wait);
+        if (got == RtrWait::WOKEN) {
+            // Sem RTR: volta a esperar pelo tempo que resta até o prazo
+            continue;
+        }
+
+        if (got == RtrWait::REQUESTED) {
+            int64_t requested_at = esp_timer_get_time();
+
+            // O eco tem duas fases; o orçamento restante é dividido entre elas
+            int64_t budget_us = (int64_t)CONFIG_CAN_RTR_DEADLINE_MS * 1000 - RTR_TX_MARGIN_US;
+            uint32_t timeout_us = budget_us > 0 ? (uint32_t)(budget_us / 2) : 0;
+            if (timeout_us > ULTRASONIC_TIMEOUT_US) {
+                timeout_us = ULTRASONIC_TIMEOUT_US;
+            }
+
+            float distance = measure_distance(timeout_us);
+            CanController::ERROR err = send_reading(mcp_can_controller, reading_status(distance), distance, &sequence);
+            int64_t response_us = esp_timer_get_time() - requested_at;
+
+            answered++;
+            if (response_us > worst_response_us) {
+                worst_response_us = response_us;
+            }
+            if (response_us > (int64_t)CONFIG_CAN_RTR_DEADLINE_MS * 1000) {
+                late++;
+            }
+
+            if (err == CanController::ERROR_OK) {
+                ESP_LOGI(TAG, "RTR atendido em %lld us (pior %lld us, %lu de %lu fora do prazo). Distância: %.2f cm",
+                         (long long)response_us, (long long)worst_response_us,
+                         (unsigned long)late, (unsigned long)answered, distance);
             } else {
+                ESP_LOGE(TAG, "Falha ao responder RTR.");
+            }
+
+#if CONFIG_CAN_TX_MIXED
+            // A resposta já atualizou os consumidores; adia o envio de fundo
+            next_push = xTaskGetTickCount() + background_period;
+#endif
+        }
+#if CONFIG_CAN_TX_MIXED
+        else {
+            float distance = measure_distance(ULTRASONIC_TIMEOUT_US);
+            if (send_reading(mcp_can_controller, reading_status(distance), distance, &sequence) != CanController::ERROR_OK) {
                 ESP_LOGE(TAG, "Falha ao enviar mensagem CAN.");
             }
-        } else if (distance < 0) {
-            ESP_LOGW(TAG, "Leitura inválida do sensor ultrassônico.");
-        } else if (distance > MAX_DISTANCE_CM) {
-            ESP_LOGW(TAG, "Distância fora do limite máximo de %.2f cm. Ignorada.", MAX_DISTANCE_CM);
+            next_push += background_period;
         }
-
-        vTaskDelay(pdMS_TO_TICKS(500));
+#endif
     }
+#endif
 }
\ No newline at end of file
@@ -0,0 +1,117 @@
+#include <stdlib.h>
+#include <string.h>
+
+#include "esp_log.h"
+#include "esp_timer.h"
+
+#include "can_bench.h"
+
+#define TAG "CAN_BENCH"
+
+// Quadros enviados e ainda não lidos. Em loopback a transmissão nunca falha,
+// então mais quadros em trânsito do que buffers de RX causariam overflow.
+#define BENCH_MAX_IN_FLIGHT 2
+
+// Sem envio nem recepção por este tempo, a rodada é encerrada
+#define BENCH_STALL_TIMEOUT_US 100000
+
+static void fill_payload(struct can_frame *frame, uint32_t seq, uint8_t dlc)
+{
+    memset(frame, 0, sizeof(struct can_frame));
+    frame->can_id = seq & CAN_BENCH_ID_MASK;
+    frame->can_dlc = dlc;
+    can_bench_fill_payload(frame->data, seq, dlc);
+}
+
+bool can_bench_run_dlc(CanController &mcp, uint8_t dlc, uint32_t frames, can_bench_result_t *result)
+{
+    can_bench_window_t window;
+    if (!can_bench_window_init(&window, result, dlc, frames, BENCH_MAX_IN_FLIGHT)) {
+        ESP_LOGE(TAG, "Sem memória para %lu latências", (unsigned long)frames);
+        return false;
+    }
+    result->has_spi = true;
+
+    if (mcp.setLoopbackMode() != CanController::ERROR_OK) {
+        ESP_LOGE(TAG, "Falha ao entrar em modo loopback");
+        can_bench_window_finish(&window, 0);
+        return false;
+    }
+
+    // Descarta quadros que tenham sobrado da rodada anterior
+    struct can_frame rx_frame;
+    while (mcp.readMessage(&rx_frame) == CanController::ERROR_OK) {
+    }
+
+    struct can_frame tx_frame;
+    bool tx_pending = false;
+
+    uint32_t spi_start = mcp.getSpiTransactionCount();
+    int64_t start = esp_timer_get_time();
+    int64_t last_progress = start;
+
+    while (result->received < frames) {
+        // Envia enquanto houver buffer de TX livre e espaço na janela
+        if (can_bench_window_can_send(&window)) {
+            if (!tx_pending) {
+                fill_payload(&tx_frame, can_bench_window_next_seq(&window), dlc);
+                tx_pending = true;
+            }
+
+            int64_t t0 = esp_timer_get_time();
+            CanController::ERROR err = mcp.sendMessage(&tx_frame);
+            int64_t t1 = esp_timer_get_time();
+            result->driver_us += t1 - t0;
+
+            if (err == CanController::ERROR_OK) {
+                can_bench_window_sent(&window, t0);
+                tx_pending = false;
+                last_progress = t1;
+            }
+        }
+
+        int64_t t0 = esp_timer_get_time();
+        CanController::ERROR err = mcp.readMessage(&rx_frame);
+        int64_t t1 = esp_timer_get_time();
+        result->driver_us += t1 - t0;
+
+        if (err == CanController::ERROR_OK) {
+            // Buffers de mesma prioridade podem sair fora de ordem
+            can_bench_window_received(&window, rx_frame.can_id, rx_frame.can_dlc, rx_frame.data, t1);
+            last_progress = t1;
+        } else if (t1 - last_progress > BENCH_STALL_TIMEOUT_US) {
+            ESP_LOGW(TAG, "DLC %u: sem progresso, %lu quadros não voltaram",
+                     dlc, (unsigned long)(result->sent - result->received));
+            break;
+        }
+    }
+
+    result->spi_transactions = mcp.getSpiTransactionCount() - spi_start;
+    can_bench_window_finish(&window, esp_timer_get_time() - start);
+    return true;
+}
+
+void can_bench_print(const can_bench_result_t *r)
+{
+    char line[256];
+    can_bench_format(r, line, sizeof(line));
+    ESP_LOGI(TAG, "%s", line);
+}
+
+uint32_t can_bench_run(CanController &mcp, uint32_t frames_per_dlc)
+{
+    uint32_t failures = 0;
+
+    ESP_LOGI(TAG, "Benchmark em loopback: %lu quadros por DLC", (unsigned long)frames_per_dlc);
+
+    for (uint8_t dlc = 0; dlc <= CAN_MAX_DLEN; dlc++) {
+        can_bench_result_t result;
+        if (!can_bench_run_dlc(mcp, dlc, frames_per_dlc, &result)) {
+            return frames_per_dlc * (CAN_MAX_DLEN + 1);
+        }
+        can_bench_print(&result);
+        failures += (frames_per_dlc - result.received) + result.corrupted;
+    }
+
+    return failures;
+}
@@ -0,0 +1,8 @@
+#include "can_controller.h"
+
+#if CONFIG_CAN_NFC
+#include "mcp2515_impl.h"
+
+// O componente só instancia os transportes sem árbitro
+template class MCP2515<EspSpiPollingTransport<CanSpiArbiter> >;
+#endif
@@ -0,0 +1,125 @@
+#include "esp_log.h"
+#include "esp_rom_sys.h"
+
+#include "can_preload.h"
+
+#define TAG "CAN_PRELOAD"
+
+// Largura do pulso no TXnRTS, folgada para o clock de 8 MHz do MCP2515
+#define RTS_PULSE_US 1
+
+#define TIMER_RESOLUTION_HZ 1000000
+
+PreloadedFrame::PreloadedFrame(CanController &mcp,
+                               CanController::TXBn txb_a, gpio_num_t rts_a,
+                               CanController::TXBn txb_b, gpio_num_t rts_b)
+    : mcp(mcp), mux(portMUX_INITIALIZER_UNLOCKED), active(0), triggers(0), updates(0), timer(NULL)
+{
+    txb[0] = txb_a;
+    txb[1] = txb_b;
+    rts[0] = rts_a;
+    rts[1] = rts_b;
+}
+
+CanController::ERROR PreloadedFrame::begin(const struct can_frame *frame)
+{
+    // Pinos em repouso (alto) antes de o MCP2515 passar a observá-los
+    gpio_config_t io_conf = {};
+    io_conf.pin_bit_mask = (1ULL << rts[0]) | (1ULL << rts[1]);
+    io_conf.mode = GPIO_MODE_OUTPUT;
+    gpio_set_level(rts[0], 1);
+    gpio_set_level(rts[1], 1);
+    gpio_config(&io_conf);
+
+    CanController::ERROR err;
+    for (int i = 0; i < 2; i++) {
+        if ((err = mcp.setTxRtsPin(txb[i], true)) != CanController::ERROR_OK ||
+            (err = mcp.preloadMessage(txb[i], frame)) != CanController::ERROR_OK) {
+            ESP_LOGE(TAG, "Falha ao reservar TXB%d para o TXnRTS", txb[i]);
+            return err;
+        }
+    }
+
+    active = 0;
+    return CanController::ERROR_OK;
+}
+
+CanController::ERROR PreloadedFrame::update(const struct can_frame *frame)
+{
+    uint8_t inactive = active ^ 1;
+
+    // Nenhum disparo usa o buffer inativo: a troca abaixo e o pulso em
+    // trigger() acontecem sob o mesmo spinlock.
+    CanController::ERROR err = mcp.preloadMessage(txb[inactive], frame);
+    if (err != CanController::ERROR_OK) {
+        return err;
+    }
+
+    portENTER_CRITICAL(&mux);
+    active = inactive;
+    portEXIT_CRITICAL(&mux);
+
+    updates++;
+    return CanController::ERROR_OK;
+}
+
+void PreloadedFrame::trigger(void)
+{
+    portENTER_CRITICAL_SAFE(&mux);
+    gpio_num_t pin = rts[active];
+    gpio_set_level(pin, 0);
+    esp_rom_delay_us(RTS_PULSE_US);
+    gpio_set_level(pin, 1);
+    triggers = triggers + 1;
+    portEXIT_CRITICAL_SAFE(&mux);
+}
+
+bool PreloadedFrame::onAlarm(gptimer_handle_t timer, const gptimer_alarm_event_data_t *event, void *ctx)
+{
+    static_cast<PreloadedFrame *>(ctx)->trigger();
+    return false;
+}
+
+esp_err_t PreloadedFrame::startTimer(uint32_t period_us)
+{
+    if (timer == NULL) {
+        gptimer_config_t timer_config = {};
+        timer_config.clk_src = GPTIMER_CLK_SRC_DEFAULT;
+        timer_config.direction = GPTIMER_COUNT_UP;
+        timer_config.resolution_hz = TIMER_RESOLUTION_HZ;
+        esp_err_t ret = gptimer_new_timer(&timer_config, &timer);
+        if (ret != ESP_OK) {
+            timer = NULL;
+            return ret;
+        }
+
+        gptimer_event_callbacks_t cbs = {};
+        cbs.on_alarm = onAlarm;
+        if ((ret = gptimer_register_event_callbacks(timer, &cbs, this)) != ESP_OK ||
+            (ret = gptimer_enable(timer)) != ESP_OK) {
+            gptimer_del_timer(timer);
+            timer = NULL;
+            return ret;
+        }
+    }
+
+    gptimer_alarm_config_t alarm_config = {};
+    alarm_config.alarm_count = period_us;
+    alarm_config.reload_count = 0;
+    alarm_config.flags.auto_reload_on_alarm = true;
+
+    esp_err_t ret = gptimer_set_alarm_action(timer, &alarm_config);
+    if (ret != ESP_OK) {
+        return ret;
+    }
+    gptimer_set_raw_count(timer, 0);
+    return gptimer_start(timer);
+}
+
+esp_err_t PreloadedFrame::stopTimer(void)
+{
+    if (timer == NULL) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    return gptimer_stop(timer);
+}
@@ -0,0 +1,112 @@
+#include <string.h>
+
+#include "driver/uart.h"
+#include "esp_log.h"
+#include "esp_sleep.h"
+#include "esp_timer.h"
+
+#include "duty_cycle.h"
+
+#define TAG "DUTY_CYCLE"
+
+// Abaixo disso não compensa dormir: entrar e sair do sono leve leva
+// algumas centenas de microssegundos
+#define MIN_SLEEP_US 1000
+
+DutyCycle::DutyCycle(gpio_num_t int_pin)
+    : int_pin(int_pin), woke_us(0), awake_since_us(0)
+{
+    memset(&stats, 0, sizeof(stats));
+}
+
+esp_err_t DutyCycle::begin(void)
+{
+    gpio_config_t io_conf = {};
+    io_conf.pin_bit_mask = (1ULL << int_pin);
+    io_conf.mode = GPIO_MODE_INPUT;
+    io_conf.pull_up_en = GPIO_PULLUP_ENABLE;
+    esp_err_t err = gpio_config(&io_conf);
+    if (err != ESP_OK) {
+        return err;
+    }
+
+    // INT do MCP2515 é ativo em nível baixo
+    if ((err = gpio_wakeup_enable(int_pin, GPIO_INTR_LOW_LEVEL)) != ESP_OK ||
+        (err = esp_sleep_enable_gpio_wakeup()) != ESP_OK) {
+        ESP_LOGE(TAG, "Falha ao configurar o despertar pelo GPIO %d", int_pin);
+        return err;
+    }
+
+    woke_us = esp_timer_get_time();
+    awake_since_us = woke_us;
+    return ESP_OK;
+}
+
+DutyCycle::Wake DutyCycle::sleepUntil(int64_t wake_at_us)
+{
+    Wake wake = WAKE_TIMER;
+    int64_t now = esp_timer_get_time();
+
+    if (gpio_get_level(int_pin) == 0) {
+        wake = WAKE_BUS;
+    } else if (wake_at_us - now >= MIN_SLEEP_US) {
+        // O log pendente no UART se perderia durante o sono
+        uart_wait_tx_idle_polling((uart_port_t)CONFIG_ESP_CONSOLE_UART_NUM);
+
+        int64_t slept_at = esp_timer_get_time();
+        stats.awake_us += slept_at - awake_since_us;
+        esp_sleep_enable_timer_wakeup(wake_at_us > slept_at ? (uint64_t)(wake_at_us - slept_at) : 1);
+        esp_light_sleep_start();
+        awake_since_us = esp_timer_get_time();
+        stats.asleep_us += awake_since_us - slept_at;
+
+        if (esp_sleep_get_wakeup_cause() == ESP_SLEEP_WAKEUP_GPIO) {
+            wake = WAKE_BUS;
+        }
+    } else {
+        // Curto demais para dormir: espera acordado
+        while (esp_timer_get_time() < wake_at_us && gpio_get_level(int_pin) != 0) {
+        }
+        if (gpio_get_level(int_pin) == 0) {
+            wake = WAKE_BUS;
+        }
+    }
+
+    woke_us = esp_timer_get_time();
+    if (wake == WAKE_BUS) {
+        stats.bus_wakes++;
+    } else {
+        stats.timer_wakes++;
+    }
+    return wake;
+}
+
+void DutyCycle::recordTransmit(int64_t latency_us)
+{
+    stats.transmits++;
+    stats.latency_sum_us += latency_us;
+    if (latency_us > stats.latency_max_us) {
+        stats.latency_max_us = latency_us;
+    }
+}
+
+void DutyCycle::takeStats(DutyCycleStats *out)
+{
+    int64_t now = esp_timer_get_time();
+    stats.awake_us += now - awake_since_us;
+    awake_since_us = now;
+
+    *out = stats;
+    memset(&stats, 0, sizeof(stats));
+}
+
+float DutyCycle::averageCurrentUa(const DutyCycleStats &s)
+{
+    int64_t total = s.awake_us + s.asleep_us;
+    if (total <= 0) {
+        return 0.0f;
+    }
+    double awake = (double)s.awake_us * (DUTY_ESP32_ACTIVE_UA + DUTY_MCP2515_ACTIVE_UA);
+    double asleep = (double)s.asleep_us * (DUTY_ESP32_LIGHT_SLEEP_UA + DUTY_MCP2515_SLEEP_UA);
+    return (float)((awake + asleep) / (double)total);
+}
@@ -0,0 +1,138 @@
+#include "esp_log.h"
+#include "rc522.h"
+#include "driver/rc522_spi.h"
+#include "rc522_picc.h"
+
+#include "nfc_reader.h"
+
+static const char *TAG = "NFC";
+
+// Relógio inicial do RC522, como no projeto NFC; a calibração no rc522_start
+// sobe até 10 MHz se o cabo aguentar
+#define NFC_SPI_CLOCK_HZ 5000000
+
+static spi_bus_client_handle_t nfc_client;
+static rc522_driver_handle_t nfc_driver;
+static rc522_handle_t nfc_scanner;
+static rc522_driver_stats_t last_stats;
+static rc522_shadow_stats_t last_shadow;
+
+static esp_err_t nfc_bus_acquire(void *ctx)
+{
+    return spi_bus_client_acquire((spi_bus_client_handle_t)ctx, portMAX_DELAY);
+}
+
+static void nfc_bus_release(void *ctx)
+{
+    spi_bus_client_release((spi_bus_client_handle_t)ctx);
+}
+
+static void on_picc_state_changed(void *arg, esp_event_base_t base, int32_t event_id, void *data)
+{
+    rc522_picc_state_changed_event_t *event = (rc522_picc_state_changed_event_t *)data;
+    rc522_picc_t *picc = event->picc;
+
+    if (picc->state == RC522_PICC_STATE_ACTIVE) {
+        char uid[RC522_PICC_UID_STR_BUFFER_SIZE_MAX];
+        rc522_picc_uid_to_str(&picc->uid, uid, sizeof(uid));
+        ESP_LOGI(TAG, "Cartão detectado: UID %s", uid);
+    } else if (picc->state == RC522_PICC_STATE_IDLE && event->old_state >= RC522_PICC_STATE_ACTIVE) {
+        ESP_LOGI(TAG, "Cartão removido");
+    }
+}
+
+esp_err_t nfc_reader_start(spi_bus_coordinator_handle_t bus, gpio_num_t cs_gpio, gpio_num_t rst_gpio,
+                           gpio_num_t irq_gpio, uint32_t max_hold_us, const task_layout_entry_t *task)
+{
+    if (task == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    spi_bus_client_config_t client_cfg = {};
+    client_cfg.name = "rc522";
+    client_cfg.priority = SPI_BUS_PRIORITY_LOW;
+    client_cfg.max_hold_us = max_hold_us;
+
+    esp_err_t err = spi_bus_coordinator_add_client(bus, &client_cfg, &nfc_client);
+    if (err != ESP_OK) {
+        return err;
+    }
+
+    // Sem bus_config o driver não inicializa o barramento, que já é do coordenador
+    rc522_spi_config_t driver_cfg = {};
+    driver_cfg.host_id = spi_bus_coordinator_host(bus);
+    driver_cfg.bus_config = NULL;
+    driver_cfg.dev_config.spics_io_num = cs_gpio;
+    driver_cfg.dev_config.clock_speed_hz = NFC_SPI_CLOCK_HZ;
+    driver_cfg.rst_io_num = rst_gpio;
+    driver_cfg.bus_acquire = nfc_bus_acquire;
+    driver_cfg.bus_release = nfc_bus_release;
+    driver_cfg.bus_ctx = nfc_client;
+
+    if ((err = rc522_spi_create(&driver_cfg, &nfc_driver)) != ESP_OK ||
+        (err = rc522_driver_install(nfc_driver)) != ESP_OK) {
+        ESP_LOGE(TAG, "Falha ao instalar o driver do RC522: %s", esp_err_to_name(err));
+        return err;
+    }
+
+    rc522_config_t scanner_cfg = {};
+    scanner_cfg.driver = nfc_driver;
+    scanner_cfg.poll_interval_ms = task->period_ms;
+    scanner_cfg.task_stack_size = task->stack_size;
+    scanner_cfg.task_priority = task->priority;
+    scanner_cfg.task_pinned = task->core_id != tskNO_AFFINITY;
+    scanner_cfg.task_core_id = task->core_id;
+    scanner_cfg.irq_enabled = irq_gpio >= 0;
+    scanner_cfg.irq_io_num = irq_gpio;
+    scanner_cfg.clock_calibration = true;
+    // rc522_start_all com um leitor só: mesmo caminho de reset dos painéis
+    // com vários leitores, e já informa o tempo até o leitor ficar pronto
+    rc522_start_result_t started = {};
+    if ((err = rc522_create(&scanner_cfg, &nfc_scanner)) != ESP_OK ||
+        (err = rc522_register_events(nfc_scanner, RC522_EVENT_PICC_STATE_CHANGED,
+                                     on_picc_state_changed, NULL)) != ESP_OK ||
+        (err = rc522_start_all(&nfc_scanner, 1, &started)) != ESP_OK) {
+        if (started.err != ESP_OK) {
+            err = started.err;
+        }
+        ESP_LOGE(TAG, "Falha ao iniciar o leitor RC522: %s", esp_err_to_name(err));
+        return err;
+    }
+    task_layout_attach(task->name, rc522_task_handle(nfc_scanner));
+
+    uint32_t clock_hz = 0;
+    rc522_driver_get_clock(nfc_driver, &clock_hz);
+    ESP_LOGI(TAG, "RC522 no SPI compartilhado (CS %d, IRQ %d, %lu kHz, posse máxima %lu us, pronto em %lu us)",
+             cs_gpio, irq_gpio, (unsigned long)(clock_hz / 1000), (unsigned long)max_hold_us,
+             (unsigned long)started.ready_us);
+    return ESP_OK;
+}
+
+void nfc_reader_log_stats(void)
+{
+    rc522_driver_stats_t now;
+    rc522_shadow_stats_t shadow;
+    if (nfc_driver == NULL || rc522_driver_get_stats(nfc_driver, &now) != ESP_OK ||
+        rc522_shadow_stats(nfc_scanner, &shadow) != ESP_OK) {
+        return;
+    }
+
+    uint32_t reads = now.reads - last_stats.reads;
+    uint32_t bytes = now.read_bytes - last_stats.read_bytes;
+    uint32_t transactions = now.read_transactions - last_stats.read_transactions;
+    uint32_t writes = now.writes - last_stats.writes;
+    uint32_t write_bytes = now.write_bytes - last_stats.write_bytes;
+    uint32_t bus_us = now.bus_us - last_stats.bus_us;
+    uint32_t hits = shadow.hits - last_shadow.hits;
+    uint32_t misses = shadow.misses - last_shadow.misses;
+    last_stats = now;
+    last_shadow = shadow;
+
+    ESP_LOGI(TAG, "%lu leituras, %lu bytes | %.2f transações SPI por leitura | sombra: %lu acertos, %lu faltas",
+             (unsigned long)reads, (unsigned long)bytes, reads ? (double)transactions / reads : 0.0,
+             (unsigned long)hits, (unsigned long)misses);
+    // Vazão efetiva do barramento, para comparar drivers (SPI x I2C, rajada x byte a byte)
+    ESP_LOGI(TAG, "%lu escritas, %lu bytes | barramento ocupado %lu us, %.1f kB/s", (unsigned long)writes,
+             (unsigned long)write_bytes, (unsigned long)bus_us,
+             bus_us ? (double)(bytes + write_bytes) * 1000.0 / bus_us : 0.0);
+}
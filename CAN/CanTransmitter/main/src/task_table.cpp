@@ -0,0 +1,22 @@
+#include "sdkconfig.h"
+#include "task_table.h"
+
+/*
+ * Núcleo de tempo real: o laço do CAN roda em app_main, fixo no núcleo 0
+ * por CONFIG_ESP_MAIN_TASK_AFFINITY, e drena o INT do MCP2515. As ISRs do
+ * INT, do RMT e do gptimer são instaladas por ele e atendidas no mesmo
+ * núcleo, assim como a tarefa do esp_timer (slots, heartbeat, sono).
+ *
+ * Núcleo de manutenção: varredura do RC522, saída do log, relatórios e o
+ * monitor, que confere a pilha e o orçamento de CPU de cada entrada.
+ */
+const task_layout_entry_t TASK_TABLE[] = {
+    // nome          núcleo                         prio  pilha (B)                        período (ms)  CPU (%)
+    { TASK_CAN,       TASK_LAYOUT_CORE_RT,            10, CONFIG_ESP_MAIN_TASK_STACK_SIZE,     0,          50 },
+    { TASK_RC522,     TASK_LAYOUT_CORE_HOUSEKEEPING,   4, 4096,                              120,          20 },
+    { TASK_LOG,       TASK_LAYOUT_CORE_HOUSEKEEPING,   2, 3072,                                0,          10 },
+    { TASK_SPI_STATS, TASK_LAYOUT_CORE_HOUSEKEEPING,   1, 3072,                            10000,           2 },
+    { TASK_MONITOR,   TASK_LAYOUT_CORE_HOUSEKEEPING,   1, 3072,                            30000,           2 },
+};
+
+const size_t TASK_TABLE_COUNT = sizeof(TASK_TABLE) / sizeof(TASK_TABLE[0]);
@@ -0,0 +1,168 @@
+#include <math.h>
+#include <string.h>
+
+#include "time_sync.h"
+
+// Ganhos do laço de controle por amostra: fase (proporcional) e frequência (integral)
+#define SERVO_KP 0.3
+#define SERVO_KI 0.02
+
+static int64_t abs64(int64_t v)
+{
+    return v < 0 ? -v : v;
+}
+
+TimeSyncFollower::TimeSyncFollower()
+{
+    reset();
+}
+
+void TimeSyncFollower::reset(void)
+{
+    refLocal = 0;
+    refMaster = 0;
+    rate = 0;
+    started = false;
+    goodSamples = 0;
+    syncCounter = 0;
+    syncLocal = 0;
+    syncPending = false;
+
+    clearStats();
+}
+
+void TimeSyncFollower::clearStats(void)
+{
+    nOffset = 0;
+    sumOffset = 0;
+    sumOffset2 = 0;
+    maxOffset = 0;
+    nSteps = 0;
+    nSlot = 0;
+    sumSlot = 0;
+    maxSlot = 0;
+}
+
+bool TimeSyncFollower::onSync(const struct can_frame *frame, int64_t local_us)
+{
+    if (frame->can_id != TIME_SYNC_COB_ID || frame->can_dlc < 1) {
+        return false;
+    }
+
+    syncCounter = frame->data[0];
+    syncLocal = local_us;
+    syncPending = true;
+    return true;
+}
+
+bool TimeSyncFollower::onTime(const struct can_frame *frame)
+{
+    if (frame->can_id != TIME_TIME_COB_ID || frame->can_dlc < 8) {
+        return false;
+    }
+
+    // TIME de um SYNC que não foi visto (ou já usado) não serve
+    if (!syncPending || frame->data[0] != syncCounter) {
+        return false;
+    }
+    syncPending = false;
+
+    int64_t master_us = 0;
+    for (int i = 7; i >= 1; i--) {
+        master_us = (master_us << 8) | frame->data[i];
+    }
+
+    apply(syncLocal, master_us);
+    return true;
+}
+
+void TimeSyncFollower::apply(int64_t local_us, int64_t master_us)
+{
+    if (!started) {
+        refLocal = local_us;
+        refMaster = master_us;
+        started = true;
+        return;
+    }
+
+    int64_t predicted = toMaster(local_us);
+    int64_t error = master_us - predicted;
+
+    if (abs64(error) > TIME_SYNC_STEP_US) {
+        refLocal = local_us;
+        refMaster = master_us;
+        goodSamples = 0;
+        nSteps++;
+        return;
+    }
+
+    int64_t interval = local_us - refLocal;
+    if (interval > 0) {
+        rate += SERVO_KI * (double)error / (double)interval;
+    }
+
+    // Reancora no SYNC atual com a fase parcialmente corrigida
+    refMaster = predicted + (int64_t)(SERVO_KP * error);
+    refLocal = local_us;
+
+    if (abs64(error) <= TIME_SYNC_LOCK_US) {
+        goodSamples++;
+    } else {
+        goodSamples = 0;
+    }
+
+    nOffset++;
+    sumOffset += error;
+    sumOffset2 += (double)error * error;
+    if (abs64(error) > maxOffset) {
+        maxOffset = abs64(error);
+    }
+}
+
+bool TimeSyncFollower::locked(void) const
+{
+    return started && goodSamples >= TIME_SYNC_LOCK_SAMPLES;
+}
+
+int64_t TimeSyncFollower::toMaster(int64_t local_us) const
+{
+    int64_t elapsed = local_us - refLocal;
+    return refMaster + elapsed + (int64_t)llround(elapsed * rate);
+}
+
+int64_t TimeSyncFollower::toLocal(int64_t master_us) const
+{
+    int64_t elapsed = master_us - refMaster;
+    return refLocal + (int64_t)llround(elapsed / (1.0 + rate));
+}
+
+void TimeSyncFollower::recordSlotError(int64_t error_us)
+{
+    nSlot++;
+    sumSlot += error_us;
+    if (abs64(error_us) > maxSlot) {
+        maxSlot = abs64(error_us);
+    }
+}
+
+void TimeSyncFollower::takeStats(TimeSyncStats *stats)
+{
+    memset(stats, 0, sizeof(TimeSyncStats));
+    stats->samples = nOffset;
+    stats->steps = nSteps;
+    stats->drift_ppm = rate * 1e6;
+    stats->offset_max_us = maxOffset;
+    if (nOffset > 0) {
+        stats->offset_mean_us = sumOffset / nOffset;
+        double variance = sumOffset2 / nOffset - stats->offset_mean_us * stats->offset_mean_us;
+        stats->offset_jitter_us = variance > 0 ? sqrt(variance) : 0;
+    }
+
+    stats->slots = nSlot;
+    stats->slot_max_us = maxSlot;
+    if (nSlot > 0) {
+        stats->slot_mean_us = sumSlot / nSlot;
+    }
+
+    clearStats();
+}
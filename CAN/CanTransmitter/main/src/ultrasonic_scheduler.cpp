@@ -0,0 +1,186 @@
+#include <string.h>
+
+#include "esp_log.h"
+#include "esp_rom_sys.h"
+
+#include "ultrasonic_scheduler.h"
+
+#define TAG "ULTRASONIC_SCHED"
+
+#define RMT_RESOLUTION_HZ 1000000 // 1 tick = 1 us
+
+// Largura do pulso de disparo exigida pelo HC-SR04
+#define TRIGGER_PULSE_US 10
+
+// Pulsos mais curtos são ruído; o filtro do RMT vai até ~3 us no ESP32
+#define ECHO_MIN_NS 2000
+
+// O limiar de ociosidade do RMT tem 15 bits: 32767 ticks de 1 us
+#define ECHO_MAX_US 32000
+
+// Atraso do HC-SR04 entre o fim do disparo e a subida do eco (~450 us)
+#define ECHO_DELAY_US 500
+
+static uint32_t max_echo_for_slot(uint32_t slot_us)
+{
+    uint32_t width = slot_us > ECHO_DELAY_US ? (slot_us - ECHO_DELAY_US) / 2 : 0;
+    return width < ECHO_MAX_US ? width : ECHO_MAX_US;
+}
+
+UltrasonicScheduler::UltrasonicScheduler(const UltrasonicSensor *sensors, size_t count, uint32_t slot_us)
+    : sensors(sensors), count(count), slots(0), slot_us(slot_us),
+      max_echo_us(max_echo_for_slot(slot_us)), slot_timer(NULL), slot_end(NULL)
+{
+    memset(channels, 0, sizeof(channels));
+}
+
+esp_err_t UltrasonicScheduler::begin(void)
+{
+    if (max_echo_us == 0) {
+        ESP_LOGE(TAG, "Slot de %lu us curto demais", (unsigned long)slot_us);
+        return ESP_ERR_INVALID_ARG;
+    }
+    if (count == 0 || count > ULTRASONIC_MAX_SENSORS) {
+        ESP_LOGE(TAG, "%u sensores; o máximo é %d", (unsigned)count, ULTRASONIC_MAX_SENSORS);
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    slot_end = xSemaphoreCreateBinary();
+    if (slot_end == NULL) {
+        return ESP_ERR_NO_MEM;
+    }
+
+    esp_timer_create_args_t timer_args = {};
+    timer_args.callback = onSlotEnd;
+    timer_args.arg = this;
+    timer_args.name = "ultrasonic_slot";
+    esp_err_t err = esp_timer_create(&timer_args, &slot_timer);
+    if (err != ESP_OK) {
+        return err;
+    }
+
+    for (size_t i = 0; i < count; i++) {
+        if (sensors[i].slot + 1u > slots) {
+            slots = sensors[i].slot + 1u;
+        }
+
+        gpio_config_t io_conf = {};
+        io_conf.pin_bit_mask = (1ULL << sensors[i].trigger);
+        io_conf.mode = GPIO_MODE_OUTPUT;
+        gpio_set_level(sensors[i].trigger, 0);
+        gpio_config(&io_conf);
+
+        rmt_rx_channel_config_t rx_config = {};
+        rx_config.gpio_num = sensors[i].echo;
+        rx_config.clk_src = RMT_CLK_SRC_DEFAULT;
+        rx_config.resolution_hz = RMT_RESOLUTION_HZ;
+        rx_config.mem_block_symbols = SYMBOLS;
+
+        EchoChannel *ch = &channels[i];
+        ch->owner = this;
+        rmt_rx_event_callbacks_t callbacks = {};
+        callbacks.on_recv_done = onEcho;
+
+        if ((err = rmt_new_rx_channel(&rx_config, &ch->rx)) != ESP_OK ||
+            (err = rmt_rx_register_event_callbacks(ch->rx, &callbacks, ch)) != ESP_OK ||
+            (err = rmt_enable(ch->rx)) != ESP_OK) {
+            ESP_LOGE(TAG, "Falha ao configurar o RMT do eco no GPIO %d", sensors[i].echo);
+            return err;
+        }
+    }
+
+    ESP_LOGI(TAG, "%u sensores em %u slots de %lu us: rodada de %lu us, eco máximo %lu us",
+             (unsigned)count, (unsigned)slots, (unsigned long)slot_us, (unsigned long)roundUs(),
+             (unsigned long)max_echo_us);
+    return ESP_OK;
+}
+
+// Fim da recepção: a linha ficou parada por max_echo_us. A largura do eco
+// é o primeiro trecho em nível alto. Roda na interrupção do RMT.
+bool IRAM_ATTR UltrasonicScheduler::onEcho(rmt_channel_handle_t rx, const rmt_rx_done_event_data_t *edata, void *ctx)
+{
+    EchoChannel *ch = (EchoChannel *)ctx;
+    uint32_t width = 0;
+
+    for (size_t i = 0; i < edata->num_symbols && width == 0; i++) {
+        const rmt_symbol_word_t *s = &edata->received_symbols[i];
+        if (s->level0) {
+            width = s->duration0;
+        } else if (s->level1) {
+            width = s->duration1;
+        }
+    }
+
+    ch->width_us = width;
+    ch->done = true;
+    return false;
+}
+
+void UltrasonicScheduler::onSlotEnd(void *arg)
+{
+    UltrasonicScheduler *self = (UltrasonicScheduler *)arg;
+    xSemaphoreGive(self->slot_end);
+}
+
+void UltrasonicScheduler::fireSlot(uint8_t slot, UltrasonicReading *readings)
+{
+    rmt_receive_config_t receive_config = {};
+    receive_config.signal_range_min_ns = ECHO_MIN_NS;
+    receive_config.signal_range_max_ns = max_echo_us * 1000;
+
+    // Arma a captura de todos os ecos antes do disparo
+    uint64_t trigger_mask = 0;
+    for (size_t i = 0; i < count; i++) {
+        if (sensors[i].slot != slot) {
+            continue;
+        }
+        channels[i].done = false;
+        channels[i].width_us = 0;
+        if (rmt_receive(channels[i].rx, channels[i].symbols, sizeof(channels[i].symbols), &receive_config) == ESP_OK) {
+            trigger_mask |= 1ULL << i;
+        }
+    }
+
+    // Disparo simultâneo do slot
+    for (size_t i = 0; i < count; i++) {
+        if (trigger_mask & (1ULL << i)) {
+            gpio_set_level(sensors[i].trigger, 1);
+        }
+    }
+    esp_rom_delay_us(TRIGGER_PULSE_US);
+    for (size_t i = 0; i < count; i++) {
+        if (trigger_mask & (1ULL << i)) {
+            gpio_set_level(sensors[i].trigger, 0);
+        }
+    }
+    int64_t fired_us = esp_timer_get_time();
+
+    // O slot dura slot_us mesmo que os ecos terminem antes: reflexões
+    // tardias precisam se extinguir antes do próximo grupo
+    esp_timer_start_once(slot_timer, slot_us);
+    xSemaphoreTake(slot_end, portMAX_DELAY);
+
+    for (size_t i = 0; i < count; i++) {
+        if (sensors[i].slot != slot) {
+            continue;
+        }
+        readings[i].fired_us = fired_us;
+        if ((trigger_mask & (1ULL << i)) && channels[i].done && channels[i].width_us > 0) {
+            readings[i].distance_cm = (float)channels[i].width_us * 0.0343f / 2.0f;
+        } else {
+            readings[i].distance_cm = -1.0f;
+            // Recepção ainda armada (sem eco): reinicia o canal
+            if (trigger_mask & (1ULL << i)) {
+                rmt_disable(channels[i].rx);
+                rmt_enable(channels[i].rx);
+            }
+        }
+    }
+}
+
+void UltrasonicScheduler::runRound(UltrasonicReading *readings)
+{
+    for (size_t slot = 0; slot < slots; slot++) {
+        fireSlot((uint8_t)slot, readings);
+    }
+}
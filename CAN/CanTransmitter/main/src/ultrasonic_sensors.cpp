@@ -0,0 +1,12 @@
+#include "ultrasonic_scheduler.h"
+
+// Sensores do nó. Frente e trás não se ouvem e disparam juntos no slot 0;
+// as laterais ficam no slot 1. O primeiro par é o TRIGGER/ECHO original.
+const UltrasonicSensor ULTRASONIC_SENSORS[] = {
+    {GPIO_NUM_12, GPIO_NUM_13, 0}, // frente
+    {GPIO_NUM_14, GPIO_NUM_34, 0}, // trás
+    {GPIO_NUM_27, GPIO_NUM_35, 1}, // esquerda
+    {GPIO_NUM_32, GPIO_NUM_39, 1}, // direita
+};
+
+const size_t ULTRASONIC_SENSOR_COUNT = sizeof(ULTRASONIC_SENSORS) / sizeof(ULTRASONIC_SENSORS[0]);
@@ -0,0 +1,79 @@
+#ifndef CAN_BENCH_STATS_H_
+#define CAN_BENCH_STATS_H_
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Tamanho do anel de instantes de envio, indexado por ID & (CAN_BENCH_RING - 1).
+// Precisa ser potência de 2 e maior que qualquer janela de quadros em trânsito.
+#define CAN_BENCH_RING 16
+
+// Os quadros do benchmark usam IDs padrão: o ID é a sequência módulo 2^11
+#define CAN_BENCH_ID_MASK 0x7FFU
+
+// Resultado de uma rodada do benchmark para um DLC
+typedef struct {
+    uint8_t dlc;
+    uint32_t sent;             // Quadros aceitos pelo driver
+    uint32_t received;         // Quadros lidos de volta (loopback ou auto-recepção)
+    uint32_t corrupted;        // Quadros com ID ou dados diferentes do enviado
+    uint64_t elapsed_us;
+    uint64_t driver_us;        // Tempo gasto dentro das chamadas de envio e leitura
+    bool has_spi;              // Controlador externo: spi_transactions é válido
+    uint32_t spi_transactions;
+    uint32_t latency_p50_us;   // Do início do envio até a leitura do quadro
+    uint32_t latency_p90_us;
+    uint32_t latency_p99_us;
+    uint32_t latency_max_us;
+} can_bench_result_t;
+
+// Janela de quadros em trânsito de uma rodada. Os quadros podem voltar fora
+// de ordem; o ID identifica cada um dentro do anel.
+typedef struct {
+    can_bench_result_t *result;
+    uint32_t frames;           // Quadros a enviar nesta rodada
+    uint32_t max_in_flight;
+    uint32_t next_expected;    // Quadro mais antigo ainda não lido de volta
+    int64_t sent_at[CAN_BENCH_RING];
+    bool returned[CAN_BENCH_RING];
+    uint32_t *latencies;
+    uint32_t valid;
+} can_bench_window_t;
+
+// Conteúdo do quadro 'seq': ID = seq & CAN_BENCH_ID_MASK, data[i] = seq + i
+void can_bench_fill_payload(uint8_t *data, uint32_t seq, uint8_t dlc);
+
+// Zera o resultado e reserva espaço para as latências.
+// Retorna false se faltar memória.
+bool can_bench_window_init(can_bench_window_t *window, can_bench_result_t *result, uint8_t dlc, uint32_t frames,
+                           uint32_t max_in_flight);
+
+// Ainda há quadros a enviar e espaço na janela
+bool can_bench_window_can_send(const can_bench_window_t *window);
+
+// Próxima sequência a enviar, para montar o quadro
+uint32_t can_bench_window_next_seq(const can_bench_window_t *window);
+
+// O driver aceitou o quadro next_seq, cujo envio começou em t_us
+void can_bench_window_sent(can_bench_window_t *window, int64_t t_us);
+
+// Um quadro voltou em t_us: confere com o esperado e registra a latência
+void can_bench_window_received(can_bench_window_t *window, uint32_t id, uint8_t dlc, const uint8_t *data,
+                               int64_t t_us);
+
+// Ordena as latências, preenche os percentis e libera a memória
+void can_bench_window_finish(can_bench_window_t *window, uint64_t elapsed_us);
+
+// Linha do relatório de um DLC, igual nos dois benchmarks
+int can_bench_format(const can_bench_result_t *result, char *buffer, size_t size);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* CAN_BENCH_STATS_H_ */
@@ -0,0 +1,128 @@
+#include <inttypes.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "can_bench_stats.h"
+
+#define RING_INDEX(seq) ((seq) & (CAN_BENCH_RING - 1))
+
+static int compare_u32(const void *a, const void *b) {
+    uint32_t x = *(const uint32_t *)a;
+    uint32_t y = *(const uint32_t *)b;
+    return (x > y) - (x < y);
+}
+
+static uint32_t percentile(const uint32_t *sorted, uint32_t n, uint32_t pct) {
+    if (n == 0) {
+        return 0;
+    }
+    uint32_t idx = (uint32_t)(((uint64_t)n * pct + 99) / 100);
+    return sorted[idx > 0 ? idx - 1 : 0];
+}
+
+void can_bench_fill_payload(uint8_t *data, uint32_t seq, uint8_t dlc) {
+    for (uint8_t i = 0; i < dlc; i++) {
+        data[i] = (uint8_t)(seq + i);
+    }
+}
+
+bool can_bench_window_init(can_bench_window_t *window, can_bench_result_t *result, uint8_t dlc, uint32_t frames,
+                           uint32_t max_in_flight) {
+    memset(window, 0, sizeof(can_bench_window_t));
+    memset(result, 0, sizeof(can_bench_result_t));
+    result->dlc = dlc;
+
+    // Com mais quadros em trânsito que posições no anel o ID fica ambíguo
+    if (max_in_flight == 0 || max_in_flight >= CAN_BENCH_RING) {
+        return false;
+    }
+
+    window->result = result;
+    window->frames = frames;
+    window->max_in_flight = max_in_flight;
+    window->latencies = malloc((frames > 0 ? frames : 1) * sizeof(uint32_t));
+
+    return window->latencies != NULL;
+}
+
+bool can_bench_window_can_send(const can_bench_window_t *window) {
+    const can_bench_result_t *r = window->result;
+    return r->sent < window->frames && r->sent - window->next_expected < window->max_in_flight;
+}
+
+uint32_t can_bench_window_next_seq(const can_bench_window_t *window) {
+    return window->result->sent;
+}
+
+void can_bench_window_sent(can_bench_window_t *window, int64_t t_us) {
+    can_bench_result_t *r = window->result;
+
+    window->sent_at[RING_INDEX(r->sent)] = t_us;
+    window->returned[RING_INDEX(r->sent)] = false;
+    r->sent++;
+}
+
+void can_bench_window_received(can_bench_window_t *window, uint32_t id, uint8_t dlc, const uint8_t *data,
+                               int64_t t_us) {
+    can_bench_result_t *r = window->result;
+    uint32_t next = window->next_expected;
+    uint32_t seq = next + ((id - next) & (CAN_BENCH_RING - 1));
+
+    uint8_t expected[8];
+    can_bench_fill_payload(expected, seq, r->dlc);
+
+    if (seq >= r->sent || window->returned[RING_INDEX(seq)] || id != (seq & CAN_BENCH_ID_MASK) ||
+        dlc != r->dlc || memcmp(data, expected, r->dlc) != 0) {
+        r->corrupted++;
+    } else {
+        window->latencies[window->valid++] = (uint32_t)(t_us - window->sent_at[RING_INDEX(seq)]);
+    }
+
+    if (seq < r->sent) {
+        window->returned[RING_INDEX(seq)] = true;
+    }
+    while (window->next_expected < r->sent && window->returned[RING_INDEX(window->next_expected)]) {
+        window->next_expected++;
+    }
+
+    r->received++;
+}
+
+void can_bench_window_finish(can_bench_window_t *window, uint64_t elapsed_us) {
+    can_bench_result_t *r = window->result;
+    uint32_t valid = window->valid;
+
+    r->elapsed_us = elapsed_us;
+
+    qsort(window->latencies, valid, sizeof(uint32_t), compare_u32);
+    r->latency_p50_us = percentile(window->latencies, valid, 50);
+    r->latency_p90_us = percentile(window->latencies, valid, 90);
+    r->latency_p99_us = percentile(window->latencies, valid, 99);
+    r->latency_max_us = valid > 0 ? window->latencies[valid - 1] : 0;
+
+    free(window->latencies);
+    window->latencies = NULL;
+}
+
+int can_bench_format(const can_bench_result_t *r, char *buffer, size_t size) {
+    uint32_t n = r->received > 0 ? r->received : 1;
+    double seconds = r->elapsed_us > 0 ? r->elapsed_us / 1e6 : 1;
+    int used = snprintf(buffer, size, "DLC %u | %8.0f quadros/s | ", r->dlc, r->received / seconds);
+
+    if (r->has_spi && used >= 0 && (size_t)used < size) {
+        used += snprintf(buffer + used, size - used, "%5.2f SPI/quadro | ", (double)r->spi_transactions / n);
+    }
+
+    if (used >= 0 && (size_t)used < size) {
+        used += snprintf(buffer + used, size - used,
+                         "%6.1f us CPU/quadro | "
+                         "latência p50 %" PRIu32 " p90 %" PRIu32 " p99 %" PRIu32 " máx %" PRIu32 " us | "
+                         "perdidos %" PRIu32 " corrompidos %" PRIu32,
+                         (double)r->driver_us / n,
+                         r->latency_p50_us, r->latency_p90_us, r->latency_p99_us, r->latency_max_us,
+                         r->sent - r->received, r->corrupted);
+    }
+
+    return used;
+}
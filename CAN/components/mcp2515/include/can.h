@@ -1,12 +1,14 @@
 #ifndef CAN_H_
 #define CAN_H_
 
+#include <stddef.h>
 #include <stdint.h>
 
 
-typedef unsigned char __u8;
-typedef unsigned short __u16;
-typedef unsigned long __u32;
+/* Fixed width on every target: unsigned long is 8 bytes on 64-bit hosts */
+typedef uint8_t  __u8;
+typedef uint16_t __u16;
+typedef uint32_t __u32;
 
 
 /* special address description flags for the CAN_ID */
@@ -42,4 +44,18 @@ struct can_frame {
     __u8    data[CAN_MAX_DLEN] __attribute__((aligned(8)));
 };
 
+/*
+ * Same 16 byte layout as the Linux SocketCAN frame on the ESP32 and on
+ * hosts, so buffered captures can be exchanged as raw bytes.
+ */
+#ifdef __cplusplus
+static_assert(sizeof(struct can_frame) == 16, "can_frame must be 16 bytes");
+static_assert(offsetof(struct can_frame, can_dlc) == 4, "can_dlc must be at offset 4");
+static_assert(offsetof(struct can_frame, data) == 8, "data must be at offset 8");
+#else
+_Static_assert(sizeof(struct can_frame) == 16, "can_frame must be 16 bytes");
+_Static_assert(offsetof(struct can_frame, can_dlc) == 4, "can_dlc must be at offset 4");
+_Static_assert(offsetof(struct can_frame, data) == 8, "data must be at offset 8");
+#endif
+
 #endif /* CAN_H_ */
\ No newline at end of file
@@ -0,0 +1,127 @@
+#ifndef CAN_BATCH_H_
+#define CAN_BATCH_H_
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+#include <vector>
+
+#include "can.h"
+
+/*
+ * Frames stored as a structure of arrays: IDs, DLCs, timestamps and
+ * payloads each live in their own contiguous array. Filters and
+ * statistics touch only the arrays they need, e.g. an ID histogram over
+ * a capture reads 4 bytes per frame instead of a whole can_frame.
+ *
+ * Payloads are kept as one 8 byte word per frame, zero padded past the
+ * DLC, so equal payloads compare equal as integers.
+ */
+class CanBatch
+{
+    public:
+        explicit CanBatch(size_t capacity = 0) { reserve(capacity); }
+
+        void reserve(size_t capacity)
+        {
+            ids.reserve(capacity);
+            dlcs.reserve(capacity);
+            stamps.reserve(capacity);
+            payloads.reserve(capacity);
+        }
+
+        void clear(void)
+        {
+            ids.clear();
+            dlcs.clear();
+            stamps.clear();
+            payloads.clear();
+        }
+
+        size_t size(void) const { return ids.size(); }
+
+        void push(const struct can_frame *frame, int64_t timestamp_us)
+        {
+            uint8_t dlc = frame->can_dlc > CAN_MAX_DLEN ? CAN_MAX_DLEN : frame->can_dlc;
+            uint64_t payload = 0;
+            memcpy(&payload, frame->data, dlc);
+
+            ids.push_back(frame->can_id);
+            dlcs.push_back(dlc);
+            stamps.push_back(timestamp_us);
+            payloads.push_back(payload);
+        }
+
+        // timestamps may be NULL, in which case every frame gets 0
+        void append(const struct can_frame *frames, const int64_t *timestamps, size_t n)
+        {
+            reserve(size() + n);
+            for (size_t i = 0; i < n; i++) {
+                push(&frames[i], timestamps != NULL ? timestamps[i] : 0);
+            }
+        }
+
+        void get(size_t i, struct can_frame *frame) const
+        {
+            memset(frame, 0, sizeof(struct can_frame));
+            frame->can_id = ids[i];
+            frame->can_dlc = dlcs[i];
+            memcpy(frame->data, &payloads[i], CAN_MAX_DLEN);
+        }
+
+        // Copies up to n frames starting at 'first'; returns how many were copied.
+        // timestamps may be NULL.
+        size_t copyTo(size_t first, struct can_frame *frames, int64_t *timestamps, size_t n) const
+        {
+            if (first >= size()) {
+                return 0;
+            }
+            if (n > size() - first) {
+                n = size() - first;
+            }
+            for (size_t i = 0; i < n; i++) {
+                get(first + i, &frames[i]);
+                if (timestamps != NULL) {
+                    timestamps[i] = stamps[first + i];
+                }
+            }
+            return n;
+        }
+
+        // Appends to 'out' the index of every frame with (can_id & mask) == (id & mask)
+        void select(canid_t id, canid_t mask, std::vector<uint32_t> *out) const
+        {
+            const canid_t want = id & mask;
+            for (size_t i = 0; i < ids.size(); i++) {
+                if ((ids[i] & mask) == want) {
+                    out->push_back((uint32_t)i);
+                }
+            }
+        }
+
+        // Sets hits[i] to 1 for every frame with (can_id & mask) == (id & mask)
+        // and to 0 otherwise; hits needs size() bytes. Branch free, so the
+        // compiler can vectorise it over the ID array.
+        void match(canid_t id, canid_t mask, uint8_t *hits) const
+        {
+            const canid_t want = id & mask;
+            const canid_t *p = ids.data();
+            const size_t n = ids.size();
+            for (size_t i = 0; i < n; i++) {
+                hits[i] = (uint8_t)((p[i] & mask) == want);
+            }
+        }
+
+        const canid_t *idData(void) const { return ids.data(); }
+        const uint8_t *dlcData(void) const { return dlcs.data(); }
+        const int64_t *timestampData(void) const { return stamps.data(); }
+        const uint64_t *payloadData(void) const { return payloads.data(); }
+
+    private:
+        std::vector<canid_t>  ids;
+        std::vector<uint8_t>  dlcs;
+        std::vector<int64_t>  stamps;
+        std::vector<uint64_t> payloads;
+};
+
+#endif /* CAN_BATCH_H_ */
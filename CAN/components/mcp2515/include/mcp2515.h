@@ -1,9 +1,10 @@
 #ifndef _MCP2515_H_
 #define _MCP2515_H_
 
-#include "driver/spi_master.h"
+#include <stddef.h>
 
 #include "can.h"
+#include "mcp2515_transport.h"
 
 /*
  *  Speed 8M
@@ -203,7 +204,8 @@ enum CAN_CLKOUT {
     CLKOUT_DIV8 = 0x3,
 };
 
-class MCP2515
+// Registers, bit definitions and result codes, shared by every transport
+class MCP2515Base
 {
     public:
         enum ERROR {
@@ -262,7 +264,7 @@ class MCP2515
             EFLG_EWARN  = (1<<0)
         };
 
-    private:
+    protected:
         static const uint8_t CANCTRL_REQOP = 0xE0;
         static const uint8_t CANCTRL_ABAT = 0x10;
         static const uint8_t CANCTRL_OSM = 0x08;
@@ -282,6 +284,10 @@ class MCP2515
         static const uint8_t CANSTAT_ICOD = 0x0E;
 
         static const uint8_t CNF3_SOF = 0x80;
+        static const uint8_t CNF3_WAKFIL = 0x40;
+
+        // TXRTSCTRL: BnBFM = (1 << n) makes TXnRTS request transmission of TXBn
+        static const uint8_t TXRTSCTRL_BFM_MASK = 0x07;
 
         static const uint8_t TXB_EXIDE_MASK = 0x08;
         static const uint8_t DLC_MASK       = 0x0F;
@@ -358,6 +364,8 @@ class MCP2515
             MCP_RXF2SIDL = 0x09,
             MCP_RXF2EID8 = 0x0A,
             MCP_RXF2EID0 = 0x0B,
+            MCP_BFPCTRL  = 0x0C,
+            MCP_TXRTSCTRL = 0x0D,
             MCP_CANSTAT  = 0x0E,
             MCP_CANCTRL  = 0x0F,
             MCP_RXF3SIDH = 0x10,
@@ -442,10 +450,32 @@ class MCP2515
             REGISTER DATA;
             CANINTF  CANINTF_RXnIF;
         } RXB[N_RXBUFFERS];
+};
 
-        spi_device_handle_t *spi;
-
+/*
+ * MCP2515 driver over a compile-time SPI transport (see mcp2515_transport.h).
+ *
+ * Member definitions live in mcp2515_impl.h and are explicitly
+ * instantiated in mcp2515.cpp for the ESP-IDF transports; other
+ * transports (host simulation) instantiate them in their own build.
+ */
+template <class Transport = EspSpiPollingTransport<> >
+class MCP2515 : public MCP2515Base
+{
     private:
+        Transport transport;
+
+        uint32_t spiTransactions;
+
+        // TX buffers handed to their TXnRTS pin; sendMessage(frame) skips them
+        uint8_t reservedTxBuffers;
+
+        inline void transfer(const uint8_t *tx, uint8_t *rx, size_t len)
+        {
+            spiTransactions++;
+            transport.transfer(tx, rx, len);
+        }
+
         ERROR setMode(const CANCTRL_REQOP_MODE mode);
 
         uint8_t readRegister(const REGISTER reg);
@@ -455,13 +485,23 @@ class MCP2515
         void modifyRegister(const REGISTER reg, const uint8_t mask, const uint8_t data);
 
         void prepareId(uint8_t *buffer, const bool ext, const uint32_t id);
+        ERROR loadTxBuffer(const TXBn txbn, const struct can_frame *frame);
 
     public:
-        MCP2515(spi_device_handle_t *s);
+        MCP2515(const Transport &transport);
         ERROR reset(void);
         ERROR setConfigMode();
         ERROR setListenOnlyMode();
         ERROR setSleepMode();
+        // Sleep with the wake-up interrupt (WAKIE) set or cleared. On bus
+        // activity the controller wakes into listen-only mode and pulls INT
+        // low; the frame that woke it is not received. Clear WAKIF and pick
+        // the next mode after waking.
+        ERROR setSleepMode(const bool wakeOnBus);
+        // Low-pass filter on the wake-up input, so bus glitches do not wake
+        // the controller. CNF3 is writable only in configuration mode and is
+        // rewritten by setBitrate(), so call it after the bitrate.
+        ERROR setWakeupFilter(const bool enable);
         ERROR setLoopbackMode();
         ERROR setNormalMode();
         ERROR setClkOut(const CAN_CLKOUT divisor);
@@ -471,6 +511,12 @@ class MCP2515
         ERROR setFilter(const RXF num, const bool ext, const uint32_t ulData);
         ERROR sendMessage(const TXBn txbn, const struct can_frame *frame);
         ERROR sendMessage(const struct can_frame *frame);
+        ERROR setTxRtsPin(const TXBn txbn, const bool enable);
+        ERROR preloadMessage(const TXBn txbn, const struct can_frame *frame);
+        bool isTxPending(const TXBn txbn);
+        // Clears TXREQ. A frame already on the wire still completes, so
+        // ERROR_ALLTXBUSY means the buffer is not free yet: ask again later.
+        ERROR abortTransmission(const TXBn txbn);
         ERROR readMessage(const RXBn rxbn, struct can_frame *frame);
         ERROR readMessage(struct can_frame *frame);
         bool checkReceive(void);
@@ -479,12 +525,15 @@ class MCP2515
         void clearRXnOVRFlags(void);
         uint8_t getInterrupts(void);
         uint8_t getInterruptMask(void);
+        void setInterruptMask(const uint8_t mask);
         void clearInterrupts(void);
         void clearTXInterrupts(void);
         uint8_t getStatus(void);
         void clearRXnOVR(void);
         void clearMERR();
         void clearERRIF();
+        void clearWAKIF();
+        uint32_t getSpiTransactionCount(void) const;
 };
 
 #endif
\ No newline at end of file
@@ -1,3 +1,12 @@
+#ifndef _MCP2515_IMPL_H_
+#define _MCP2515_IMPL_H_
+
+/*
+ * Member definitions of MCP2515<Transport>. Include only where the driver
+ * is explicitly instantiated for a transport (mcp2515.cpp for ESP-IDF).
+ */
+
+#include <stdio.h>
 #include <string.h>
 
 #include "freertos/FreeRTOS.h"
@@ -5,41 +14,28 @@
 
 #include "mcp2515.h"
 
-const struct MCP2515::TXBn_REGS MCP2515::TXB[MCP2515::N_TXBUFFERS] = {
-    {MCP_TXB0CTRL, MCP_TXB0SIDH, MCP_TXB0DATA},
-    {MCP_TXB1CTRL, MCP_TXB1SIDH, MCP_TXB1DATA},
-    {MCP_TXB2CTRL, MCP_TXB2SIDH, MCP_TXB2DATA}
-};
-
-const struct MCP2515::RXBn_REGS MCP2515::RXB[N_RXBUFFERS] = {
-    {MCP_RXB0CTRL, MCP_RXB0SIDH, MCP_RXB0DATA, CANINTF_RX0IF},
-    {MCP_RXB1CTRL, MCP_RXB1SIDH, MCP_RXB1DATA, CANINTF_RX1IF}
-};
-
-MCP2515::MCP2515(spi_device_handle_t *s)
+template <class Transport>
+MCP2515<Transport>::MCP2515(const Transport &transport) : transport(transport)
 {
-    spi = s;
+    spiTransactions = 0;
+    reservedTxBuffers = 0;
 }
 
-MCP2515::ERROR MCP2515::reset(void)
+template <class Transport>
+MCP2515Base::ERROR MCP2515<Transport>::reset(void)
 {
     // startSPI();
     // SPI.transfer(INSTRUCTION_RESET);
     // endSPI();
 
-    spi_transaction_t trans = {};
-
-    trans.length = 8;
-    trans.flags = SPI_TRANS_USE_RXDATA | SPI_TRANS_USE_TXDATA;
-    trans.tx_data[0] = INSTRUCTION_RESET;
-
-    esp_err_t ret = spi_device_transmit(*spi, &trans);
-    if (ret != ESP_OK) {
-        printf("spi_device_transmit failed\n");
-    }
+    const uint8_t tx[1] = {INSTRUCTION_RESET};
+    transfer(tx, NULL, 1);
 
     vTaskDelay(pdMS_TO_TICKS(10));
 
+    // The reset returns TXRTSCTRL to digital inputs
+    reservedTxBuffers = 0;
+
     uint8_t zeros[14];
     memset(zeros, 0, sizeof(zeros));
     setRegisters(MCP_TXB0CTRL, zeros, 14);
@@ -83,7 +79,8 @@ MCP2515::ERROR MCP2515::reset(void)
     return ERROR_OK;
 }
 
-uint8_t MCP2515::readRegister(const REGISTER reg)
+template <class Transport>
+uint8_t MCP2515<Transport>::readRegister(const REGISTER reg)
 {
     // startSPI();
     // SPI.transfer(INSTRUCTION_READ);
@@ -93,23 +90,15 @@ uint8_t MCP2515::readRegister(const REGISTER reg)
     //
     // return ret;
 
-    spi_transaction_t trans = {};
-
-    trans.length = 24;
-    trans.flags = SPI_TRANS_USE_RXDATA | SPI_TRANS_USE_TXDATA;
-    trans.tx_data[0] = INSTRUCTION_READ;
-    trans.tx_data[1] = reg;
-    trans.tx_data[2] = 0x00;
-
-    esp_err_t ret = spi_device_transmit(*spi, &trans);
-    if (ret != ESP_OK) {
-        printf("spi_device_transmit failed\n");
-    }
+    const uint8_t tx[3] = {INSTRUCTION_READ, reg, 0x00};
+    uint8_t rx[3];
+    transfer(tx, rx, 3);
 
-    return trans.rx_data[2];
+    return rx[2];
 }
 
-void MCP2515::readRegisters(const REGISTER reg, uint8_t values[], const uint8_t n)
+template <class Transport>
+void MCP2515<Transport>::readRegisters(const REGISTER reg, uint8_t values[], const uint8_t n)
 {
     // startSPI();
     // SPI.transfer(INSTRUCTION_READ);
@@ -123,27 +112,19 @@ void MCP2515::readRegisters(const REGISTER reg, uint8_t values[], const uint8_t
     uint8_t rx_data[n + 2];
     uint8_t tx_data[n + 2];
 
+    memset(tx_data, 0, sizeof(tx_data));
     tx_data[0] = INSTRUCTION_READ;
     tx_data[1] = reg;
 
-    spi_transaction_t trans = {};
-
-    trans.length = ((2 + ((size_t)n)) * 8);
-    trans.rx_buffer = rx_data;
-    trans.tx_buffer = tx_data;
-
-
-    esp_err_t ret = spi_device_transmit(*spi, &trans);
-    if (ret != ESP_OK) {
-        printf("spi_device_transmit failed\n");
-    }
+    transfer(tx_data, rx_data, 2 + (size_t)n);
 
     for (uint8_t i = 0; i < n; i++) {
         values[i] = rx_data[i+2];
     }
 }
 
-void MCP2515::setRegister(const REGISTER reg, const uint8_t value)
+template <class Transport>
+void MCP2515<Transport>::setRegister(const REGISTER reg, const uint8_t value)
 {
     // startSPI();
     // SPI.transfer(INSTRUCTION_WRITE);
@@ -151,20 +132,12 @@ void MCP2515::setRegister(const REGISTER reg, const uint8_t value)
     // SPI.transfer(value);
     // endSPI();
 
-    spi_transaction_t trans = {};
-    trans.length = 24;
-    trans.flags = SPI_TRANS_USE_RXDATA | SPI_TRANS_USE_TXDATA;
-    trans.tx_data[0] = INSTRUCTION_WRITE;
-    trans.tx_data[1] = reg;
-    trans.tx_data[2] = value;
-
-    esp_err_t ret = spi_device_transmit(*spi, &trans);
-    if (ret != ESP_OK) {
-        printf("spi_device_transmit failed\n");
-    }
+    const uint8_t tx[3] = {INSTRUCTION_WRITE, reg, value};
+    transfer(tx, NULL, 3);
 }
 
-void MCP2515::setRegisters(const REGISTER reg, const uint8_t values[], const uint8_t n)
+template <class Transport>
+void MCP2515<Transport>::setRegisters(const REGISTER reg, const uint8_t values[], const uint8_t n)
 {
     // startSPI();
     // SPI.transfer(INSTRUCTION_WRITE);
@@ -183,18 +156,11 @@ void MCP2515::setRegisters(const REGISTER reg, const uint8_t values[], const uin
         data[i+2] = values[i];
     }
 
-    spi_transaction_t trans = {};
-
-    trans.length = ((2 + ((size_t)n)) * 8);
-    trans.tx_buffer = data;
-
-    esp_err_t ret = spi_device_transmit(*spi, &trans);
-    if (ret != ESP_OK) {
-        printf("spi_device_transmit failed\n");
-    }
+    transfer(data, NULL, 2 + (size_t)n);
 }
 
-void MCP2515::modifyRegister(const REGISTER reg, const uint8_t mask, const uint8_t data)
+template <class Transport>
+void MCP2515<Transport>::modifyRegister(const REGISTER reg, const uint8_t mask, const uint8_t data)
 {
     // startSPI();
     // SPI.transfer(INSTRUCTION_BITMOD);
@@ -203,22 +169,12 @@ void MCP2515::modifyRegister(const REGISTER reg, const uint8_t mask, const uint8
     // SPI.transfer(data);
     // endSPI();
 
-    spi_transaction_t trans = {};
-
-    trans.length = 32;
-    trans.flags = SPI_TRANS_USE_RXDATA | SPI_TRANS_USE_TXDATA;
-    trans.tx_data[0] = INSTRUCTION_BITMOD;
-    trans.tx_data[1] = reg;
-    trans.tx_data[2] = mask;
-    trans.tx_data[3] = data;
-
-    esp_err_t ret = spi_device_transmit(*spi, &trans);
-    if (ret != ESP_OK) {
-        printf("spi_device_transmit failed\n");
-    }
+    const uint8_t tx[4] = {INSTRUCTION_BITMOD, reg, mask, data};
+    transfer(tx, NULL, 4);
 }
 
-uint8_t MCP2515::getStatus(void)
+template <class Transport>
+uint8_t MCP2515<Transport>::getStatus(void)
 {
     // startSPI();
     // SPI.transfer(INSTRUCTION_READ_STATUS);
@@ -227,48 +183,63 @@ uint8_t MCP2515::getStatus(void)
     //
     // return i;
 
-    spi_transaction_t trans = {};
-
-    trans.length = 16;
-    trans.flags = SPI_TRANS_USE_RXDATA | SPI_TRANS_USE_TXDATA;
-    trans.tx_data[0] = INSTRUCTION_READ_STATUS;
-    trans.tx_data[1] = 0x00;
-
-
-    esp_err_t ret = spi_device_transmit(*spi, &trans);
-    if (ret != ESP_OK) {
-        printf("spi_device_transmit failed\n");
-    }
+    const uint8_t tx[2] = {INSTRUCTION_READ_STATUS, 0x00};
+    uint8_t rx[2];
+    transfer(tx, rx, 2);
 
-    return trans.rx_data[1];
+    return rx[1];
 }
 
-MCP2515::ERROR MCP2515::setConfigMode()
+template <class Transport>
+MCP2515Base::ERROR MCP2515<Transport>::setConfigMode()
 {
     return setMode(CANCTRL_REQOP_CONFIG);
 }
 
-MCP2515::ERROR MCP2515::setListenOnlyMode()
+template <class Transport>
+MCP2515Base::ERROR MCP2515<Transport>::setListenOnlyMode()
 {
     return setMode(CANCTRL_REQOP_LISTENONLY);
 }
 
-MCP2515::ERROR MCP2515::setSleepMode()
+template <class Transport>
+MCP2515Base::ERROR MCP2515<Transport>::setSleepMode()
+{
+    return setMode(CANCTRL_REQOP_SLEEP);
+}
+
+template <class Transport>
+MCP2515Base::ERROR MCP2515<Transport>::setSleepMode(const bool wakeOnBus)
 {
+    modifyRegister(MCP_CANINTF, CANINTF_WAKIF, 0);
+    modifyRegister(MCP_CANINTE, CANINTF_WAKIF, wakeOnBus ? CANINTF_WAKIF : 0);
     return setMode(CANCTRL_REQOP_SLEEP);
 }
 
-MCP2515::ERROR MCP2515::setLoopbackMode()
+template <class Transport>
+MCP2515Base::ERROR MCP2515<Transport>::setWakeupFilter(const bool enable)
+{
+    if ((readRegister(MCP_CANSTAT) & CANSTAT_OPMOD) != CANCTRL_REQOP_CONFIG) {
+        return ERROR_FAIL;
+    }
+    modifyRegister(MCP_CNF3, CNF3_WAKFIL, enable ? CNF3_WAKFIL : 0);
+    return ERROR_OK;
+}
+
+template <class Transport>
+MCP2515Base::ERROR MCP2515<Transport>::setLoopbackMode()
 {
     return setMode(CANCTRL_REQOP_LOOPBACK);
 }
 
-MCP2515::ERROR MCP2515::setNormalMode()
+template <class Transport>
+MCP2515Base::ERROR MCP2515<Transport>::setNormalMode()
 {
     return setMode(CANCTRL_REQOP_NORMAL);
 }
 
-MCP2515::ERROR MCP2515::setMode(const CANCTRL_REQOP_MODE mode)
+template <class Transport>
+MCP2515Base::ERROR MCP2515<Transport>::setMode(const CANCTRL_REQOP_MODE mode)
 {
     modifyRegister(MCP_CANCTRL, CANCTRL_REQOP, mode);
 
@@ -291,12 +262,14 @@ MCP2515::ERROR MCP2515::setMode(const CANCTRL_REQOP_MODE mode)
 
 }
 
-MCP2515::ERROR MCP2515::setBitrate(const CAN_SPEED canSpeed)
+template <class Transport>
+MCP2515Base::ERROR MCP2515<Transport>::setBitrate(const CAN_SPEED canSpeed)
 {
     return setBitrate(canSpeed, MCP_16MHZ);
 }
 
-MCP2515::ERROR MCP2515::setBitrate(const CAN_SPEED canSpeed, CAN_CLOCK canClock)
+template <class Transport>
+MCP2515Base::ERROR MCP2515<Transport>::setBitrate(const CAN_SPEED canSpeed, CAN_CLOCK canClock)
 {
     ERROR error = setConfigMode();
     if (error != ERROR_OK) {
@@ -584,7 +557,8 @@ MCP2515::ERROR MCP2515::setBitrate(const CAN_SPEED canSpeed, CAN_CLOCK canClock)
     }
 }
 
-MCP2515::ERROR MCP2515::setClkOut(const CAN_CLKOUT divisor)
+template <class Transport>
+MCP2515Base::ERROR MCP2515<Transport>::setClkOut(const CAN_CLKOUT divisor)
 {
     if (divisor == CLKOUT_DISABLE) {
 	/* Turn off CLKEN */
@@ -606,7 +580,8 @@ MCP2515::ERROR MCP2515::setClkOut(const CAN_CLKOUT divisor)
     return ERROR_OK;
 }
 
-void MCP2515::prepareId(uint8_t *buffer, const bool ext, const uint32_t id)
+template <class Transport>
+void MCP2515<Transport>::prepareId(uint8_t *buffer, const bool ext, const uint32_t id)
 {
     uint16_t canid = (uint16_t)(id & 0x0FFFF);
 
@@ -626,7 +601,8 @@ void MCP2515::prepareId(uint8_t *buffer, const bool ext, const uint32_t id)
     }
 }
 
-MCP2515::ERROR MCP2515::setFilterMask(const MASK mask, const bool ext, const uint32_t ulData)
+template <class Transport>
+MCP2515Base::ERROR MCP2515<Transport>::setFilterMask(const MASK mask, const bool ext, const uint32_t ulData)
 {
     ERROR res = setConfigMode();
     if (res != ERROR_OK) {
@@ -649,7 +625,8 @@ MCP2515::ERROR MCP2515::setFilterMask(const MASK mask, const bool ext, const uin
     return ERROR_OK;
 }
 
-MCP2515::ERROR MCP2515::setFilter(const RXF num, const bool ext, const uint32_t ulData)
+template <class Transport>
+MCP2515Base::ERROR MCP2515<Transport>::setFilter(const RXF num, const bool ext, const uint32_t ulData)
 {
     ERROR res = setConfigMode();
     if (res != ERROR_OK) {
@@ -676,7 +653,8 @@ MCP2515::ERROR MCP2515::setFilter(const RXF num, const bool ext, const uint32_t
     return ERROR_OK;
 }
 
-MCP2515::ERROR MCP2515::sendMessage(const TXBn txbn, const struct can_frame *frame)
+template <class Transport>
+MCP2515Base::ERROR MCP2515<Transport>::loadTxBuffer(const TXBn txbn, const struct can_frame *frame)
 {
     if (frame->can_dlc > CAN_MAX_DLEN) {
         return ERROR_FAILTX;
@@ -698,6 +676,19 @@ MCP2515::ERROR MCP2515::sendMessage(const TXBn txbn, const struct can_frame *fra
 
     setRegisters(txbuf->SIDH, data, 5 + frame->can_dlc);
 
+    return ERROR_OK;
+}
+
+template <class Transport>
+MCP2515Base::ERROR MCP2515<Transport>::sendMessage(const TXBn txbn, const struct can_frame *frame)
+{
+    ERROR err = loadTxBuffer(txbn, frame);
+    if (err != ERROR_OK) {
+        return err;
+    }
+
+    const struct TXBn_REGS *txbuf = &TXB[txbn];
+
     modifyRegister(txbuf->CTRL, TXB_TXREQ, TXB_TXREQ);
 
     uint8_t ctrl = readRegister(txbuf->CTRL);
@@ -707,7 +698,8 @@ MCP2515::ERROR MCP2515::sendMessage(const TXBn txbn, const struct can_frame *fra
     return ERROR_OK;
 }
 
-MCP2515::ERROR MCP2515::sendMessage(const struct can_frame *frame)
+template <class Transport>
+MCP2515Base::ERROR MCP2515<Transport>::sendMessage(const struct can_frame *frame)
 {
     if (frame->can_dlc > CAN_MAX_DLEN) {
         return ERROR_FAILTX;
@@ -716,6 +708,9 @@ MCP2515::ERROR MCP2515::sendMessage(const struct can_frame *frame)
     TXBn txBuffers[N_TXBUFFERS] = {TXB0, TXB1, TXB2};
 
     for (int i=0; i<N_TXBUFFERS; i++) {
+        if (reservedTxBuffers & (1 << txBuffers[i])) {
+            continue;
+        }
         const struct TXBn_REGS *txbuf = &TXB[txBuffers[i]];
         uint8_t ctrlval = readRegister(txbuf->CTRL);
         if ( (ctrlval & TXB_TXREQ) == 0 ) {
@@ -726,7 +721,55 @@ MCP2515::ERROR MCP2515::sendMessage(const struct can_frame *frame)
     return ERROR_ALLTXBUSY;
 }
 
-MCP2515::ERROR MCP2515::readMessage(const RXBn rxbn, struct can_frame *frame)
+template <class Transport>
+MCP2515Base::ERROR MCP2515<Transport>::setTxRtsPin(const TXBn txbn, const bool enable)
+{
+    // TXRTSCTRL can only be modified in configuration mode
+    ERROR res = setConfigMode();
+    if (res != ERROR_OK) {
+        return res;
+    }
+
+    uint8_t bit = (uint8_t)(1 << txbn);
+    modifyRegister(MCP_TXRTSCTRL, bit, enable ? bit : 0);
+
+    if ((readRegister(MCP_TXRTSCTRL) & bit) != (enable ? bit : 0)) {
+        return ERROR_FAIL;
+    }
+
+    if (enable) {
+        reservedTxBuffers |= bit;
+    } else {
+        reservedTxBuffers &= ~bit;
+    }
+    return ERROR_OK;
+}
+
+template <class Transport>
+MCP2515Base::ERROR MCP2515<Transport>::preloadMessage(const TXBn txbn, const struct can_frame *frame)
+{
+    // A buffer must not be written while its transmission is pending
+    if (isTxPending(txbn)) {
+        return ERROR_ALLTXBUSY;
+    }
+    return loadTxBuffer(txbn, frame);
+}
+
+template <class Transport>
+bool MCP2515<Transport>::isTxPending(const TXBn txbn)
+{
+    return (readRegister(TXB[txbn].CTRL) & TXB_TXREQ) != 0;
+}
+
+template <class Transport>
+MCP2515Base::ERROR MCP2515<Transport>::abortTransmission(const TXBn txbn)
+{
+    modifyRegister(TXB[txbn].CTRL, TXB_TXREQ, 0);
+    return isTxPending(txbn) ? ERROR_ALLTXBUSY : ERROR_OK;
+}
+
+template <class Transport>
+MCP2515Base::ERROR MCP2515<Transport>::readMessage(const RXBn rxbn, struct can_frame *frame)
 {
     const struct RXBn_REGS *rxb = &RXB[rxbn];
 
@@ -763,7 +806,8 @@ MCP2515::ERROR MCP2515::readMessage(const RXBn rxbn, struct can_frame *frame)
     return ERROR_OK;
 }
 
-MCP2515::ERROR MCP2515::readMessage(struct can_frame *frame)
+template <class Transport>
+MCP2515Base::ERROR MCP2515<Transport>::readMessage(struct can_frame *frame)
 {
     ERROR rc;
     uint8_t stat = getStatus();
@@ -779,7 +823,8 @@ MCP2515::ERROR MCP2515::readMessage(struct can_frame *frame)
     return rc;
 }
 
-bool MCP2515::checkReceive(void)
+template <class Transport>
+bool MCP2515<Transport>::checkReceive(void)
 {
     uint8_t res = getStatus();
     if ( res & STAT_RXIF_MASK ) {
@@ -789,7 +834,8 @@ bool MCP2515::checkReceive(void)
     }
 }
 
-bool MCP2515::checkError(void)
+template <class Transport>
+bool MCP2515<Transport>::checkError(void)
 {
     uint8_t eflg = getErrorFlags();
 
@@ -800,37 +846,50 @@ bool MCP2515::checkError(void)
     }
 }
 
-uint8_t MCP2515::getErrorFlags(void)
+template <class Transport>
+uint8_t MCP2515<Transport>::getErrorFlags(void)
 {
     return readRegister(MCP_EFLG);
 }
 
-void MCP2515::clearRXnOVRFlags(void)
+template <class Transport>
+void MCP2515<Transport>::clearRXnOVRFlags(void)
 {
 	modifyRegister(MCP_EFLG, EFLG_RX0OVR | EFLG_RX1OVR, 0);
 }
 
-uint8_t MCP2515::getInterrupts(void)
+template <class Transport>
+uint8_t MCP2515<Transport>::getInterrupts(void)
 {
     return readRegister(MCP_CANINTF);
 }
 
-void MCP2515::clearInterrupts(void)
+template <class Transport>
+void MCP2515<Transport>::clearInterrupts(void)
 {
     setRegister(MCP_CANINTF, 0);
 }
 
-uint8_t MCP2515::getInterruptMask(void)
+template <class Transport>
+uint8_t MCP2515<Transport>::getInterruptMask(void)
 {
     return readRegister(MCP_CANINTE);
 }
 
-void MCP2515::clearTXInterrupts(void)
+template <class Transport>
+void MCP2515<Transport>::setInterruptMask(const uint8_t mask)
+{
+    setRegister(MCP_CANINTE, mask);
+}
+
+template <class Transport>
+void MCP2515<Transport>::clearTXInterrupts(void)
 {
     modifyRegister(MCP_CANINTF, (CANINTF_TX0IF | CANINTF_TX1IF | CANINTF_TX2IF), 0);
 }
 
-void MCP2515::clearRXnOVR(void)
+template <class Transport>
+void MCP2515<Transport>::clearRXnOVR(void)
 {
 	uint8_t eflg = getErrorFlags();
 	if (eflg != 0) {
@@ -841,16 +900,32 @@ void MCP2515::clearRXnOVR(void)
 
 }
 
-void MCP2515::clearMERR()
+template <class Transport>
+void MCP2515<Transport>::clearMERR()
 {
 	//modifyRegister(MCP_EFLG, EFLG_RX0OVR | EFLG_RX1OVR, 0);
 	//clearInterrupts();
 	modifyRegister(MCP_CANINTF, CANINTF_MERRF, 0);
 }
 
-void MCP2515::clearERRIF()
+template <class Transport>
+void MCP2515<Transport>::clearERRIF()
 {
     //modifyRegister(MCP_EFLG, EFLG_RX0OVR | EFLG_RX1OVR, 0);
     //clearInterrupts();
     modifyRegister(MCP_CANINTF, CANINTF_ERRIF, 0);
-}
\ No newline at end of file
+}
+
+template <class Transport>
+void MCP2515<Transport>::clearWAKIF()
+{
+    modifyRegister(MCP_CANINTF, CANINTF_WAKIF, 0);
+}
+
+template <class Transport>
+uint32_t MCP2515<Transport>::getSpiTransactionCount(void) const
+{
+    return spiTransactions;
+}
+
+#endif
@@ -0,0 +1,195 @@
+#ifndef _MCP2515_TRANSPORT_H_
+#define _MCP2515_TRANSPORT_H_
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "driver/spi_master.h"
+#include "esp_timer.h"
+
+/*
+ * SPI transports for MCP2515<Transport>.
+ *
+ * A transport provides one inline primitive:
+ *
+ *     void transfer(const uint8_t *tx, uint8_t *rx, size_t len);
+ *
+ * which shifts len bytes out of tx while shifting len bytes into rx (rx
+ * may be NULL) inside a single chip select cycle. The driver only ever
+ * calls transfer(), so a transport is swapped at compile time and the
+ * call is inlined into every register access.
+ */
+
+// Arbitration of an SPI bus shared with other drivers, chosen at compile
+// time like the transport itself. An arbiter provides
+//
+//     void acquire(void);
+//     void release(void);
+//
+// which the ESP-IDF transports call around every transfer; acquire may
+// nest, so callers can hold the bus across several transfers. Both are
+// plain member calls, inlined where the arbiter allows it.
+
+// A bus of its own: nothing to arbitrate, and nothing left after inlining
+struct NoBusArbiter {
+    inline void acquire(void) {}
+    inline void release(void) {}
+};
+
+// Transactions of up to 4 bytes use the in-struct buffers of
+// spi_transaction_t; longer ones point at the caller's buffers.
+template <esp_err_t (*Transmit)(spi_device_handle_t, spi_transaction_t *), class Arbiter>
+static inline void mcp2515_esp_spi_transfer(spi_device_handle_t handle, Arbiter &arbiter,
+                                            const uint8_t *tx, uint8_t *rx, size_t len)
+{
+    arbiter.acquire();
+
+    spi_transaction_t trans = {};
+    trans.length = len * 8;
+
+    if (len <= 4) {
+        trans.flags = SPI_TRANS_USE_TXDATA | SPI_TRANS_USE_RXDATA;
+        memcpy(trans.tx_data, tx, len);
+    } else {
+        trans.tx_buffer = tx;
+        trans.rx_buffer = rx;
+    }
+
+    esp_err_t ret = Transmit(handle, &trans);
+    if (ret != ESP_OK) {
+        printf("spi_device_transmit failed\n");
+    }
+
+    if (len <= 4 && rx != NULL) {
+        memcpy(rx, trans.rx_data, len);
+    }
+
+    arbiter.release();
+}
+
+// Busy-waits for each transaction. Lowest latency for the short register
+// accesses the MCP2515 needs; the calling task keeps the CPU meanwhile.
+template <class Arbiter = NoBusArbiter>
+class EspSpiPollingTransport
+{
+    public:
+        EspSpiPollingTransport(spi_device_handle_t *handle, const Arbiter &arbiter = Arbiter())
+            : handle(handle), arbiter(arbiter) {}
+
+        inline void transfer(const uint8_t *tx, uint8_t *rx, size_t len)
+        {
+            mcp2515_esp_spi_transfer<spi_device_polling_transmit>(*handle, arbiter, tx, rx, len);
+        }
+
+    private:
+        spi_device_handle_t *handle;
+        Arbiter arbiter;
+};
+
+// Queues each transaction and sleeps until the SPI interrupt completes it.
+// Costs a context switch per access but frees the CPU during long transfers.
+template <class Arbiter = NoBusArbiter>
+class EspSpiQueuedTransport
+{
+    public:
+        EspSpiQueuedTransport(spi_device_handle_t *handle, const Arbiter &arbiter = Arbiter())
+            : handle(handle), arbiter(arbiter) {}
+
+        inline void transfer(const uint8_t *tx, uint8_t *rx, size_t len)
+        {
+            mcp2515_esp_spi_transfer<spi_device_transmit>(*handle, arbiter, tx, rx, len);
+        }
+
+    private:
+        spi_device_handle_t *handle;
+        Arbiter arbiter;
+};
+
+#define SPI_TRACE_BYTES 16
+
+struct SpiTraceRecord {
+    int64_t time_us;
+    uint8_t len;                  // Transaction length; only the first SPI_TRACE_BYTES are kept
+    uint8_t tx[SPI_TRACE_BYTES];
+    uint8_t rx[SPI_TRACE_BYTES];
+};
+
+// Ring of the most recent transactions, in a buffer owned by the caller
+class SpiTrace
+{
+    public:
+        SpiTrace(SpiTraceRecord *records, size_t capacity)
+            : records(records), capacity(capacity), count(0) {}
+
+        inline void record(const uint8_t *tx, const uint8_t *rx, size_t len)
+        {
+            SpiTraceRecord *r = &records[count % capacity];
+            size_t n = len < SPI_TRACE_BYTES ? len : SPI_TRACE_BYTES;
+            r->time_us = esp_timer_get_time();
+            r->len = len > 255 ? 255 : (uint8_t)len;
+            memcpy(r->tx, tx, n);
+            if (rx != NULL) {
+                memcpy(r->rx, rx, n);
+            } else {
+                memset(r->rx, 0, n);
+            }
+            count++;
+        }
+
+        void clear(void) { count = 0; }
+
+        // Transactions seen since the last clear(); only the last capacity() are kept
+        uint32_t total(void) const { return count; }
+        size_t size(void) const { return count < capacity ? count : capacity; }
+
+        // i = 0 is the oldest kept transaction
+        const SpiTraceRecord &at(size_t i) const
+        {
+            size_t first = count < capacity ? 0 : count % capacity;
+            return records[(first + i) % capacity];
+        }
+
+        void dump(void) const
+        {
+            for (size_t i = 0; i < size(); i++) {
+                const SpiTraceRecord &r = at(i);
+                size_t n = r.len < SPI_TRACE_BYTES ? r.len : SPI_TRACE_BYTES;
+                printf("%10lld us  %3u B  tx", (long long)r.time_us, r.len);
+                for (size_t j = 0; j < n; j++) {
+                    printf(" %02X", r.tx[j]);
+                }
+                printf("  rx");
+                for (size_t j = 0; j < n; j++) {
+                    printf(" %02X", r.rx[j]);
+                }
+                printf("\n");
+            }
+        }
+
+    private:
+        SpiTraceRecord *records;
+        size_t capacity;
+        uint32_t count;
+};
+
+// Forwards to another transport and records every transaction
+template <class Inner>
+class TracingTransport
+{
+    public:
+        TracingTransport(const Inner &inner, SpiTrace *trace) : inner(inner), trace(trace) {}
+
+        inline void transfer(const uint8_t *tx, uint8_t *rx, size_t len)
+        {
+            inner.transfer(tx, rx, len);
+            trace->record(tx, rx, len);
+        }
+
+    private:
+        Inner inner;
+        SpiTrace *trace;
+};
+
+#endif
@@ -0,0 +1,17 @@
+#include "mcp2515.h"
+#include "mcp2515_impl.h"
+
+const struct MCP2515Base::TXBn_REGS MCP2515Base::TXB[MCP2515Base::N_TXBUFFERS] = {
+    {MCP_TXB0CTRL, MCP_TXB0SIDH, MCP_TXB0DATA},
+    {MCP_TXB1CTRL, MCP_TXB1SIDH, MCP_TXB1DATA},
+    {MCP_TXB2CTRL, MCP_TXB2SIDH, MCP_TXB2DATA}
+};
+
+const struct MCP2515Base::RXBn_REGS MCP2515Base::RXB[N_RXBUFFERS] = {
+    {MCP_RXB0CTRL, MCP_RXB0SIDH, MCP_RXB0DATA, CANINTF_RX0IF},
+    {MCP_RXB1CTRL, MCP_RXB1SIDH, MCP_RXB1DATA, CANINTF_RX1IF}
+};
+
+template class MCP2515<EspSpiPollingTransport<> >;
+template class MCP2515<EspSpiQueuedTransport<> >;
+template class MCP2515<TracingTransport<EspSpiPollingTransport<> > >;
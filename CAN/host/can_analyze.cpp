@@ -0,0 +1,281 @@
+/*
+ * can_analyze: offline statistics over binary captures (capture_file.h,
+ * e.g. from can_decode -f bin). The file is memory mapped and split into
+ * one chunk per thread; the per-chunk results are merged in file order.
+ *
+ *   can_analyze [-j threads] [-m id[/mask]] [-s first-last] [-b bitrate]
+ *               [-w window_ms] [-t timeline.csv] capture.bin
+ */
+#include <fcntl.h>
+#include <inttypes.h>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <time.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <map>
+#include <thread>
+#include <vector>
+
+#include "capture_stats.h"
+
+static double monotonicSeconds()
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec + (double)ts.tv_nsec / 1e9;
+}
+
+static double stddev(double sum, double sumSq, uint64_t n)
+{
+    if (n < 2) {
+        return 0.0;
+    }
+    double mean = sum / (double)n;
+    double variance = sumSq / (double)n - mean * mean;
+    return variance > 0 ? sqrt(variance) : 0.0;
+}
+
+static void formatId(canid_t id, char *out, size_t len)
+{
+    if (id & CAN_EFF_FLAG) {
+        snprintf(out, len, "%08" PRIX32 "%s", (uint32_t)(id & CAN_EFF_MASK), (id & CAN_RTR_FLAG) ? " R" : "");
+    } else {
+        snprintf(out, len, "%03" PRIX32 "%s", (uint32_t)(id & CAN_SFF_MASK), (id & CAN_RTR_FLAG) ? " R" : "");
+    }
+}
+
+static void printBusLoad(const CaptureStats &stats, const AnalyzerConfig &config, const char *timelinePath)
+{
+    const std::vector<uint64_t> &bits = stats.windowBits();
+    const double capacity = (double)config.bitrate * (double)config.windowUs / 1e6;
+    const double duration = (double)(stats.lastUs() - stats.firstUs()) / 1e6;
+
+    uint64_t totalBits = 0;
+    for (size_t i = 0; i < bits.size(); i++) {
+        totalBits += bits[i];
+    }
+
+    std::vector<uint64_t> sorted(bits);
+    std::sort(sorted.begin(), sorted.end());
+    size_t busiest = std::max_element(bits.begin(), bits.end()) - bits.begin();
+
+    printf("\nBus load (%" PRIu32 " bit/s, %.0f ms windows, nominal bits without stuffing)\n",
+           config.bitrate, (double)config.windowUs / 1000.0);
+    printf("  mean %.1f%% | p50 %.1f%% | p99 %.1f%% | max %.1f%% at +%.3f s\n",
+           duration > 0 ? 100.0 * (double)totalBits / ((double)config.bitrate * duration) : 0.0,
+           100.0 * (double)sorted[sorted.size() / 2] / capacity,
+           100.0 * (double)sorted[(sorted.size() * 99) / 100] / capacity,
+           100.0 * (double)sorted.back() / capacity,
+           (double)((stats.firstWindow() + (int64_t)busiest) * config.windowUs) / 1e6);
+
+    if (timelinePath == NULL) {
+        return;
+    }
+    FILE *f = fopen(timelinePath, "w");
+    if (f == NULL) {
+        perror(timelinePath);
+        return;
+    }
+    fprintf(f, "offset_s,bits,load_percent\n");
+    for (size_t i = 0; i < bits.size(); i++) {
+        fprintf(f, "%.6f,%" PRIu64 ",%.2f\n",
+                (double)((stats.firstWindow() + (int64_t)i) * config.windowUs) / 1e6,
+                bits[i], 100.0 * (double)bits[i] / capacity);
+    }
+    fclose(f);
+    printf("  timeline written to %s (%zu windows)\n", timelinePath, bits.size());
+}
+
+static void printIdTable(const std::map<canid_t, IdStats> &ids, double duration)
+{
+    printf("\n%-12s %12s %10s %12s %12s %12s %12s\n",
+           "ID", "frames", "rate/s", "period ms", "jitter ms", "min ms", "max ms");
+    for (std::map<canid_t, IdStats>::const_iterator it = ids.begin(); it != ids.end(); ++it) {
+        const IdStats &s = it->second;
+        char id[16];
+        formatId(it->first, id, sizeof(id));
+        double mean = s.intervals ? s.intervalSum / (double)s.intervals : 0.0;
+        printf("%-12s %12" PRIu64 " %10.1f %12.3f %12.3f %12.3f %12.3f\n",
+               id, s.frames, duration > 0 ? (double)s.frames / duration : 0.0,
+               mean / 1000.0, stddev(s.intervalSum, s.intervalSumSq, s.intervals) / 1000.0,
+               (double)s.intervalMin / 1000.0, (double)s.intervalMax / 1000.0);
+    }
+}
+
+static void printSensorTable(const std::map<canid_t, IdStats> &ids)
+{
+    bool header = false;
+    for (std::map<canid_t, IdStats>::const_iterator it = ids.begin(); it != ids.end(); ++it) {
+        const IdStats &s = it->second;
+        if (s.readings == 0) {
+            continue;
+        }
+        if (!header) {
+            printf("\n%-12s %12s %10s %10s %10s %10s %9s %9s %9s %9s\n",
+                   "sensor", "readings", "ok", "out", "invalid", "seq gaps",
+                   "min cm", "mean cm", "max cm", "std cm");
+            header = true;
+        }
+        char id[16];
+        formatId(it->first, id, sizeof(id));
+        double mean = s.distances ? s.distanceSum / (double)s.distances : 0.0;
+        printf("%-12s %12" PRIu64 " %10" PRIu64 " %10" PRIu64 " %10" PRIu64 " %10" PRIu64
+               " %9.2f %9.2f %9.2f %9.2f\n",
+               id, s.readings, s.byStatus[SENSOR_STATUS_OK], s.byStatus[SENSOR_STATUS_OUT_OF_RANGE],
+               s.byStatus[SENSOR_STATUS_INVALID], s.sequenceGaps,
+               s.distances ? s.distanceMin : 0.0f, mean, s.distances ? s.distanceMax : 0.0f,
+               stddev(s.distanceSum, s.distanceSumSq, s.distances));
+    }
+}
+
+static void usage(const char *argv0)
+{
+    fprintf(stderr,
+            "usage: %s [-j threads] [-m id[/mask]] [-s first-last] [-b bitrate]\n"
+            "          [-w window_ms] [-t timeline.csv] capture.bin\n"
+            "  -j  worker threads (default: all cores)\n"
+            "  -m  only frames with (can_id & mask) == id, hex; mask defaults to all ID bits\n"
+            "  -s  standard IDs decoded as ultrasonic readings, hex (default 101-6FF)\n"
+            "  -b  bus bitrate for load figures (default 500000)\n"
+            "  -w  bus-load window in ms (default 100)\n"
+            "  -t  write the bus-load timeline as CSV\n",
+            argv0);
+}
+
+int main(int argc, char **argv)
+{
+    unsigned threads = std::thread::hardware_concurrency();
+    const char *timelinePath = NULL;
+    AnalyzerConfig config;
+    config.filterId = 0;
+    config.filterMask = 0;
+    config.sensorFirst = 0x101;
+    config.sensorLast = 0x6FF;
+    config.bitrate = 500000;
+    config.windowUs = 100000;
+    config.originUs = 0;
+
+    int opt;
+    char *end;
+    while ((opt = getopt(argc, argv, "j:m:s:b:w:t:h")) != -1) {
+        switch (opt) {
+        case 'j':
+            threads = (unsigned)strtoul(optarg, NULL, 10);
+            break;
+        case 'm':
+            config.filterId = (canid_t)strtoul(optarg, &end, 16);
+            config.filterMask = *end == '/' ? (canid_t)strtoul(end + 1, NULL, 16)
+                                            : (canid_t)(CAN_EFF_FLAG | CAN_EFF_MASK);
+            break;
+        case 's':
+            config.sensorFirst = (canid_t)strtoul(optarg, &end, 16);
+            config.sensorLast = *end == '-' ? (canid_t)strtoul(end + 1, NULL, 16) : config.sensorFirst;
+            break;
+        case 'b':
+            config.bitrate = (uint32_t)strtoul(optarg, NULL, 10);
+            break;
+        case 'w':
+            config.windowUs = (int64_t)(strtod(optarg, NULL) * 1000.0);
+            break;
+        case 't':
+            timelinePath = optarg;
+            break;
+        default:
+            usage(argv[0]);
+            return 2;
+        }
+    }
+    if (optind != argc - 1 || config.windowUs <= 0 || config.bitrate == 0) {
+        usage(argv[0]);
+        return 2;
+    }
+    if (threads == 0) {
+        threads = 1;
+    }
+
+    const char *path = argv[optind];
+    int fd = open(path, O_RDONLY);
+    struct stat st;
+    if (fd < 0 || fstat(fd, &st) != 0) {
+        perror(path);
+        return 1;
+    }
+    if ((size_t)st.st_size < sizeof(struct CaptureFileHeader)) {
+        fprintf(stderr, "%s: not a capture file\n", path);
+        return 1;
+    }
+
+    const size_t fileSize = (size_t)st.st_size;
+    void *map = mmap(NULL, fileSize, PROT_READ, MAP_PRIVATE, fd, 0);
+    if (map == MAP_FAILED) {
+        perror("mmap");
+        return 1;
+    }
+    madvise(map, fileSize, MADV_SEQUENTIAL);
+
+    const struct CaptureFileHeader *header = (const struct CaptureFileHeader *)map;
+    if (!captureHeaderValid(header)) {
+        fprintf(stderr, "%s: bad capture header\n", path);
+        return 1;
+    }
+    const struct CaptureRecord *records =
+        (const struct CaptureRecord *)((const uint8_t *)map + sizeof(*header));
+    const size_t count = (fileSize - sizeof(*header)) / sizeof(struct CaptureRecord);
+    if (count == 0) {
+        fprintf(stderr, "%s: no records\n", path);
+        return 1;
+    }
+    if (threads > count) {
+        threads = (unsigned)count;
+    }
+    config.originUs = records[0].timestampUs;
+
+    const double started = monotonicSeconds();
+
+    std::vector<CaptureStats *> partial;
+    std::vector<std::thread> workers;
+    for (unsigned t = 0; t < threads; t++) {
+        partial.push_back(new CaptureStats(config));
+    }
+    for (unsigned t = 0; t < threads; t++) {
+        size_t first = count * t / threads;
+        size_t last = count * (t + 1) / threads;
+        workers.push_back(std::thread(&CaptureStats::process, partial[t], records + first, last - first));
+    }
+    for (unsigned t = 0; t < threads; t++) {
+        workers[t].join();
+    }
+    for (unsigned t = 1; t < threads; t++) {
+        partial[0]->merge(*partial[t]);
+        delete partial[t];
+    }
+    const CaptureStats &stats = *partial[0];
+
+    const double elapsed = monotonicSeconds() - started;
+    const double duration = (double)(stats.lastUs() - stats.firstUs()) / 1e6;
+
+    printf("%s: %zu records, %.3f s of traffic | %u threads, %.3f s (%.1f M frames/s)\n",
+           path, count, duration, threads, elapsed, (double)count / elapsed / 1e6);
+    if (stats.skipped() > 0) {
+        printf("  %" PRIu64 " frames match the filter, %" PRIu64 " skipped\n", stats.frames(), stats.skipped());
+    }
+    if (stats.frames() == 0) {
+        return 0;
+    }
+
+    std::map<canid_t, IdStats> ids = stats.byId();
+    printBusLoad(stats, config, timelinePath);
+    printIdTable(ids, duration);
+    printSensorTable(ids);
+
+    delete partial[0];
+    munmap(map, fileSize);
+    close(fd);
+    return 0;
+}
@@ -0,0 +1,241 @@
+/*
+ * can_decode: reads the CanSniffer UART stream from a serial port or a
+ * file and writes candump log lines, a pcap capture or a binary capture
+ * for can_analyze. Frame drops the
+ * sniffer reports, batches lost on the link and corrupted batches are
+ * reported on stderr as they happen and summed up at the end.
+ *
+ *   can_decode [-b baud] [-f candump|pcap|bin] [-i ifname] [-o out] [-d] [input]
+ */
+#include <errno.h>
+#include <fcntl.h>
+#include <inttypes.h>
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/time.h>
+#include <termios.h>
+#include <unistd.h>
+
+#include "capture_writer.h"
+#include "sniffer_stream.h"
+
+static volatile sig_atomic_t stopRequested = 0;
+
+static void onSignal(int)
+{
+    stopRequested = 1;
+}
+
+static int64_t wallClockUs()
+{
+    struct timeval tv;
+    gettimeofday(&tv, NULL);
+    return (int64_t)tv.tv_sec * 1000000 + tv.tv_usec;
+}
+
+static bool baudConstant(long baud, speed_t *speed)
+{
+    static const struct { long baud; speed_t speed; } table[] = {
+        {115200, B115200}, {230400, B230400}, {460800, B460800},
+        {921600, B921600}, {1000000, B1000000}, {1500000, B1500000},
+        {2000000, B2000000}, {3000000, B3000000}, {4000000, B4000000},
+    };
+    for (size_t i = 0; i < sizeof(table) / sizeof(table[0]); i++) {
+        if (table[i].baud == baud) {
+            *speed = table[i].speed;
+            return true;
+        }
+    }
+    return false;
+}
+
+/* Raw 8N1 at 'baud'; files and pipes are left alone */
+static bool configureSerial(int fd, long baud)
+{
+    if (!isatty(fd)) {
+        return true;
+    }
+
+    speed_t speed;
+    if (!baudConstant(baud, &speed)) {
+        fprintf(stderr, "unsupported baud rate %ld\n", baud);
+        return false;
+    }
+
+    struct termios tio;
+    if (tcgetattr(fd, &tio) != 0) {
+        perror("tcgetattr");
+        return false;
+    }
+    cfmakeraw(&tio);
+    tio.c_cflag |= CLOCAL | CREAD;
+    tio.c_cflag &= ~(CSTOPB | CRTSCTS);
+    tio.c_cc[VMIN] = 1;
+    tio.c_cc[VTIME] = 0;
+    cfsetispeed(&tio, speed);
+    cfsetospeed(&tio, speed);
+    if (tcsetattr(fd, TCSANOW, &tio) != 0) {
+        perror("tcsetattr");
+        return false;
+    }
+    tcflush(fd, TCIFLUSH);
+    return true;
+}
+
+class DecodeSink : public SnifferStreamListener {
+public:
+    DecodeSink(CaptureWriter *writer, bool deviceTime)
+        : writer_(writer), deviceTime_(deviceTime), haveOffset_(false),
+          offsetUs_(0), writeFailed_(false)
+    {
+    }
+
+    void onFrame(int64_t timestampUs, const struct can_frame &frame)
+    {
+        /* Anchor the sniffer's clock to the host clock at the first frame */
+        if (!deviceTime_ && !haveOffset_) {
+            offsetUs_ = wallClockUs() - timestampUs;
+            haveOffset_ = true;
+        }
+        if (!writer_->write(timestampUs + offsetUs_, frame)) {
+            writeFailed_ = true;
+        }
+    }
+
+    void onDeviceDrops(uint32_t lost, uint32_t total)
+    {
+        fprintf(stderr, "sniffer dropped %" PRIu32 " frames (%" PRIu32 " since boot)\n", lost, total);
+    }
+
+    void onLostBatches(uint32_t count, uint16_t sequence)
+    {
+        fprintf(stderr, "%" PRIu32 " batches lost on the link before batch %u\n", count, sequence);
+    }
+
+    void onCorruptBatch(const char *reason)
+    {
+        fprintf(stderr, "corrupt batch discarded: %s\n", reason);
+    }
+
+    bool writeFailed() const { return writeFailed_; }
+
+private:
+    CaptureWriter *writer_;
+    bool deviceTime_;
+    bool haveOffset_;
+    int64_t offsetUs_;
+    bool writeFailed_;
+};
+
+static void usage(const char *argv0)
+{
+    fprintf(stderr,
+            "usage: %s [-b baud] [-f candump|pcap|bin] [-i ifname] [-o out] [-d] [input]\n"
+            "  -b  serial baud rate when input is a tty (default 2000000)\n"
+            "  -f  output format (default candump)\n"
+            "  -i  interface name in candump lines (default can0)\n"
+            "  -o  output file (default stdout)\n"
+            "  -d  keep the sniffer's clock instead of the host wall clock\n"
+            "  input defaults to stdin\n",
+            argv0);
+}
+
+int main(int argc, char **argv)
+{
+    long baud = 2000000;
+    const char *format = "candump";
+    const char *interfaceName = "can0";
+    const char *outputPath = NULL;
+    bool deviceTime = false;
+
+    int opt;
+    while ((opt = getopt(argc, argv, "b:f:i:o:dh")) != -1) {
+        switch (opt) {
+        case 'b': baud = strtol(optarg, NULL, 10); break;
+        case 'f': format = optarg; break;
+        case 'i': interfaceName = optarg; break;
+        case 'o': outputPath = optarg; break;
+        case 'd': deviceTime = true; break;
+        default: usage(argv[0]); return 2;
+        }
+    }
+
+    int fd = STDIN_FILENO;
+    if (optind < argc) {
+        fd = open(argv[optind], O_RDONLY | O_NOCTTY);
+        if (fd < 0) {
+            perror(argv[optind]);
+            return 1;
+        }
+    }
+    if (!configureSerial(fd, baud)) {
+        return 1;
+    }
+
+    FILE *out = stdout;
+    if (outputPath != NULL) {
+        out = fopen(outputPath, "wb");
+        if (out == NULL) {
+            perror(outputPath);
+            return 1;
+        }
+    }
+
+    CandumpWriter candump(out, interfaceName);
+    PcapWriter pcap(out);
+    BinaryCaptureWriter binary(out);
+    CaptureWriter *writer;
+    if (strcmp(format, "candump") == 0) {
+        writer = &candump;
+    } else if (strcmp(format, "pcap") == 0) {
+        writer = &pcap;
+    } else if (strcmp(format, "bin") == 0) {
+        writer = &binary;
+    } else {
+        usage(argv[0]);
+        return 2;
+    }
+
+    /* No SA_RESTART: Ctrl-C interrupts read() so the summary is printed */
+    struct sigaction sa;
+    memset(&sa, 0, sizeof(sa));
+    sa.sa_handler = onSignal;
+    sigaction(SIGINT, &sa, NULL);
+    sigaction(SIGTERM, &sa, NULL);
+
+    DecodeSink sink(writer, deviceTime);
+    SnifferStreamDecoder decoder(&sink);
+
+    uint8_t buf[4096];
+    while (!stopRequested && !sink.writeFailed()) {
+        ssize_t n = read(fd, buf, sizeof(buf));
+        if (n < 0 && errno == EINTR) {
+            continue;
+        }
+        if (n <= 0) {
+            if (n < 0) {
+                perror("read");
+            }
+            break;
+        }
+        decoder.feed(buf, (size_t)n);
+    }
+    fflush(out);
+
+    const SnifferStreamStats &stats = decoder.stats();
+    fprintf(stderr,
+            "%" PRIu64 " frames in %" PRIu64 " batches (%" PRIu64 " bytes) | "
+            "sniffer drops: %" PRIu64 " (+%" PRIu32 " before start) | "
+            "lost batches: %" PRIu64 " | corrupt batches: %" PRIu64 "\n",
+            stats.frames, stats.batches, stats.bytes,
+            stats.deviceDrops, stats.initialDeviceDrops,
+            stats.lostBatches, stats.corruptBatches);
+
+    if (sink.writeFailed()) {
+        perror("write");
+        return 1;
+    }
+    return (stats.deviceDrops || stats.lostBatches || stats.corruptBatches) ? 3 : 0;
+}
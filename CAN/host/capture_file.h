@@ -0,0 +1,46 @@
+#ifndef CAPTURE_FILE_H_
+#define CAPTURE_FILE_H_
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "can.h"
+
+/*
+ * Binary capture: a 16 byte header followed by fixed size records, each
+ * a timestamp and the 16 byte can_frame as it sits in memory. Fixed size
+ * records let readers mmap the file and split it anywhere on a record
+ * boundary. Integers are little-endian, as on the ESP32 and x86/ARM hosts.
+ */
+
+#define CAPTURE_MAGIC "CANCAP1"
+
+struct CaptureFileHeader {
+    char magic[8];       /* CAPTURE_MAGIC, NUL terminated */
+    uint32_t recordSize; /* sizeof(struct CaptureRecord) */
+    uint32_t reserved;
+};
+
+struct CaptureRecord {
+    int64_t timestampUs;
+    struct can_frame frame;
+};
+
+static_assert(sizeof(struct CaptureFileHeader) == 16, "capture header must be 16 bytes");
+static_assert(sizeof(struct CaptureRecord) == 24, "capture record must be 24 bytes");
+
+static inline void captureHeaderInit(struct CaptureFileHeader *header)
+{
+    memset(header, 0, sizeof(*header));
+    memcpy(header->magic, CAPTURE_MAGIC, sizeof(CAPTURE_MAGIC));
+    header->recordSize = sizeof(struct CaptureRecord);
+}
+
+static inline bool captureHeaderValid(const struct CaptureFileHeader *header)
+{
+    return memcmp(header->magic, CAPTURE_MAGIC, sizeof(CAPTURE_MAGIC)) == 0 &&
+           header->recordSize == sizeof(struct CaptureRecord);
+}
+
+#endif /* CAPTURE_FILE_H_ */
@@ -0,0 +1,280 @@
+#include "capture_stats.h"
+
+#include <string.h>
+
+static void resetIdStats(IdStats *stats)
+{
+    memset(stats, 0, sizeof(*stats));
+}
+
+void IdStats::merge(const IdStats &later)
+{
+    if (later.frames == 0) {
+        return;
+    }
+    if (frames == 0) {
+        *this = later;
+        return;
+    }
+
+    /* The interval across the boundary belongs to neither chunk */
+    int64_t gap = later.firstUs - lastUs;
+    int64_t lo = gap;
+    int64_t hi = gap;
+    if (later.intervals) {
+        lo = later.intervalMin < lo ? later.intervalMin : lo;
+        hi = later.intervalMax > hi ? later.intervalMax : hi;
+    }
+    if (intervals) {
+        lo = intervalMin < lo ? intervalMin : lo;
+        hi = intervalMax > hi ? intervalMax : hi;
+    }
+    intervalMin = lo;
+    intervalMax = hi;
+    intervals += later.intervals + 1;
+    intervalSum += later.intervalSum + (double)gap;
+    intervalSumSq += later.intervalSumSq + (double)gap * (double)gap;
+
+    frames += later.frames;
+    payloadBytes += later.payloadBytes;
+    lastUs = later.lastUs;
+
+    readings += later.readings;
+    for (int i = 0; i < 4; i++) {
+        byStatus[i] += later.byStatus[i];
+    }
+    if (later.haveSequence) {
+        if (haveSequence) {
+            uint8_t step = (uint8_t)(later.firstSequence - lastSequence);
+            if (step > 1) {
+                sequenceGaps += step - 1;
+            }
+        } else {
+            firstSequence = later.firstSequence;
+        }
+        haveSequence = true;
+        lastSequence = later.lastSequence;
+    }
+    sequenceGaps += later.sequenceGaps;
+
+    if (later.distances) {
+        if (distances == 0 || later.distanceMin < distanceMin) {
+            distanceMin = later.distanceMin;
+        }
+        if (distances == 0 || later.distanceMax > distanceMax) {
+            distanceMax = later.distanceMax;
+        }
+        distances += later.distances;
+        distanceSum += later.distanceSum;
+        distanceSumSq += later.distanceSumSq;
+    }
+}
+
+CaptureStats::CaptureStats(const AnalyzerConfig &config)
+    : config_(config), batch_(BLOCK), hits_(BLOCK), bits_(BLOCK),
+      standard_(CAN_SFF_MASK + 1), frames_(0), skipped_(0),
+      firstUs_(0), lastUs_(0), firstWindow_(0)
+{
+    for (size_t i = 0; i < standard_.size(); i++) {
+        resetIdStats(&standard_[i]);
+    }
+}
+
+uint32_t CaptureStats::frameBits(canid_t id, uint8_t dlc)
+{
+    /* SOF..EOF is 44 bits with an 11 bit ID, 64 with a 29 bit one; remote
+     * frames carry a DLC but no data field */
+    uint32_t extended = (id >> 31) & 1;
+    uint32_t data = ((id >> 30) & 1) ? 0 : 8u * (dlc > CAN_MAX_DLEN ? CAN_MAX_DLEN : dlc);
+    return 44 + 20 * extended + data + 3;
+}
+
+IdStats &CaptureStats::statsFor(canid_t id)
+{
+    if ((id & (CAN_EFF_FLAG | CAN_RTR_FLAG)) == 0) {
+        return standard_[id & CAN_SFF_MASK];
+    }
+
+    std::unordered_map<canid_t, IdStats>::iterator it = other_.find(id);
+    if (it == other_.end()) {
+        IdStats fresh;
+        resetIdStats(&fresh);
+        it = other_.insert(std::make_pair(id, fresh)).first;
+    }
+    return it->second;
+}
+
+void CaptureStats::addWindowBits(int64_t timestampUs, uint32_t bits)
+{
+    int64_t window = (timestampUs - config_.originUs) / config_.windowUs;
+    if (windowBits_.empty()) {
+        firstWindow_ = window;
+    }
+    /* Out of order timestamps earlier than the chunk start are folded
+     * into its first window */
+    if (window < firstWindow_) {
+        window = firstWindow_;
+    }
+    size_t index = (size_t)(window - firstWindow_);
+    if (index >= windowBits_.size()) {
+        windowBits_.resize(index + 1, 0);
+    }
+    windowBits_[index] += bits;
+}
+
+void CaptureStats::process(const struct CaptureRecord *records, size_t n)
+{
+    for (size_t first = 0; first < n; first += BLOCK) {
+        size_t count = n - first < BLOCK ? n - first : BLOCK;
+        batch_.clear();
+        for (size_t i = 0; i < count; i++) {
+            batch_.push(&records[first + i].frame, records[first + i].timestampUs);
+        }
+        processBlock();
+    }
+}
+
+void CaptureStats::processBlock()
+{
+    const size_t n = batch_.size();
+    const canid_t *ids = batch_.idData();
+    const uint8_t *dlcs = batch_.dlcData();
+    const int64_t *stamps = batch_.timestampData();
+    const uint64_t *payloads = batch_.payloadData();
+
+    /* Filter and wire lengths are straight loops over the ID and DLC
+     * arrays; only the per-ID pass below needs frames in order */
+    batch_.match(config_.filterId, config_.filterMask, hits_.data());
+    for (size_t i = 0; i < n; i++) {
+        bits_[i] = frameBits(ids[i], dlcs[i]);
+    }
+
+    for (size_t i = 0; i < n; i++) {
+        if (!hits_[i]) {
+            skipped_++;
+            continue;
+        }
+
+        const int64_t ts = stamps[i];
+        if (frames_ == 0) {
+            firstUs_ = ts;
+        }
+        lastUs_ = ts;
+        frames_++;
+        addWindowBits(ts, bits_[i]);
+
+        const canid_t id = ids[i] & (CAN_EFF_FLAG | CAN_RTR_FLAG | CAN_EFF_MASK);
+        IdStats &s = statsFor(id);
+        if (s.frames > 0) {
+            int64_t interval = ts - s.lastUs;
+            if (s.intervals == 0 || interval < s.intervalMin) {
+                s.intervalMin = interval;
+            }
+            if (s.intervals == 0 || interval > s.intervalMax) {
+                s.intervalMax = interval;
+            }
+            s.intervals++;
+            s.intervalSum += (double)interval;
+            s.intervalSumSq += (double)interval * (double)interval;
+        } else {
+            s.firstUs = ts;
+        }
+        s.lastUs = ts;
+        s.frames++;
+        s.payloadBytes += dlcs[i];
+
+        /* Reading layout: status, float distance, sequence counter. Other
+         * traffic in the sensor range is told apart by the status byte */
+        if ((id & (CAN_EFF_FLAG | CAN_RTR_FLAG)) != 0 || id < config_.sensorFirst ||
+            id > config_.sensorLast || dlcs[i] < 5) {
+            continue;
+        }
+
+        uint8_t bytes[CAN_MAX_DLEN];
+        memcpy(bytes, &payloads[i], sizeof(bytes));
+        if (bytes[0] < SENSOR_STATUS_OK || bytes[0] > SENSOR_STATUS_INVALID) {
+            continue;
+        }
+        s.readings++;
+        s.byStatus[bytes[0]]++;
+
+        if (bytes[0] == SENSOR_STATUS_OK) {
+            float distance;
+            memcpy(&distance, &bytes[1], sizeof(distance));
+            if (s.distances == 0 || distance < s.distanceMin) {
+                s.distanceMin = distance;
+            }
+            if (s.distances == 0 || distance > s.distanceMax) {
+                s.distanceMax = distance;
+            }
+            s.distances++;
+            s.distanceSum += distance;
+            s.distanceSumSq += (double)distance * distance;
+        }
+
+        if (dlcs[i] >= 6) {
+            uint8_t sequence = bytes[5];
+            if (s.haveSequence) {
+                /* Difference modulo 256; 1 means nothing was lost */
+                uint8_t step = (uint8_t)(sequence - s.lastSequence);
+                if (step > 1) {
+                    s.sequenceGaps += step - 1;
+                }
+            } else {
+                s.firstSequence = sequence;
+                s.haveSequence = true;
+            }
+            s.lastSequence = sequence;
+        }
+    }
+}
+
+void CaptureStats::merge(const CaptureStats &later)
+{
+    for (size_t i = 0; i < standard_.size(); i++) {
+        standard_[i].merge(later.standard_[i]);
+    }
+    for (std::unordered_map<canid_t, IdStats>::const_iterator it = later.other_.begin();
+         it != later.other_.end(); ++it) {
+        statsFor(it->first).merge(it->second);
+    }
+
+    if (!later.windowBits_.empty() && windowBits_.empty()) {
+        firstWindow_ = later.firstWindow_;
+    }
+    for (size_t i = 0; i < later.windowBits_.size(); i++) {
+        int64_t window = later.firstWindow_ + (int64_t)i;
+        if (window < firstWindow_) {
+            window = firstWindow_;
+        }
+        size_t index = (size_t)(window - firstWindow_);
+        if (index >= windowBits_.size()) {
+            windowBits_.resize(index + 1, 0);
+        }
+        windowBits_[index] += later.windowBits_[i];
+    }
+
+    if (later.frames_ > 0) {
+        if (frames_ == 0) {
+            firstUs_ = later.firstUs_;
+        }
+        lastUs_ = later.lastUs_;
+    }
+    frames_ += later.frames_;
+    skipped_ += later.skipped_;
+}
+
+std::map<canid_t, IdStats> CaptureStats::byId() const
+{
+    std::map<canid_t, IdStats> out;
+    for (size_t i = 0; i < standard_.size(); i++) {
+        if (standard_[i].frames > 0) {
+            out[(canid_t)i] = standard_[i];
+        }
+    }
+    for (std::unordered_map<canid_t, IdStats>::const_iterator it = other_.begin();
+         it != other_.end(); ++it) {
+        out[it->first] = it->second;
+    }
+    return out;
+}
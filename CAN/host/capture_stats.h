@@ -0,0 +1,114 @@
+#ifndef CAPTURE_STATS_H_
+#define CAPTURE_STATS_H_
+
+#include <stddef.h>
+#include <stdint.h>
+#include <map>
+#include <unordered_map>
+#include <vector>
+
+#include "can.h"
+#include "can_batch.h"
+#include "capture_file.h"
+
+/* Reading status codes sent by CanTransmitter in data[0] */
+#define SENSOR_STATUS_OK           0x01
+#define SENSOR_STATUS_OUT_OF_RANGE 0x02
+#define SENSOR_STATUS_INVALID      0x03
+
+struct AnalyzerConfig {
+    canid_t filterId;    /* frames with (can_id & filterMask) != filterId are skipped */
+    canid_t filterMask;
+    canid_t sensorFirst; /* standard IDs decoded as ultrasonic readings */
+    canid_t sensorLast;
+    uint32_t bitrate;
+    int64_t windowUs;    /* bus-load timeline resolution */
+    int64_t originUs;    /* start of window 0, normally the first timestamp */
+};
+
+struct IdStats {
+    uint64_t frames;
+    uint64_t payloadBytes;
+    int64_t firstUs;
+    int64_t lastUs;
+
+    /* Intervals between consecutive frames of this ID */
+    uint64_t intervals;
+    double intervalSum;
+    double intervalSumSq;
+    int64_t intervalMin;
+    int64_t intervalMax;
+
+    /* Ultrasonic readings: status, float distance, sequence counter */
+    uint64_t readings;
+    uint64_t byStatus[4];   /* indexed by SENSOR_STATUS_*, 0 unused */
+    bool haveSequence;
+    uint8_t firstSequence;
+    uint8_t lastSequence;
+    uint64_t sequenceGaps;  /* frames missing according to the counter */
+    uint64_t distances;
+    double distanceSum;
+    double distanceSumSq;
+    float distanceMin;
+    float distanceMax;
+
+    /* Appends the statistics of a chunk that follows this one in time */
+    void merge(const IdStats &later);
+};
+
+/*
+ * Statistics over a run of capture records in time order. Each worker
+ * thread fills one instance for its chunk of the file; the instances are
+ * then merged in file order, which also accounts for the intervals and
+ * sequence steps that straddle chunk boundaries.
+ */
+class CaptureStats {
+public:
+    explicit CaptureStats(const AnalyzerConfig &config);
+
+    void process(const struct CaptureRecord *records, size_t n);
+    void merge(const CaptureStats &later);
+
+    uint64_t frames() const { return frames_; }
+    uint64_t skipped() const { return skipped_; }
+    int64_t firstUs() const { return firstUs_; }
+    int64_t lastUs() const { return lastUs_; }
+
+    /* Per-ID statistics, extended IDs carry CAN_EFF_FLAG and remote
+     * frames CAN_RTR_FLAG */
+    std::map<canid_t, IdStats> byId() const;
+
+    /* Bits on the wire per window, starting at window firstWindow() */
+    int64_t firstWindow() const { return firstWindow_; }
+    const std::vector<uint64_t> &windowBits() const { return windowBits_; }
+
+    /* Nominal frame length without stuff bits: SOF to EOF plus the
+     * 3 bit intermission, so loads are a lower bound (stuffing adds up
+     * to ~20%) */
+    static uint32_t frameBits(canid_t id, uint8_t dlc);
+
+private:
+    /* Records transposed per block into the SoA batch */
+    static const size_t BLOCK = 4096;
+
+    AnalyzerConfig config_;
+    CanBatch batch_;
+    std::vector<uint8_t> hits_;
+    std::vector<uint32_t> bits_;
+
+    std::vector<IdStats> standard_;               /* data frames, by 11 bit ID */
+    std::unordered_map<canid_t, IdStats> other_;  /* extended and remote frames */
+
+    uint64_t frames_;
+    uint64_t skipped_;
+    int64_t firstUs_;
+    int64_t lastUs_;
+    int64_t firstWindow_;
+    std::vector<uint64_t> windowBits_;
+
+    void processBlock();
+    IdStats &statsFor(canid_t id);
+    void addWindowBits(int64_t timestampUs, uint32_t bits);
+};
+
+#endif /* CAPTURE_STATS_H_ */
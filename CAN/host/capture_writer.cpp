@@ -0,0 +1,109 @@
+#include "capture_writer.h"
+
+#include <inttypes.h>
+#include <string.h>
+
+CandumpWriter::CandumpWriter(FILE *out, const char *interfaceName)
+    : out_(out), interface_(interfaceName)
+{
+}
+
+bool CandumpWriter::write(int64_t timestampUs, const struct can_frame &frame)
+{
+    char id[16];
+    if (frame.can_id & CAN_EFF_FLAG) {
+        snprintf(id, sizeof(id), "%08" PRIX32, (uint32_t)(frame.can_id & CAN_EFF_MASK));
+    } else {
+        snprintf(id, sizeof(id), "%03" PRIX32, (uint32_t)(frame.can_id & CAN_SFF_MASK));
+    }
+
+    /* "R" plus the requested length for remote frames, hex bytes otherwise */
+    char payload[2 * CAN_MAX_DLEN + 1];
+    if (frame.can_id & CAN_RTR_FLAG) {
+        snprintf(payload, sizeof(payload), "R%u", frame.can_dlc);
+    } else {
+        for (int i = 0; i < frame.can_dlc; i++) {
+            snprintf(&payload[2 * i], 3, "%02X", frame.data[i]);
+        }
+        payload[2 * frame.can_dlc] = '\0';
+    }
+
+    int64_t seconds = timestampUs / 1000000;
+    int64_t micros = timestampUs % 1000000;
+    return fprintf(out_, "(%" PRId64 ".%06" PRId64 ") %s %s#%s\n",
+                   seconds, micros, interface_, id, payload) > 0;
+}
+
+/* LINKTYPE_CAN_SOCKETCAN: the SocketCAN frame with can_id in network order */
+static const uint32_t PCAP_LINKTYPE_CAN_SOCKETCAN = 227;
+
+PcapWriter::PcapWriter(FILE *out)
+    : out_(out), headerWritten_(false)
+{
+}
+
+bool PcapWriter::write(int64_t timestampUs, const struct can_frame &frame)
+{
+    if (!headerWritten_) {
+        /* Written in host order; readers detect it from the magic */
+        struct {
+            uint32_t magic;
+            uint16_t versionMajor;
+            uint16_t versionMinor;
+            int32_t thiszone;
+            uint32_t sigfigs;
+            uint32_t snaplen;
+            uint32_t linktype;
+        } header = {0xA1B2C3D4, 2, 4, 0, 0, sizeof(struct can_frame), PCAP_LINKTYPE_CAN_SOCKETCAN};
+        if (fwrite(&header, sizeof(header), 1, out_) != 1) {
+            return false;
+        }
+        headerWritten_ = true;
+    }
+
+    struct {
+        uint32_t seconds;
+        uint32_t micros;
+        uint32_t capturedLen;
+        uint32_t originalLen;
+        uint8_t frame[sizeof(struct can_frame)];
+    } record;
+    record.seconds = (uint32_t)(timestampUs / 1000000);
+    record.micros = (uint32_t)(timestampUs % 1000000);
+    record.capturedLen = sizeof(struct can_frame);
+    record.originalLen = sizeof(struct can_frame);
+
+    memcpy(record.frame, &frame, sizeof(frame));
+    memset(&record.frame[5], 0, 3); /* padding and reserved bytes */
+    record.frame[0] = (uint8_t)(frame.can_id >> 24);
+    record.frame[1] = (uint8_t)(frame.can_id >> 16);
+    record.frame[2] = (uint8_t)(frame.can_id >> 8);
+    record.frame[3] = (uint8_t)frame.can_id;
+
+    return fwrite(&record, sizeof(record), 1, out_) == 1;
+}
+
+BinaryCaptureWriter::BinaryCaptureWriter(FILE *out)
+    : out_(out), headerWritten_(false)
+{
+}
+
+bool BinaryCaptureWriter::write(int64_t timestampUs, const struct can_frame &frame)
+{
+    if (!headerWritten_) {
+        struct CaptureFileHeader header;
+        captureHeaderInit(&header);
+        if (fwrite(&header, sizeof(header), 1, out_) != 1) {
+            return false;
+        }
+        headerWritten_ = true;
+    }
+
+    struct CaptureRecord record;
+    memset(&record, 0, sizeof(record));
+    record.timestampUs = timestampUs;
+    record.frame.can_id = frame.can_id;
+    record.frame.can_dlc = frame.can_dlc;
+    memcpy(record.frame.data, frame.data, CAN_MAX_DLEN);
+    return fwrite(&record, sizeof(record), 1, out_) == 1;
+}
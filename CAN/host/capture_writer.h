@@ -0,0 +1,51 @@
+#ifndef CAPTURE_WRITER_H_
+#define CAPTURE_WRITER_H_
+
+#include <stdint.h>
+#include <stdio.h>
+
+#include "can.h"
+#include "capture_file.h"
+
+/* Sinks for decoded frames; timestamps are microseconds since the epoch
+ * (or since the sniffer booted, when the caller keeps device time) */
+class CaptureWriter {
+public:
+    virtual ~CaptureWriter() {}
+    virtual bool write(int64_t timestampUs, const struct can_frame &frame) = 0;
+};
+
+/* candump -l log lines: "(1700000000.123456) can0 123#DEADBEEF" */
+class CandumpWriter : public CaptureWriter {
+public:
+    CandumpWriter(FILE *out, const char *interfaceName);
+    bool write(int64_t timestampUs, const struct can_frame &frame);
+
+private:
+    FILE *out_;
+    const char *interface_;
+};
+
+/* pcap with LINKTYPE_CAN_SOCKETCAN, readable by Wireshark and tcpdump */
+class PcapWriter : public CaptureWriter {
+public:
+    explicit PcapWriter(FILE *out);
+    bool write(int64_t timestampUs, const struct can_frame &frame);
+
+private:
+    FILE *out_;
+    bool headerWritten_;
+};
+
+/* Binary capture (capture_file.h), the input of can_analyze */
+class BinaryCaptureWriter : public CaptureWriter {
+public:
+    explicit BinaryCaptureWriter(FILE *out);
+    bool write(int64_t timestampUs, const struct can_frame &frame);
+
+private:
+    FILE *out_;
+    bool headerWritten_;
+};
+
+#endif /* CAPTURE_WRITER_H_ */
@@ -0,0 +1,187 @@
+#include "sniffer_stream.h"
+
+#include <string.h>
+
+#include "formato_sniffer.h"
+
+static uint16_t get16(const uint8_t *p)
+{
+    return (uint16_t)(p[0] | (p[1] << 8));
+}
+
+static uint32_t get32(const uint8_t *p)
+{
+    return (uint32_t)p[0] | ((uint32_t)p[1] << 8) | ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+static uint64_t get64(const uint8_t *p)
+{
+    return (uint64_t)get32(p) | ((uint64_t)get32(p + 4) << 32);
+}
+
+SnifferStreamDecoder::SnifferStreamDecoder(SnifferStreamListener *listener)
+    : listener_(listener), overflow_(false), synced_(false),
+      haveSequence_(false), lastSequence_(0), lastDrops_(0)
+{
+    memset(&stats_, 0, sizeof(stats_));
+    encoded_.reserve(MAX_PACKET);
+    decoded_.reserve(MAX_PACKET);
+}
+
+void SnifferStreamDecoder::feed(const uint8_t *data, size_t len)
+{
+    stats_.bytes += len;
+
+    for (size_t i = 0; i < len; i++) {
+        if (data[i] != 0) {
+            if (encoded_.size() < MAX_PACKET) {
+                encoded_.push_back(data[i]);
+            } else {
+                overflow_ = true;
+            }
+            continue;
+        }
+
+        /* Bytes before the first delimiter are the tail of a batch whose
+         * start we missed; they are not an error */
+        if (synced_) {
+            packet();
+        }
+        synced_ = true;
+        encoded_.clear();
+        overflow_ = false;
+    }
+}
+
+void SnifferStreamDecoder::packet()
+{
+    const char *reason = NULL;
+
+    if (encoded_.empty()) {
+        return;
+    }
+    if (overflow_) {
+        reason = "too long";
+    } else if (!unstuff()) {
+        reason = "bad COBS";
+    } else if (decoded_.size() < SNIFFER_TAM_CABECALHO + SNIFFER_TAM_CRC) {
+        reason = "too short";
+    } else if (sniffer_crc16(decoded_.data(), decoded_.size() - SNIFFER_TAM_CRC) !=
+               get16(&decoded_[decoded_.size() - SNIFFER_TAM_CRC])) {
+        reason = "CRC mismatch";
+    } else if (decoded_[SNIFFER_OFS_TIPO] != SNIFFER_TIPO_LOTE) {
+        reason = "unknown type";
+    } else if (!parseBatch()) {
+        reason = "truncated record";
+    }
+
+    if (reason != NULL) {
+        stats_.corruptBatches++;
+        if (listener_ != NULL) {
+            listener_->onCorruptBatch(reason);
+        }
+    }
+}
+
+bool SnifferStreamDecoder::unstuff()
+{
+    decoded_.clear();
+
+    size_t i = 0;
+    const size_t n = encoded_.size();
+    while (i < n) {
+        uint8_t code = encoded_[i++];
+        if (i + code - 1 > n) {
+            return false;
+        }
+        decoded_.insert(decoded_.end(), encoded_.begin() + i, encoded_.begin() + i + code - 1);
+        i += code - 1;
+        /* Every block shorter than 254 bytes stood for a zero, except the last */
+        if (code != 0xFF && i < n) {
+            decoded_.push_back(0);
+        }
+    }
+    return true;
+}
+
+bool SnifferStreamDecoder::parseBatch()
+{
+    const uint8_t *p = decoded_.data();
+    const uint8_t *end = p + decoded_.size() - SNIFFER_TAM_CRC;
+
+    uint16_t sequence = get16(p + SNIFFER_OFS_SEQUENCIA);
+    int64_t timestamp = (int64_t)get64(p + SNIFFER_OFS_INSTANTE);
+    uint32_t drops = get32(p + SNIFFER_OFS_PERDIDOS);
+
+    /* The CRC passed, so a record overrunning the batch is a format bug
+     * and the whole batch is rejected before anything is reported */
+    frames_.clear();
+    p += SNIFFER_TAM_CABECALHO;
+    while (p < end) {
+        uint8_t head = *p++;
+        uint32_t delta = 0;
+        for (int shift = 0;; shift += 7) {
+            if (p >= end || shift > 28) {
+                return false;
+            }
+            uint8_t b = *p++;
+            delta |= (uint32_t)(b & 0x7F) << shift;
+            if ((b & 0x80) == 0) {
+                break;
+            }
+        }
+        timestamp += delta;
+
+        struct can_frame frame;
+        memset(&frame, 0, sizeof(frame));
+        size_t idLen = (head & SNIFFER_REG_EXT) ? 4 : 2;
+        uint8_t dlc = head & SNIFFER_REG_DLC;
+        size_t dataLen = (head & SNIFFER_REG_RTR) ? 0 : (dlc > CAN_MAX_DLEN ? CAN_MAX_DLEN : dlc);
+        if ((size_t)(end - p) < idLen + dataLen) {
+            return false;
+        }
+        if (head & SNIFFER_REG_EXT) {
+            frame.can_id = (get32(p) & CAN_EFF_MASK) | CAN_EFF_FLAG;
+        } else {
+            frame.can_id = get16(p) & CAN_SFF_MASK;
+        }
+        if (head & SNIFFER_REG_RTR) {
+            frame.can_id |= CAN_RTR_FLAG;
+        }
+        p += idLen;
+        frame.can_dlc = dlc > CAN_MAX_DLC ? CAN_MAX_DLC : dlc;
+        memcpy(frame.data, p, dataLen);
+        p += dataLen;
+        frames_.push_back(std::make_pair(timestamp, frame));
+    }
+
+    if (haveSequence_) {
+        uint16_t missing = (uint16_t)(sequence - lastSequence_ - 1);
+        if (missing != 0) {
+            stats_.lostBatches += missing;
+            if (listener_ != NULL) {
+                listener_->onLostBatches(missing, sequence);
+            }
+        }
+        if (drops != lastDrops_) {
+            stats_.deviceDrops += drops - lastDrops_;
+            if (listener_ != NULL) {
+                listener_->onDeviceDrops(drops - lastDrops_, drops);
+            }
+        }
+    } else {
+        stats_.initialDeviceDrops = drops;
+    }
+    haveSequence_ = true;
+    lastSequence_ = sequence;
+    lastDrops_ = drops;
+
+    stats_.batches++;
+    stats_.frames += frames_.size();
+    if (listener_ != NULL) {
+        for (size_t i = 0; i < frames_.size(); i++) {
+            listener_->onFrame(frames_[i].first, frames_[i].second);
+        }
+    }
+    return true;
+}
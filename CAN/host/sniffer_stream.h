@@ -0,0 +1,74 @@
+#ifndef SNIFFER_STREAM_H_
+#define SNIFFER_STREAM_H_
+
+#include <stddef.h>
+#include <stdint.h>
+#include <utility>
+#include <vector>
+
+#include "can.h"
+
+/*
+ * Decoder for the CanSniffer UART stream (format in formato_sniffer.h):
+ * splits on 0x00, undoes COBS, checks the CRC and expands the
+ * delta-encoded records into timestamped can_frames.
+ */
+
+class SnifferStreamListener {
+public:
+    virtual ~SnifferStreamListener() {}
+
+    /* timestampUs is the sniffer's clock, microseconds since its boot */
+    virtual void onFrame(int64_t timestampUs, const struct can_frame &frame) = 0;
+
+    /* The sniffer reported 'lost' more dropped frames since the last batch */
+    virtual void onDeviceDrops(uint32_t lost, uint32_t total) {}
+
+    /* 'count' batches before sequence 'sequence' were lost on the link or
+     * discarded as corrupt */
+    virtual void onLostBatches(uint32_t count, uint16_t sequence) {}
+
+    /* A delimited packet failed COBS, length or CRC checks */
+    virtual void onCorruptBatch(const char *reason) {}
+};
+
+struct SnifferStreamStats {
+    uint64_t bytes;
+    uint64_t batches;
+    uint64_t frames;
+    uint64_t corruptBatches;
+    uint64_t lostBatches;
+    uint64_t deviceDrops;        /* drops reported while we were listening */
+    uint32_t initialDeviceDrops; /* drops already counted at the first batch */
+};
+
+class SnifferStreamDecoder {
+public:
+    explicit SnifferStreamDecoder(SnifferStreamListener *listener);
+
+    /* Feed raw bytes as read from the serial port, in any chunking */
+    void feed(const uint8_t *data, size_t len);
+
+    const SnifferStreamStats &stats() const { return stats_; }
+
+private:
+    /* Longest encoded batch accepted before resynchronising */
+    static const size_t MAX_PACKET = 16384;
+
+    SnifferStreamListener *listener_;
+    std::vector<uint8_t> encoded_;
+    std::vector<uint8_t> decoded_;
+    std::vector<std::pair<int64_t, struct can_frame> > frames_;
+    bool overflow_;
+    bool synced_;
+    bool haveSequence_;
+    uint16_t lastSequence_;
+    uint32_t lastDrops_;
+    SnifferStreamStats stats_;
+
+    void packet();
+    bool unstuff();
+    bool parseBatch();
+};
+
+#endif /* SNIFFER_STREAM_H_ */
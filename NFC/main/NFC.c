@@ -4,6 +4,7 @@
 #include "rc522.h"
 #include "driver/rc522_spi.h"
 #include "picc/rc522_mifare.h"
+#include "task_layout.h"
 
 static const char *TAG = "NFC_URL_WRITER";
 
@@ -15,6 +16,16 @@ const char *URL_PARA_GRAVAR = "https://www.ufc.br";
 #define RC522_SPI_SCANNER_GPIO_SDA 5  
 #define RC522_SCANNER_GPIO_RST    4  
 
+#define LOG_BUFFER_BYTES 4096
+
+// O leitor é a única tarefa de tempo real; log e monitor ficam no outro núcleo
+static const task_layout_entry_t task_table[] = {
+    // nome       núcleo                         prio  pilha (B)  período (ms)  CPU (%)
+    { "rc522",    TASK_LAYOUT_CORE_RT,              5, 4096,        125,          30 },
+    { "log",      TASK_LAYOUT_CORE_HOUSEKEEPING,    2, 3072,          0,          10 },
+    { "monitor",  TASK_LAYOUT_CORE_HOUSEKEEPING,    1, 3072,      30000,           2 },
+};
+
 // Chaves
 static const rc522_mifare_key_t default_key = { .value = { 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF } };
 static const rc522_mifare_key_t ndef_key = { .value = { 0xD3, 0xF7, 0xD3, 0xF7, 0xD3, 0xF7 } };
@@ -142,9 +153,22 @@ static void on_picc_state_changed(void *arg, esp_event_base_t base, int32_t even
 void app_main() {
     rc522_spi_create(&driver_config, &driver);
     rc522_driver_install(driver);
-    rc522_config_t scanner_config = { .driver = driver };
+    task_layout_init(task_table, sizeof(task_table) / sizeof(task_table[0]));
+    task_layout_defer_logging("log", LOG_BUFFER_BYTES);
+
+    const task_layout_entry_t *task = task_layout_get("rc522");
+    rc522_config_t scanner_config = {
+        .driver = driver,
+        .poll_interval_ms = task->period_ms,
+        .task_stack_size = task->stack_size,
+        .task_priority = task->priority,
+        .task_pinned = true,
+        .task_core_id = task->core_id,
+    };
     rc522_create(&scanner_config, &scanner);
     rc522_register_events(scanner, RC522_EVENT_PICC_STATE_CHANGED, on_picc_state_changed, NULL);
     rc522_start(scanner);
+    task_layout_attach("rc522", rc522_task_handle(scanner));
+    task_layout_start_monitor("monitor");
     ESP_LOGI(TAG, "Leitor iniciado. Aproxime um cartao para gravar a URL...");
 }
@@ -110,8 +110,16 @@ void app_main()
     rc522_register_events(scanner_1, RC522_EVENT_PICC_STATE_CHANGED, on_picc_state_changed, scanner_1);
     rc522_register_events(scanner_2, RC522_EVENT_PICC_STATE_CHANGED, on_picc_state_changed, scanner_2);
 
-    // Start scanners
+    // Start scanners together: one shared reset instead of one after the other
 
-    rc522_start(scanner_1);
-    rc522_start(scanner_2);
+    rc522_handle_t scanners[] = { scanner_1, scanner_2 };
+    rc522_start_result_t results[2];
+
+    if (rc522_start_all(scanners, 2, results) != ESP_OK) {
+        for (size_t i = 0; i < 2; i++) {
+            if (results[i].err != ESP_OK) {
+                ESP_LOGE(TAG, "Scanner #%u failed to start: %s", (unsigned)i + 1, esp_err_to_name(results[i].err));
+            }
+        }
+    }
 }
@@ -0,0 +1,44 @@
+#pragma once
+
+#include <driver/i2c_master.h>
+#include <driver/gpio.h>
+#include "rc522_driver.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define RC522_I2C_FAST_MODE_HZ      (400 * 1000)
+#define RC522_I2C_FAST_MODE_PLUS_HZ (1000 * 1000)
+
+typedef struct
+{
+    /**
+     * Bus to join, e.g. one already shared with other sensors.
+     * Leave NULL to have the driver create the bus from bus_config
+     * and delete it again on uninstall.
+     */
+    i2c_master_bus_handle_t bus_handle;
+    i2c_master_bus_config_t bus_config;
+
+    uint8_t device_address;
+
+    /**
+     * SCL frequency, up to RC522_I2C_FAST_MODE_PLUS_HZ where the SoC
+     * and the pull-ups of the board allow it.
+     */
+    uint32_t scl_speed_hz;
+    uint32_t rw_timeout_ms;
+
+    /**
+     * GPIO number of the RC522 RST pin.
+     * Set to -1 if the RST pin is not connected.
+     */
+    gpio_num_t rst_io_num;
+} rc522_i2c_config_t;
+
+esp_err_t rc522_i2c_create(const rc522_i2c_config_t *config, rc522_driver_handle_t *driver);
+
+#ifdef __cplusplus
+}
+#endif
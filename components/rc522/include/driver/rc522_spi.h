@@ -0,0 +1,51 @@
+#pragma once
+
+#include <driver/spi_master.h>
+#include <driver/gpio.h>
+#include "rc522_driver.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define RC522_SPI_WRITE (0)
+#define RC522_SPI_READ  (1)
+
+typedef struct
+{
+    spi_host_device_t host_id;
+    spi_bus_config_t *bus_config;
+
+    /**
+     * The driver runs the device full-duplex by default, which lets a
+     * multi-byte read (e.g. a FIFO drain) go out as one burst transaction.
+     * Set SPI_DEVICE_HALFDUPLEX in flags to fall back to one transaction
+     * per byte read. command_bits, address_bits and dummy_bits are
+     * overwritten by the driver.
+     */
+    spi_device_interface_config_t dev_config;
+    spi_dma_chan_t dma_chan;
+
+    /**
+     * GPIO number of the RC522 RST pin.
+     * Set to -1 if the RST pin is not connected.
+     */
+    gpio_num_t rst_io_num;
+
+    /**
+     * Optional arbitration of a bus shared with other drivers (leave
+     * bus_config NULL then; the owner of the bus initializes it).
+     * Every register access is wrapped in bus_acquire/bus_release, so
+     * the bus is held for at most one FIFO-sized burst, or one batch of
+     * register operations (the setup of a PICC command), at a time.
+     */
+    esp_err_t (*bus_acquire)(void *ctx);
+    void (*bus_release)(void *ctx);
+    void *bus_ctx;
+} rc522_spi_config_t;
+
+esp_err_t rc522_spi_create(const rc522_spi_config_t *config, rc522_driver_handle_t *driver);
+
+#ifdef __cplusplus
+}
+#endif
@@ -50,6 +50,9 @@ extern "C" {
 #define RC522_NXP_PAGE_SIZE 4
 #define RC522_NXP_READ_SIZE (RC522_NXP_PAGE_SIZE * 4)
 
+// Pages plus CRC_A of one FAST_READ reply must fit the 8-bit frame length
+#define RC522_NXP_FAST_READ_MAX_PAGES 63
+
 extern const uint8_t RC522_NXP_DEFAULT_PWD[RC522_NXP_PWD_SIZE];
 extern const uint8_t RC522_NXP_DEFAULT_PACK[RC522_NXP_PACK_SIZE];
 
@@ -265,6 +268,9 @@ esp_err_t rc522_nxp_read(
  * If supported, allows a variable number of pages to be read at once, instead
  * of the fixed 4 in READ.
  *
+ * The reply is streamed through the PCD FIFO, so one call reads up to
+ * RC522_NXP_FAST_READ_MAX_PAGES pages, not just what fits in 64 bytes.
+ *
  * @param start Page address to start reading from
  * @param end Page address to end reading (inclusive)
  * @param out_buffer Output buffer; should be at least (end-start+1) * 4 bytes
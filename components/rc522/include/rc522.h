@@ -0,0 +1,47 @@
+#pragma once
+
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "rc522_types.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+ESP_EVENT_DECLARE_BASE(RC522_EVENTS);
+
+esp_err_t rc522_create(const rc522_config_t *config, rc522_handle_t *out_rc522);
+
+esp_err_t rc522_register_events(
+    const rc522_handle_t rc522, rc522_event_t event, esp_event_handler_t event_handler, void *event_handler_arg);
+
+esp_err_t rc522_unregister_events(const rc522_handle_t rc522, rc522_event_t event, esp_event_handler_t event_handler);
+
+esp_err_t rc522_start(rc522_handle_t rc522);
+
+/**
+ * Starts several readers at once. The resets share one RST pulse and the
+ * PowerDown waits overlap, so the bring-up time barely grows with the
+ * number of readers. Each entry of out_results gets the outcome of the
+ * reader at the same index; ESP_FAIL if any of them failed to start.
+ */
+esp_err_t rc522_start_all(rc522_handle_t *readers, size_t count, rc522_start_result_t *out_results);
+
+esp_err_t rc522_pause(rc522_handle_t rc522);
+
+esp_err_t rc522_destroy(rc522_handle_t rc522);
+
+/**
+ * Handle of the polling task, for stack and CPU monitoring.
+ */
+TaskHandle_t rc522_task_handle(const rc522_handle_t rc522);
+
+/**
+ * Hit and miss counts of the register shadow. The counters only grow;
+ * compare two snapshots for an interval.
+ */
+esp_err_t rc522_shadow_stats(const rc522_handle_t rc522, rc522_shadow_stats_t *out_stats);
+
+#ifdef __cplusplus
+}
+#endif
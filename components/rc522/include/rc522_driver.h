@@ -0,0 +1,41 @@
+#pragma once
+
+#include <stdint.h>
+#include <esp_err.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef struct rc522_driver_handle *rc522_driver_handle_t;
+
+/**
+ * Register access counters since the driver was created.
+ * The counters only grow; take the difference between two snapshots
+ * to get the figures of an interval.
+ */
+typedef struct
+{
+    uint32_t reads;             /*<! Register reads (one per rc522_pcd_read_n) */
+    uint32_t read_bytes;        /*<! Bytes returned by those reads */
+    uint32_t read_transactions; /*<! Bus transactions the driver needed for them */
+    uint32_t writes;            /*<! Register writes (one per rc522_pcd_write_n) */
+    uint32_t write_bytes;       /*<! Bytes sent by those writes */
+    uint32_t bus_us;            /*<! Time spent in reads and writes, bus waits included */
+} rc522_driver_stats_t;
+
+esp_err_t rc522_driver_install(const rc522_driver_handle_t driver);
+
+esp_err_t rc522_driver_uninstall(const rc522_driver_handle_t driver);
+
+esp_err_t rc522_driver_get_stats(const rc522_driver_handle_t driver, rc522_driver_stats_t *out_stats);
+
+/**
+ * Bus clock the device runs at, e.g. the one picked by clock calibration
+ * (see rc522_config_t::clock_calibration).
+ */
+esp_err_t rc522_driver_get_clock(const rc522_driver_handle_t driver, uint32_t *out_clock_hz);
+
+#ifdef __cplusplus
+}
+#endif
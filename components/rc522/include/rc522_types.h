@@ -3,6 +3,7 @@
 #include <esp_err.h>
 #include <esp_event.h>
 #include <inttypes.h>
+#include <driver/gpio.h>
 #include "freertos/FreeRTOS.h"
 #include "rc522_driver.h"
 #include "rc522_picc.h"
@@ -28,6 +29,7 @@ extern "C" {
 #define RC522_ERR_RST_PIN_UNUSED                (RC522_ERR_BASE + 12)
 #define RC522_ERR_PCD_FIFO_EMPTY                (RC522_ERR_BASE + 13)
 #define RC522_ERR_HLTA_NOT_ACKED                (RC522_ERR_BASE + 14)
+#define RC522_ERR_PCD_FIFO_UNDERFLOW            (RC522_ERR_BASE + 15)
 
 typedef struct rc522 *rc522_handle_t;
 
@@ -37,9 +39,34 @@ typedef struct
     uint16_t poll_interval_ms;    /*<! Delay (in milliseconds) between polls */
     size_t task_stack_size;       /*<! Stack size of rc522 task */
     uint8_t task_priority;        /*<! Priority of rc522 task */
+    bool task_pinned;             /*<! Pin rc522 task to task_core_id (otherwise no affinity) */
+    BaseType_t task_core_id;      /*<! Core of rc522 task when pinned */
+    bool irq_enabled;             /*<! Wait on the IRQ pin instead of polling the interrupt registers */
+    gpio_num_t irq_io_num;        /*<! GPIO wired to the MFRC522 IRQ pin when irq_enabled */
+    bool clock_calibration;       /*<! Pick the fastest reliable bus clock at rc522_start */
     SemaphoreHandle_t task_mutex; /*<! Mutex for rc522 task */
 } rc522_config_t;
 
+/**
+ * Register shadow counters since the reader was created (see rc522_shadow_stats).
+ */
+typedef struct
+{
+    uint32_t hits;   /*<! Bit updates done as a single write from the shadow */
+    uint32_t misses; /*<! Bit updates that had to read the register first */
+} rc522_shadow_stats_t;
+
+#define RC522_START_ALL_MAX (8) // Readers one rc522_start_all call can bring up
+
+/**
+ * Outcome of rc522_start_all for one reader.
+ */
+typedef struct
+{
+    esp_err_t err;     /*<! ESP_OK when the reader is polling */
+    uint32_t ready_us; /*<! Time from the call to this reader being ready (0 when it was only resumed) */
+} rc522_start_result_t;
+
 typedef enum
 {
     RC522_EVENT_ANY = ESP_EVENT_ANY_ID,
@@ -0,0 +1,29 @@
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// ISO/IEC 14443-3 CRC_A: x^16 + x^12 + x^5 + 1, reflected, preset 0x6363
+#define RC522_CRC_A_PRESET (0x6363)
+
+uint16_t rc522_crc_a(const uint8_t *data, size_t length);
+
+/**
+ * Writes the CRC_A of the first length bytes right after them, LSB first,
+ * as it goes on the air. buffer must hold length + 2 bytes.
+ */
+void rc522_crc_a_append(uint8_t *buffer, size_t length);
+
+/**
+ * True when the last two of length bytes are the CRC_A of the ones before.
+ */
+bool rc522_crc_a_check(const uint8_t *buffer, size_t length);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,89 @@
+#include <driver/gpio.h>
+#include "rc522_types_internal.h"
+#include "rc522_driver.h"
+
+#define RC522_DRIVER_HARD_RST_PIN_PWR_DOWN_LEVEL (0)
+#define RC522_DRIVER_HARD_RST_PULSE_DURATION_MS  (15)
+
+typedef esp_err_t (*rc522_driver_install_handler_t)(const rc522_driver_handle_t driver);
+
+typedef esp_err_t (*rc522_driver_send_handler_t)(
+    const rc522_driver_handle_t driver, uint8_t address, const rc522_bytes_t *bytes);
+
+typedef esp_err_t (*rc522_driver_receive_handler_t)(
+    const rc522_driver_handle_t driver, uint8_t address, rc522_bytes_t *bytes);
+
+typedef esp_err_t (*rc522_driver_receive_regs_handler_t)(
+    const rc522_driver_handle_t driver, const uint8_t *addresses, uint8_t *out, uint8_t count);
+
+typedef esp_err_t (*rc522_driver_acquire_handler_t)(const rc522_driver_handle_t driver);
+
+typedef void (*rc522_driver_release_handler_t)(const rc522_driver_handle_t driver);
+
+typedef esp_err_t (*rc522_driver_set_clock_handler_t)(const rc522_driver_handle_t driver, uint32_t clock_hz);
+
+typedef esp_err_t (*rc522_driver_reset_handler_t)(const rc522_driver_handle_t driver);
+
+typedef esp_err_t (*rc522_driver_uninstall_handler_t)(const rc522_driver_handle_t driver);
+
+struct rc522_driver_handle
+{
+    void *config;
+    void *device;
+    void *bus;     // Bus the device sits on, for drivers that keep a handle to it
+    bool owns_bus; // The bus was created on install and is deleted on uninstall
+    rc522_driver_install_handler_t install;
+    rc522_driver_send_handler_t send;
+    rc522_driver_receive_handler_t receive;
+    rc522_driver_receive_regs_handler_t receive_regs; // Optional, NULL when each register needs its own read
+    rc522_driver_acquire_handler_t acquire; // Optional, NULL when the bus needs no holding
+    rc522_driver_release_handler_t release;
+    rc522_driver_set_clock_handler_t set_clock; // Optional, NULL when the clock is fixed
+    rc522_driver_reset_handler_t reset;
+    rc522_driver_uninstall_handler_t uninstall;
+    rc522_driver_stats_t stats; // Updated by the scan task only
+    uint8_t hold_depth;         // Nested rc522_driver_acquire_bus calls
+    uint32_t clock_hz;          // Bus clock in effect, set by the driver on install
+    gpio_num_t rst_io_num;      // RST pin, -1 when not connected
+};
+
+esp_err_t rc522_driver_init_rst_pin(gpio_num_t rst_io_num);
+
+esp_err_t rc522_driver_create(const void *config, size_t config_size, rc522_driver_handle_t *driver);
+
+esp_err_t rc522_driver_send(const rc522_driver_handle_t driver, uint8_t address, const rc522_bytes_t *bytes);
+
+esp_err_t rc522_driver_receive(const rc522_driver_handle_t driver, uint8_t address, rc522_bytes_t *bytes);
+
+/**
+ * Reads one byte from each of count registers, in one transaction when the
+ * driver can stream several addresses (receive_regs), else one by one.
+ */
+esp_err_t rc522_driver_receive_regs(
+    const rc522_driver_handle_t driver, const uint8_t *addresses, uint8_t *out, uint8_t count);
+
+/**
+ * Holds the bus across several send/receive calls, so no other device
+ * can take it in between. Calls nest; every acquire needs a release.
+ */
+esp_err_t rc522_driver_acquire_bus(const rc522_driver_handle_t driver);
+
+void rc522_driver_release_bus(const rc522_driver_handle_t driver);
+
+/**
+ * Switches the bus clock of the device. ESP_ERR_NOT_SUPPORTED when the
+ * driver has no set_clock handler. Not allowed while the bus is held.
+ */
+esp_err_t rc522_driver_set_clock(const rc522_driver_handle_t driver, uint32_t clock_hz);
+
+esp_err_t rc522_driver_reset(const rc522_driver_handle_t driver);
+
+/**
+ * The two halves of the hard reset pulse, so several readers can share
+ * one pulse. RC522_ERR_RST_PIN_UNUSED without an RST pin.
+ */
+esp_err_t rc522_driver_rst_assert(const rc522_driver_handle_t driver);
+
+esp_err_t rc522_driver_rst_release(const rc522_driver_handle_t driver);
+
+esp_err_t rc522_driver_destroy(rc522_driver_handle_t driver);
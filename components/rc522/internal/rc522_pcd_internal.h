@@ -10,6 +10,17 @@ extern "C" {
 #define RC522_PCD_MOD_WIDTH_REG_RESET_VALUE (38)
 #define RC522_PCD_TX_MODE_REG_RESET_VALUE   (0x00)
 #define RC522_PCD_RX_MODE_REG_RESET_VALUE   (RC522_PCD_RX_NO_ERR_BIT)
+#define RC522_PCD_FIFO_SIZE                 (64)
+#define RC522_PCD_TIMER_TICK_US             (25) // With the prescaler set by rc522_pcd_init
+#define RC522_PCD_RESET_POLL_MS             (1)  // PowerDown poll; one tick when the tick is longer
+#define RC522_PCD_RESET_ALL_MAX             (32)
+
+/**
+ * WaterLevelReg value. LoAlert is raised when the FIFO holds this many
+ * bytes or fewer, HiAlert when no more than this many bytes are free.
+ * At 106 kBd that leaves ~1.4 ms to refill or drain a streamed frame.
+ */
+#define RC522_PCD_STREAM_WATER_LEVEL (16)
 
 typedef enum
 {
@@ -42,6 +53,9 @@ typedef enum
     // Number of bytes stored in the FIFO buffer
     RC522_PCD_FIFO_LEVEL_REG = 0x0A,
 
+    // Level for FIFO underflow and overflow warning
+    RC522_PCD_WATER_LEVEL_REG = 0x0B,
+
     // Shows the MFRC522 software version
     RC522_PCD_VERSION_REG = 0x37,
 
@@ -218,6 +232,25 @@ enum // RC522_PCD_COM_INT_REQ_REG
     RC522_PCD_TIMER_IRQ_BIT = BIT0,
 };
 
+enum // RC522_PCD_COM_INT_EN_REG (other bits enable the matching RC522_PCD_COM_INT_REQ_REG bits)
+{
+    // IRQ pin is active low (inverted with respect to the Status1Reg register's IRq bit)
+    RC522_PCD_IRQ_INV_BIT = BIT7,
+
+    // Requests passed to the IRQ pin, except while a frame is streamed
+    RC522_PCD_COM_IEN_DEFAULT = RC522_PCD_IRQ_INV_BIT | RC522_PCD_RX_IRQ_BIT | RC522_PCD_IDLE_IRQ_BIT
+                                | RC522_PCD_TIMER_IRQ_BIT,
+};
+
+enum // RC522_PCD_DIV_INT_EN_REG
+{
+    // IRQ pin is a push-pull output instead of open drain
+    RC522_PCD_IRQ_PUSH_PULL_BIT = BIT7,
+
+    // Passes the CRCIRq bit to the IRQ pin
+    RC522_PCD_CRC_IEN_BIT = BIT2,
+};
+
 enum // RC522_PCD_COMMAND_REG
 {
     // Soft power-down mode entered
@@ -423,9 +456,135 @@ typedef union
     };
 } rc522_pcd_crc_t;
 
+/**
+ * Registers whose writable bits may change without a write from the host
+ * (command, interrupt, error and status registers, the FIFO). They are
+ * never shadowed nor merged in a batch; every other register keeps what
+ * was last written to it until the next reset.
+ */
+bool rc522_pcd_reg_is_volatile(rc522_pcd_register_t addr);
+
+// Operations and data bytes one batch can hold (a full FIFO plus a few
+// registers, or the register set of rc522_pcd_init)
+#define RC522_PCD_BATCH_MAX_OPS   (16)
+#define RC522_PCD_BATCH_DATA_SIZE (80)
+
+typedef enum
+{
+    RC522_PCD_BATCH_WRITE,
+    RC522_PCD_BATCH_READ,
+    RC522_PCD_BATCH_SET_BITS,
+    RC522_PCD_BATCH_CLEAR_BITS,
+} rc522_pcd_batch_op_type_t;
+
+typedef struct
+{
+    rc522_pcd_batch_op_type_t type;
+    rc522_pcd_register_t addr;
+    uint8_t offset; // Write: first byte in the batch data
+    uint8_t length; // Write: number of bytes
+    uint8_t bits;   // Set/clear bits: mask
+    uint8_t *out;   // Read: destination
+} rc522_pcd_batch_op_t;
+
+/**
+ * Register operations run back to back with the bus held, so no other
+ * device on a shared bus gets in between. Build on the stack with
+ * rc522_pcd_batch_init() and the append functions, then run it.
+ *
+ * Appending never fails; an overflow or a bad argument is kept in error
+ * and returned by rc522_pcd_batch_run().
+ * Written bytes are copied into the batch, so the source may go away.
+ */
+typedef struct
+{
+    rc522_pcd_batch_op_t ops[RC522_PCD_BATCH_MAX_OPS];
+    uint8_t data[RC522_PCD_BATCH_DATA_SIZE];
+    uint8_t op_count;
+    uint8_t data_length;
+    esp_err_t error;
+} rc522_pcd_batch_t;
+
+void rc522_pcd_batch_init(rc522_pcd_batch_t *batch);
+
+/**
+ * Appends a write. A write right after another one to the same register
+ * is merged with it: FIFO data is appended to the same transaction, and a
+ * configuration register keeps only the last value. Command, interrupt
+ * and status registers are never merged.
+ */
+void rc522_pcd_batch_write_n(rc522_pcd_batch_t *batch, rc522_pcd_register_t addr, const rc522_bytes_t *bytes);
+
+void rc522_pcd_batch_write(rc522_pcd_batch_t *batch, rc522_pcd_register_t addr, uint8_t val);
+
+/**
+ * Appends a one-byte read. Reads next to each other in the batch go out
+ * as one transaction when the driver supports it (full-duplex SPI), even
+ * for different registers.
+ */
+void rc522_pcd_batch_read(rc522_pcd_batch_t *batch, rc522_pcd_register_t addr, uint8_t *out);
+
+/**
+ * Appends a read-modify-write. When the batch already wrote the register
+ * and it is not volatile, the new value is known and the read is skipped.
+ */
+void rc522_pcd_batch_set_bits(rc522_pcd_batch_t *batch, rc522_pcd_register_t addr, uint8_t bits);
+
+void rc522_pcd_batch_clear_bits(rc522_pcd_batch_t *batch, rc522_pcd_register_t addr, uint8_t bits);
+
+esp_err_t rc522_pcd_batch_run(const rc522_handle_t rc522, rc522_pcd_batch_t *batch);
+
+/**
+ * Appends the TReloadReg writes for a timer timeout of timeout_us (up to
+ * ~1.6 s), skipping the bytes the register shadow shows are in place
+ * already. The timer starts at the end of every transmission (TAuto).
+ */
+void rc522_pcd_batch_set_timeout(const rc522_handle_t rc522, rc522_pcd_batch_t *batch, uint32_t timeout_us);
+
+/**
+ * Waits until any bit of mask is set in irq_reg (ComIrqReg or DivIrqReg)
+ * and returns the register in out_irq, or ESP_ERR_TIMEOUT.
+ *
+ * Without an IRQ pin the register is polled. With one, the calling task
+ * sleeps on a task notification (index 0) given by the pin's ISR and
+ * reads the register once per edge; the request bits it returns are
+ * cleared again so the pin is released for the next wait.
+ */
+esp_err_t rc522_pcd_wait_irq(
+    const rc522_handle_t rc522, rc522_pcd_register_t irq_reg, uint8_t mask, uint32_t timeout_ms, uint8_t *out_irq);
+
+esp_err_t rc522_pcd_irq_install(const rc522_handle_t rc522);
+
+void rc522_pcd_irq_uninstall(const rc522_handle_t rc522);
+
 esp_err_t rc522_pcd_reset(const rc522_handle_t rc522, uint32_t timeout_ms);
 
-esp_err_t rc522_pcd_calculate_crc(const rc522_handle_t rc522, const rc522_bytes_t *bytes, rc522_pcd_crc_t *result);
+/**
+ * Resets several PCDs together: one shared pulse on the RST lines (soft
+ * reset for readers without one), then PowerDown of all of them polled
+ * in turn. Entries whose result is not ESP_OK on entry are skipped; the
+ * others get their outcome. ESP_FAIL if any entry ends up failed.
+ */
+esp_err_t rc522_pcd_reset_all(const rc522_handle_t *pcds, size_t count, uint32_t timeout_ms, esp_err_t *results);
+
+/**
+ * Writes the CRC_A of bytes right after them, LSB first, with the engine
+ * chosen in Kconfig (RC522_CRC_ENGINE). bytes->ptr must have room for
+ * two more bytes. Frames longer than the FIFO always use the software CRC.
+ */
+esp_err_t rc522_pcd_append_crc(const rc522_handle_t rc522, const rc522_bytes_t *bytes);
+
+/**
+ * RC522_ERR_CRC_WRONG unless the last two bytes of frame are the CRC_A of
+ * the ones before, with the engine chosen in Kconfig.
+ */
+esp_err_t rc522_pcd_check_crc(const rc522_handle_t rc522, const rc522_bytes_t *frame);
+
+/**
+ * CRC_A on the MFRC522 coprocessor, whatever the Kconfig engine. At most
+ * RC522_PCD_FIFO_SIZE bytes, since the coprocessor reads them from the FIFO.
+ */
+esp_err_t rc522_pcd_calculate_crc_hw(const rc522_handle_t rc522, const rc522_bytes_t *bytes, rc522_pcd_crc_t *result);
 
 esp_err_t rc522_pcd_init(const rc522_handle_t rc522);
 
@@ -451,6 +610,15 @@ esp_err_t rc522_pcd_stop_crypto1(const rc522_handle_t rc522);
 
 esp_err_t rc522_pcd_rw_test(const rc522_handle_t rc522);
 
+/**
+ * Runs a 63-byte FIFO write/read loopback at increasing bus clocks and
+ * leaves the driver one step below the fastest clock that passes every
+ * round. The 1 MHz floor gets no margin step: if only it passes, it is used.
+ * Some registers may be garbled by the failing clocks: reset the PCD
+ * afterwards.
+ */
+esp_err_t rc522_pcd_calibrate_clock(const rc522_handle_t rc522, uint32_t *out_clock_hz);
+
 esp_err_t rc522_pcd_write_n(const rc522_handle_t rc522, rc522_pcd_register_t addr, const rc522_bytes_t *bytes);
 
 esp_err_t rc522_pcd_write(const rc522_handle_t rc522, rc522_pcd_register_t addr, uint8_t val);
@@ -459,6 +627,11 @@ esp_err_t rc522_pcd_read_n(const rc522_handle_t rc522, rc522_pcd_register_t addr
 
 esp_err_t rc522_pcd_read(const rc522_handle_t rc522, rc522_pcd_register_t addr, uint8_t *value_ref);
 
+/**
+ * Read-modify-write. Non-volatile registers are served from the shadow
+ * kept by rc522_pcd_write_n/rc522_pcd_read_n, so the update is a single
+ * write once the register was written or read since the last reset.
+ */
 esp_err_t rc522_pcd_set_bits(const rc522_handle_t rc522, rc522_pcd_register_t addr, uint8_t bits);
 
 esp_err_t rc522_pcd_clear_bits(const rc522_handle_t rc522, rc522_pcd_register_t addr, uint8_t bits);
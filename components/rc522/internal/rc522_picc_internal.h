@@ -69,6 +69,11 @@ typedef enum
     RC522_PICC_CMD_GETV = 0x60,
 } rc522_picc_command_t;
 
+// Frame waiting times of rc522_picc_transaction_t::fwt_us
+#define RC522_PICC_FWT_DEFAULT_US    (25000) // Everything without a specific one
+#define RC522_PICC_FWT_ACTIVATION_US (1000)  // REQA, WUPA, anticollision, SELECT, HLTA: the PICC answers in ~100 us
+#define RC522_PICC_FWT_WRITE_US      (25000) // MIFARE and NTAG writes: the PICC programs its EEPROM first
+
 typedef struct
 {
     rc522_pcd_command_t pcd_command;
@@ -77,6 +82,13 @@ typedef struct
     uint8_t rx_align;
     uint8_t valid_bits;
     bool check_crc;
+
+    /**
+     * Frame waiting time: how long the PCD timer waits for the first bit
+     * of the reply after the end of the transmission. 0 for
+     * RC522_PICC_FWT_DEFAULT_US.
+     */
+    uint32_t fwt_us;
 } rc522_picc_transaction_t;
 
 typedef struct rc522_picc_transaction_context rc522_picc_transaction_context_t;
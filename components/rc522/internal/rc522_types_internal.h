@@ -40,6 +40,11 @@ struct rc522
     rc522_state_t state;                  /*<! Current state */
     rc522_picc_t picc;
     EventGroupHandle_t bits;
+    uint8_t shadow[64];                   /*<! Last value of each configuration register, see rc522_pcd_set_bits */
+    uint64_t shadow_valid;                /*<! Bit n set when shadow[n] is known */
+    rc522_shadow_stats_t shadow_stats;
+    TaskHandle_t volatile irq_waiter;     /*<! Task blocked in rc522_pcd_wait_irq, woken by the IRQ pin */
+    bool irq_installed;
 };
 
 typedef struct
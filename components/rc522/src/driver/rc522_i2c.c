@@ -0,0 +1,162 @@
+#include <esp_check.h>
+#include "rc522_helpers_internal.h"
+#include "rc522_types_internal.h"
+#include "rc522_driver_internal.h"
+#include "driver/rc522_i2c.h"
+
+RC522_LOG_DEFINE_BASE();
+
+static esp_err_t rc522_i2c_install(const rc522_driver_handle_t driver)
+{
+    RC522_CHECK(driver == NULL);
+    RC522_CHECK(driver->config == NULL);
+
+    rc522_i2c_config_t *conf = (rc522_i2c_config_t *)(driver->config);
+
+    RC522_CHECK(conf->scl_speed_hz == 0);
+    RC522_CHECK(conf->scl_speed_hz > RC522_I2C_FAST_MODE_PLUS_HZ);
+
+    esp_err_t ret = ESP_OK;
+    i2c_master_bus_handle_t bus = conf->bus_handle;
+
+    if (bus == NULL) {
+        RC522_RETURN_ON_ERROR(i2c_new_master_bus(&conf->bus_config, &bus));
+        driver->owns_bus = true;
+    }
+
+    driver->bus = bus;
+
+    i2c_device_config_t dev_config = {
+        .dev_addr_length = I2C_ADDR_BIT_LEN_7,
+        .device_address = conf->device_address,
+        .scl_speed_hz = conf->scl_speed_hz,
+    };
+
+    ESP_GOTO_ON_ERROR(i2c_master_bus_add_device(bus, &dev_config, (i2c_master_dev_handle_t *)(&driver->device)),
+        error,
+        TAG,
+        "add device");
+
+    driver->clock_hz = conf->scl_speed_hz;
+
+    if (conf->rst_io_num > GPIO_NUM_NC) {
+        ESP_GOTO_ON_ERROR(rc522_driver_init_rst_pin(conf->rst_io_num), error, TAG, "rst pin");
+    }
+
+    return ESP_OK;
+error:
+    if (driver->device) {
+        i2c_master_bus_rm_device((i2c_master_dev_handle_t)(driver->device));
+        driver->device = NULL;
+    }
+    if (driver->owns_bus) {
+        i2c_del_master_bus(bus);
+        driver->owns_bus = false;
+    }
+    driver->bus = NULL;
+
+    return ret;
+}
+
+static esp_err_t rc522_i2c_send(const rc522_driver_handle_t driver, uint8_t address, const rc522_bytes_t *bytes)
+{
+    RC522_CHECK(driver == NULL);
+    RC522_CHECK(driver->config == NULL);
+    RC522_CHECK(driver->device == NULL);
+    RC522_CHECK_BYTES(bytes);
+
+    rc522_i2c_config_t *conf = (rc522_i2c_config_t *)(driver->config);
+
+    // Register address and payload go out as one write, straight
+    // from the caller's buffer
+    i2c_master_transmit_multi_buffer_info_t buffers[] = {
+        { .write_buffer = &address, .buffer_size = 1 },
+        { .write_buffer = bytes->ptr, .buffer_size = bytes->length },
+    };
+
+    RC522_RETURN_ON_ERROR(i2c_master_multi_buffer_transmit((i2c_master_dev_handle_t)(driver->device),
+        buffers,
+        sizeof(buffers) / sizeof(buffers[0]),
+        (int)conf->rw_timeout_ms));
+
+    return ESP_OK;
+}
+
+static esp_err_t rc522_i2c_receive(const rc522_driver_handle_t driver, uint8_t address, rc522_bytes_t *bytes)
+{
+    RC522_CHECK(driver == NULL);
+    RC522_CHECK(driver->config == NULL);
+    RC522_CHECK(driver->device == NULL);
+    RC522_CHECK_BYTES(bytes);
+
+    rc522_i2c_config_t *conf = (rc522_i2c_config_t *)(driver->config);
+
+    // Address and data go in one write-read transaction
+    driver->stats.read_transactions++;
+
+    RC522_RETURN_ON_ERROR(i2c_master_transmit_receive((i2c_master_dev_handle_t)(driver->device),
+        &address,
+        1,
+        bytes->ptr,
+        bytes->length,
+        (int)conf->rw_timeout_ms));
+
+    return ESP_OK;
+}
+
+static esp_err_t rc522_i2c_reset(const rc522_driver_handle_t driver)
+{
+    RC522_CHECK(driver == NULL);
+    RC522_CHECK(driver->config == NULL);
+
+    rc522_i2c_config_t *conf = (rc522_i2c_config_t *)(driver->config);
+
+    if (conf->rst_io_num < 0) {
+        return RC522_ERR_RST_PIN_UNUSED;
+    }
+
+    RC522_RETURN_ON_ERROR(gpio_set_level(conf->rst_io_num, RC522_DRIVER_HARD_RST_PIN_PWR_DOWN_LEVEL));
+    rc522_delay_ms(RC522_DRIVER_HARD_RST_PULSE_DURATION_MS);
+    RC522_RETURN_ON_ERROR(gpio_set_level(conf->rst_io_num, !RC522_DRIVER_HARD_RST_PIN_PWR_DOWN_LEVEL));
+    rc522_delay_ms(RC522_DRIVER_HARD_RST_PULSE_DURATION_MS);
+
+    return ESP_OK;
+}
+
+static esp_err_t rc522_i2c_uninstall(const rc522_driver_handle_t driver)
+{
+    RC522_CHECK(driver == NULL);
+    RC522_CHECK(driver->config == NULL);
+    RC522_CHECK(driver->device == NULL);
+
+    RC522_RETURN_ON_ERROR(i2c_master_bus_rm_device((i2c_master_dev_handle_t)(driver->device)));
+    driver->device = NULL;
+
+    // A bus joined from the caller stays up for its other devices. The one
+    // created on install is deleted by its handle: with i2c_port -1 the
+    // driver picked the port, so it cannot be looked up again.
+    if (driver->owns_bus) {
+        RC522_RETURN_ON_ERROR(i2c_del_master_bus((i2c_master_bus_handle_t)(driver->bus)));
+        driver->owns_bus = false;
+    }
+    driver->bus = NULL;
+
+    return ESP_OK;
+}
+
+esp_err_t rc522_i2c_create(const rc522_i2c_config_t *config, rc522_driver_handle_t *driver)
+{
+    RC522_CHECK(config == NULL);
+    RC522_CHECK(driver == NULL);
+
+    RC522_RETURN_ON_ERROR(rc522_driver_create(config, sizeof(rc522_i2c_config_t), driver));
+
+    (*driver)->install = rc522_i2c_install;
+    (*driver)->send = rc522_i2c_send;
+    (*driver)->receive = rc522_i2c_receive;
+    (*driver)->reset = rc522_i2c_reset;
+    (*driver)->uninstall = rc522_i2c_uninstall;
+    (*driver)->rst_io_num = config->rst_io_num;
+
+    return ESP_OK;
+}
@@ -0,0 +1,370 @@
+#include <string.h>
+#include <sys/param.h>
+#include <esp_attr.h>
+#include "rc522_helpers_internal.h"
+#include "rc522_types_internal.h"
+#include "rc522_driver_internal.h"
+#include "driver/rc522_spi.h"
+
+RC522_LOG_DEFINE_BASE();
+
+// Data bytes per burst transaction. With the address byte a burst is one
+// byte longer on the wire, and without DMA the host takes at most
+// SOC_SPI_MAXIMUM_BUFFER_SIZE (64) bytes per transaction, so a full FIFO
+// (64 bytes) goes out as two bursts.
+#define RC522_SPI_BURST_MAX (63)
+
+static inline bool rc522_spi_is_burst(const rc522_spi_config_t *conf)
+{
+    return (conf->dev_config.flags & SPI_DEVICE_HALFDUPLEX) == 0;
+}
+
+// MSB selects read (1) or write (0), bits 6-1 hold the register, LSB is 0
+static inline uint8_t rc522_spi_address_byte(uint8_t rw, uint8_t address)
+{
+    return (uint8_t)((rw << 7) | ((address & 0x3F) << 1));
+}
+
+static esp_err_t rc522_spi_add_device(const rc522_driver_handle_t driver)
+{
+    rc522_spi_config_t *conf = (rc522_spi_config_t *)(driver->config);
+
+    RC522_RETURN_ON_ERROR(
+        spi_bus_add_device(conf->host_id, &conf->dev_config, (spi_device_handle_t *)(&driver->device)));
+
+    // The host divides its source clock, so report what it really runs at
+    int actual_khz = 0;
+    RC522_RETURN_ON_ERROR(spi_device_get_actual_freq((spi_device_handle_t)(driver->device), &actual_khz));
+    driver->clock_hz = (uint32_t)actual_khz * 1000;
+
+    return ESP_OK;
+}
+
+static esp_err_t rc522_spi_install(const rc522_driver_handle_t driver)
+{
+    RC522_CHECK(driver == NULL);
+    RC522_CHECK(driver->config == NULL);
+
+    rc522_spi_config_t *conf = (rc522_spi_config_t *)(driver->config);
+
+    if (conf->bus_config) {
+        // overwrite bus config
+        conf->bus_config->quadwp_io_num = -1;
+        conf->bus_config->quadhd_io_num = -1;
+
+        RC522_RETURN_ON_ERROR(spi_bus_initialize(conf->host_id, conf->bus_config, conf->dma_chan));
+    }
+    else {
+        RC522_LOGD("skips spi bus initialization");
+    }
+
+    // {{ overwrite device config
+    if (conf->dev_config.clock_speed_hz == 0) {
+        conf->dev_config.clock_speed_hz = 5000000;
+    }
+
+    conf->dev_config.mode = 0;
+
+    if (conf->dev_config.queue_size == 0) {
+        conf->dev_config.queue_size = 7;
+    }
+
+    if (rc522_spi_is_burst(conf)) {
+        // Address bytes are framed by send/receive themselves
+        conf->dev_config.command_bits = 0;
+        conf->dev_config.address_bits = 0;
+        conf->dev_config.dummy_bits = 0;
+    }
+    else {
+        conf->dev_config.command_bits = 1;
+        conf->dev_config.address_bits = 6;
+        conf->dev_config.dummy_bits = 1;
+    }
+    // }}
+
+    RC522_RETURN_ON_ERROR(rc522_spi_add_device(driver));
+
+    if (conf->rst_io_num > GPIO_NUM_NC) {
+        RC522_RETURN_ON_ERROR(rc522_driver_init_rst_pin(conf->rst_io_num));
+    }
+
+    return ESP_OK;
+}
+
+// Inside rc522_driver_acquire_bus the bus is already held for the whole batch
+static inline esp_err_t rc522_spi_bus_acquire(const rc522_driver_handle_t driver)
+{
+    const rc522_spi_config_t *conf = (const rc522_spi_config_t *)(driver->config);
+
+    return (conf->bus_acquire && driver->hold_depth == 0) ? conf->bus_acquire(conf->bus_ctx) : ESP_OK;
+}
+
+static inline void rc522_spi_bus_release(const rc522_driver_handle_t driver)
+{
+    const rc522_spi_config_t *conf = (const rc522_spi_config_t *)(driver->config);
+
+    if (conf->bus_release && driver->hold_depth == 0) {
+        conf->bus_release(conf->bus_ctx);
+    }
+}
+
+static esp_err_t rc522_spi_acquire(const rc522_driver_handle_t driver)
+{
+    RC522_CHECK(driver->device == NULL);
+
+    RC522_RETURN_ON_ERROR(rc522_spi_bus_acquire(driver));
+
+    esp_err_t ret = spi_device_acquire_bus((spi_device_handle_t)(driver->device), portMAX_DELAY);
+    if (ret != ESP_OK) {
+        rc522_spi_bus_release(driver);
+    }
+
+    return ret;
+}
+
+static void rc522_spi_release(const rc522_driver_handle_t driver)
+{
+    spi_device_release_bus((spi_device_handle_t)(driver->device));
+    rc522_spi_bus_release(driver);
+}
+
+/**
+ * Writes are framed as [address, data...]. The RC522 does not auto-increment
+ * the address, so a write longer than one burst continues in a new
+ * transaction with the same address.
+ */
+static esp_err_t rc522_spi_send_burst(const rc522_driver_handle_t driver, uint8_t address, const rc522_bytes_t *bytes)
+{
+    WORD_ALIGNED_ATTR uint8_t tx[RC522_SPI_BURST_MAX + 1];
+    esp_err_t ret = ESP_OK;
+
+    tx[0] = rc522_spi_address_byte(RC522_SPI_WRITE, address);
+
+    for (size_t offset = 0; offset < bytes->length && ret == ESP_OK; offset += RC522_SPI_BURST_MAX) {
+        size_t n = MIN(bytes->length - offset, (size_t)RC522_SPI_BURST_MAX);
+
+        memcpy(tx + 1, bytes->ptr + offset, n);
+
+        ret = spi_device_polling_transmit((spi_device_handle_t)(driver->device),
+            &(spi_transaction_t) {
+                .length = 8 * (n + 1),
+                .tx_buffer = tx,
+            });
+    }
+
+    return ret;
+}
+
+/**
+ * Full-duplex burst read: the read address is sent once per byte and the
+ * RC522 answers each one on the following byte, so n bytes take n + 1 bytes
+ * on the wire, terminated by 0x00, in a single transaction:
+ *
+ *   MOSI: addr addr ... addr 00
+ *   MISO:  --  d0   ...  dn-2 dn-1
+ */
+static esp_err_t rc522_spi_receive_burst(const rc522_driver_handle_t driver, uint8_t address, rc522_bytes_t *bytes)
+{
+    WORD_ALIGNED_ATTR uint8_t tx[RC522_SPI_BURST_MAX + 1];
+    WORD_ALIGNED_ATTR uint8_t rx[RC522_SPI_BURST_MAX + 1];
+    esp_err_t ret = ESP_OK;
+
+    for (size_t offset = 0; offset < bytes->length && ret == ESP_OK; offset += RC522_SPI_BURST_MAX) {
+        size_t n = MIN(bytes->length - offset, (size_t)RC522_SPI_BURST_MAX);
+
+        memset(tx, rc522_spi_address_byte(RC522_SPI_READ, address), n);
+        tx[n] = 0x00;
+
+        driver->stats.read_transactions++;
+        ret = spi_device_polling_transmit((spi_device_handle_t)(driver->device),
+            &(spi_transaction_t) {
+                .length = 8 * (n + 1),
+                .tx_buffer = tx,
+                .rx_buffer = rx,
+            });
+
+        if (ret == ESP_OK) {
+            memcpy(bytes->ptr + offset, rx + 1, n);
+        }
+    }
+
+    return ret;
+}
+
+/**
+ * Same framing as a burst read, with a different address in each slot, so
+ * several registers come back in one transaction:
+ *
+ *   MOSI: a0 a1 ... an-1 00
+ *   MISO: -- d0 ... dn-2 dn-1
+ */
+static esp_err_t rc522_spi_receive_regs(
+    const rc522_driver_handle_t driver, const uint8_t *addresses, uint8_t *out, uint8_t count)
+{
+    RC522_CHECK(driver == NULL);
+    RC522_CHECK(driver->device == NULL);
+    RC522_CHECK(count < 1 || count > RC522_SPI_BURST_MAX);
+
+    WORD_ALIGNED_ATTR uint8_t tx[RC522_SPI_BURST_MAX + 1];
+    WORD_ALIGNED_ATTR uint8_t rx[RC522_SPI_BURST_MAX + 1];
+
+    for (uint8_t i = 0; i < count; i++) {
+        tx[i] = rc522_spi_address_byte(RC522_SPI_READ, addresses[i]);
+    }
+    tx[count] = 0x00;
+
+    RC522_RETURN_ON_ERROR(rc522_spi_bus_acquire(driver));
+
+    driver->stats.read_transactions++;
+    esp_err_t ret = spi_device_polling_transmit((spi_device_handle_t)(driver->device),
+        &(spi_transaction_t) {
+            .length = 8 * (count + 1),
+            .tx_buffer = tx,
+            .rx_buffer = rx,
+        });
+
+    rc522_spi_bus_release(driver);
+
+    if (ret == ESP_OK) {
+        memcpy(out, rx + 1, count);
+    }
+
+    return ret;
+}
+
+static esp_err_t rc522_spi_send(const rc522_driver_handle_t driver, uint8_t address, const rc522_bytes_t *bytes)
+{
+    RC522_CHECK(driver == NULL);
+    RC522_CHECK(driver->device == NULL);
+    RC522_CHECK_BYTES(bytes);
+
+    const rc522_spi_config_t *conf = (const rc522_spi_config_t *)(driver->config);
+
+    RC522_RETURN_ON_ERROR(rc522_spi_bus_acquire(driver));
+
+    esp_err_t ret = rc522_spi_is_burst(conf) ? rc522_spi_send_burst(driver, address, bytes)
+                                             : spi_device_polling_transmit((spi_device_handle_t)(driver->device),
+                                                   &(spi_transaction_t) {
+                                                       .cmd = RC522_SPI_WRITE,
+                                                       .addr = address,
+                                                       .length = 8 * bytes->length,
+                                                       .tx_buffer = bytes->ptr,
+                                                   });
+
+    rc522_spi_bus_release(driver);
+
+    return ret;
+}
+
+static esp_err_t rc522_spi_receive(const rc522_driver_handle_t driver, uint8_t address, rc522_bytes_t *bytes)
+{
+    RC522_CHECK(driver == NULL);
+    RC522_CHECK(driver->device == NULL);
+    RC522_CHECK_BYTES(bytes);
+
+    const rc522_spi_config_t *conf = (const rc522_spi_config_t *)(driver->config);
+    esp_err_t ret = ESP_OK;
+
+    RC522_RETURN_ON_ERROR(rc522_spi_bus_acquire(driver));
+
+    if (rc522_spi_is_burst(conf)) {
+        ret = rc522_spi_receive_burst(driver, address, bytes);
+    }
+    else {
+        // Half-duplex cannot clock the next address while the data comes in:
+        // one transaction per byte
+        for (uint8_t i = 0; i < bytes->length && ret == ESP_OK; i++) {
+            driver->stats.read_transactions++;
+            ret = spi_device_polling_transmit((spi_device_handle_t)(driver->device),
+                &(spi_transaction_t) {
+                    .cmd = RC522_SPI_READ,
+                    .addr = address,
+                    .rxlength = 8,
+                    .rx_buffer = (bytes->ptr + i),
+                });
+        }
+    }
+
+    rc522_spi_bus_release(driver);
+
+    RC522_RETURN_ON_ERROR(ret);
+
+    return ESP_OK;
+}
+
+static esp_err_t rc522_spi_reset(const rc522_driver_handle_t driver)
+{
+    RC522_CHECK(driver == NULL);
+    RC522_CHECK(driver->config == NULL);
+
+    rc522_spi_config_t *conf = (rc522_spi_config_t *)(driver->config);
+
+    if (conf->rst_io_num < 0) {
+        return RC522_ERR_RST_PIN_UNUSED;
+    }
+
+    RC522_RETURN_ON_ERROR(gpio_set_level(conf->rst_io_num, RC522_DRIVER_HARD_RST_PIN_PWR_DOWN_LEVEL));
+    rc522_delay_ms(RC522_DRIVER_HARD_RST_PULSE_DURATION_MS);
+    RC522_RETURN_ON_ERROR(gpio_set_level(conf->rst_io_num, !RC522_DRIVER_HARD_RST_PIN_PWR_DOWN_LEVEL));
+    rc522_delay_ms(RC522_DRIVER_HARD_RST_PULSE_DURATION_MS);
+
+    return ESP_OK;
+}
+
+static esp_err_t rc522_spi_set_clock(const rc522_driver_handle_t driver, uint32_t clock_hz)
+{
+    RC522_CHECK(driver == NULL);
+    RC522_CHECK(driver->device == NULL);
+    RC522_CHECK(driver->config == NULL);
+
+    rc522_spi_config_t *conf = (rc522_spi_config_t *)(driver->config);
+
+    // The clock of an SPI device is fixed when it's added, so add it again
+    RC522_RETURN_ON_ERROR(spi_bus_remove_device((spi_device_handle_t)(driver->device)));
+    driver->device = NULL;
+
+    conf->dev_config.clock_speed_hz = (int)clock_hz;
+
+    return rc522_spi_add_device(driver);
+}
+
+static esp_err_t rc522_spi_uninstall(const rc522_driver_handle_t driver)
+{
+    RC522_CHECK(driver == NULL);
+    RC522_CHECK(driver->device == NULL);
+    RC522_CHECK(driver->config == NULL);
+
+    RC522_RETURN_ON_ERROR(spi_bus_remove_device((spi_device_handle_t)(driver->device)));
+    driver->device = NULL;
+
+    rc522_spi_config_t *conf = (rc522_spi_config_t *)(driver->config);
+
+    if (conf->bus_config) {
+        RC522_RETURN_ON_ERROR(spi_bus_free(conf->host_id));
+    }
+
+    return ESP_OK;
+}
+
+esp_err_t rc522_spi_create(const rc522_spi_config_t *config, rc522_driver_handle_t *driver)
+{
+    RC522_CHECK(config == NULL);
+    RC522_CHECK(driver == NULL);
+
+    RC522_RETURN_ON_ERROR(rc522_driver_create(config, sizeof(rc522_spi_config_t), driver));
+
+    (*driver)->install = rc522_spi_install;
+    (*driver)->send = rc522_spi_send;
+    (*driver)->receive = rc522_spi_receive;
+    // Half-duplex cannot stream addresses while reading
+    (*driver)->receive_regs =
+        (config->dev_config.flags & SPI_DEVICE_HALFDUPLEX) == 0 ? rc522_spi_receive_regs : NULL;
+    (*driver)->acquire = rc522_spi_acquire;
+    (*driver)->release = rc522_spi_release;
+    (*driver)->set_clock = rc522_spi_set_clock;
+    (*driver)->reset = rc522_spi_reset;
+    (*driver)->uninstall = rc522_spi_uninstall;
+    (*driver)->rst_io_num = config->rst_io_num;
+
+    return ESP_OK;
+}
@@ -196,11 +196,7 @@ esp_err_t rc522_mifare_read(const rc522_handle_t rc522, const rc522_picc_t *picc
     cmd_buffer[1] = block_address;
 
     // Calculate CRC_A
-    rc522_pcd_crc_t crc = { 0 };
-    RC522_RETURN_ON_ERROR(rc522_pcd_calculate_crc(rc522, &(rc522_bytes_t) { .ptr = cmd_buffer, .length = 2 }, &crc));
-
-    cmd_buffer[2] = crc.lsb;
-    cmd_buffer[3] = crc.msb;
+    RC522_RETURN_ON_ERROR(rc522_pcd_append_crc(rc522, &(rc522_bytes_t) { .ptr = cmd_buffer, .length = 2 }));
 
     uint8_t block_buffer[RC522_MIFARE_BLOCK_SIZE + 2] = { 0 }; // +2 for CRC_A
 
@@ -226,25 +222,17 @@ static esp_err_t rc522_mifare_send(const rc522_handle_t rc522, const uint8_t *se
     RC522_CHECK(send_data == NULL);
     RC522_CHECK(send_length > RC522_MIFARE_BLOCK_SIZE);
 
-#pragma GCC diagnostic ignored "-Wcast-qual"
-    uint8_t *sdata = (uint8_t *)send_data;
-#pragma GCC diagnostic pop
-
-    rc522_pcd_crc_t crc = { 0 };
-    RC522_RETURN_ON_ERROR(
-        rc522_pcd_calculate_crc(rc522, &(rc522_bytes_t) { .ptr = sdata, .length = send_length }, &crc));
-
     uint8_t buffer[RC522_MIFARE_BLOCK_SIZE + 2]; // +2 for CRC_A
 
     memcpy(buffer, send_data, send_length);
-
-    buffer[send_length] = crc.lsb;
-    buffer[send_length + 1] = crc.msb;
+    RC522_RETURN_ON_ERROR(rc522_pcd_append_crc(rc522, &(rc522_bytes_t) { .ptr = buffer, .length = send_length }));
 
     send_length += 2;
 
+    // Also carries the data phase of WRITE and the value operations
     rc522_picc_transaction_t transaction = {
         .bytes = { .ptr = buffer, .length = send_length },
+        .fwt_us = RC522_PICC_FWT_WRITE_US,
     };
 
     rc522_picc_transaction_result_t result = {
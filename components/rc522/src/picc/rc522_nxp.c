@@ -264,10 +264,7 @@ esp_err_t rc522_nxp_keyauth_supported(const rc522_handle_t rc522, const rc522_pi
     buffer[0] = RC522_PICC_CMD_UL_AUTH;
     // buffer[1] is argument; 0x00 is fine for support check
 
-    rc522_pcd_crc_t crc = { 0 };
-    RC522_RETURN_ON_ERROR(rc522_pcd_calculate_crc(rc522, &(rc522_bytes_t) { .ptr = buffer, .length = 2 }, &crc));
-    buffer[2] = crc.lsb;
-    buffer[3] = crc.msb;
+    RC522_RETURN_ON_ERROR(rc522_pcd_append_crc(rc522, &(rc522_bytes_t) { .ptr = buffer, .length = 2 }));
 
     rc522_picc_transaction_t transaction = {
         .bytes = { .ptr = buffer, .length = 4 },
@@ -346,11 +343,7 @@ esp_err_t rc522_nxp_get_version(
 
     uint8_t buffer[10]; // Combined buffer; response is 8-byte data + 2-byte CRC
     buffer[0] = RC522_PICC_CMD_GETV;
-    rc522_pcd_crc_t crc = { 0 };
-    RC522_RETURN_ON_ERROR(rc522_pcd_calculate_crc(rc522, &(rc522_bytes_t) { .ptr = buffer, .length = 1 }, &crc));
-
-    buffer[1] = crc.lsb;
-    buffer[2] = crc.msb;
+    RC522_RETURN_ON_ERROR(rc522_pcd_append_crc(rc522, &(rc522_bytes_t) { .ptr = buffer, .length = 1 }));
 
     rc522_picc_transaction_t transaction = {
         .bytes = { .ptr = buffer, .length = 3 },
@@ -383,6 +376,7 @@ esp_err_t rc522_nxp_fast_read(const rc522_handle_t rc522, const rc522_picc_t *pi
     RC522_CHECK(!rc522_nxp_type_has_fast_read(picc->type));
     // some sanity checks - valid range, output buffer sufficiently large
     RC522_CHECK(start_page > end_page);
+    RC522_CHECK(end_page - start_page + 1 > RC522_NXP_FAST_READ_MAX_PAGES);
     RC522_CHECK(out_buffer->buffer_size < (end_page - start_page + 1) * 4);
 
     RC522_LOGD("NXP FAST_READ (start=%02" RC522_X ", end=%02" RC522_X ")", start_page, end_page);
@@ -390,15 +384,7 @@ esp_err_t rc522_nxp_fast_read(const rc522_handle_t rc522, const rc522_picc_t *pi
     uint8_t cmd_buffer[5] = { RC522_NXP_FAST_READ, start_page, end_page, 0, 0 };
     uint8_t byte_count = (end_page - start_page + 1) * 4;
 
-    rc522_pcd_crc_t crc = { 0 };
-    RC522_RETURN_ON_ERROR(rc522_pcd_calculate_crc(rc522,
-        &(rc522_bytes_t) {
-            .ptr = cmd_buffer,
-            .length = 3,
-        },
-        &crc));
-    cmd_buffer[3] = crc.lsb;
-    cmd_buffer[4] = crc.msb;
+    RC522_RETURN_ON_ERROR(rc522_pcd_append_crc(rc522, &(rc522_bytes_t) { .ptr = cmd_buffer, .length = 3 }));
 
     // I'd rather not malloc() here, but we need extra space for the CRC which
     // we're not guaranteed to have in out_buffer
@@ -447,19 +433,12 @@ esp_err_t rc522_nxp_write(
 
     memcpy(&cmd_buffer[2], buffer, RC522_NXP_PAGE_SIZE);
 
-    rc522_pcd_crc_t crc = { 0 };
-    RC522_RETURN_ON_ERROR(rc522_pcd_calculate_crc(rc522,
-        &(rc522_bytes_t) {
-            .ptr = cmd_buffer,
-            .length = sizeof(cmd_buffer) - 2,
-        },
-        &crc));
-
-    cmd_buffer[2 + RC522_NXP_PAGE_SIZE] = crc.lsb;
-    cmd_buffer[2 + RC522_NXP_PAGE_SIZE + 1] = crc.msb;
+    RC522_RETURN_ON_ERROR(
+        rc522_pcd_append_crc(rc522, &(rc522_bytes_t) { .ptr = cmd_buffer, .length = sizeof(cmd_buffer) - 2 }));
 
     rc522_picc_transaction_t transaction = {
         .bytes = { .ptr = cmd_buffer, .length = sizeof(cmd_buffer) },
+        .fwt_us = RC522_PICC_FWT_WRITE_US,
     };
     rc522_picc_transaction_result_t result = {
         .bytes = { .ptr = cmd_buffer, .length = sizeof(cmd_buffer) },
@@ -488,15 +467,7 @@ esp_err_t rc522_nxp_read_cnt(
         0  // Space for reply (3 bytes + CRC)
     };
 
-    rc522_pcd_crc_t crc = { 0 };
-    RC522_RETURN_ON_ERROR(rc522_pcd_calculate_crc(rc522,
-        &(rc522_bytes_t) {
-            .ptr = cmd_buffer,
-            .length = sizeof(cmd_buffer) - 2,
-        },
-        &crc));
-    cmd_buffer[2] = crc.lsb;
-    cmd_buffer[3] = crc.msb;
+    RC522_RETURN_ON_ERROR(rc522_pcd_append_crc(rc522, &(rc522_bytes_t) { .ptr = cmd_buffer, .length = 2 }));
 
     rc522_picc_transaction_t transaction = {
         .bytes = { .ptr = cmd_buffer, .length = 4 },
@@ -528,15 +499,8 @@ esp_err_t rc522_nxp_pwd_auth(const rc522_handle_t rc522, const rc522_picc_t *pic
     cmd_buffer[0] = RC522_NXP_PWD_AUTH;
     memcpy(&cmd_buffer[1], pwd, RC522_NXP_PWD_SIZE);
 
-    rc522_pcd_crc_t crc = { 0 };
-    RC522_RETURN_ON_ERROR(rc522_pcd_calculate_crc(rc522,
-        &(rc522_bytes_t) {
-            .ptr = cmd_buffer,
-            .length = sizeof(cmd_buffer) - 2,
-        },
-        &crc));
-    cmd_buffer[1 + RC522_NXP_PWD_SIZE] = crc.lsb;
-    cmd_buffer[1 + RC522_NXP_PWD_SIZE + 1] = crc.msb;
+    RC522_RETURN_ON_ERROR(
+        rc522_pcd_append_crc(rc522, &(rc522_bytes_t) { .ptr = cmd_buffer, .length = sizeof(cmd_buffer) - 2 }));
 
     rc522_picc_transaction_t transaction = {
         .bytes = { .ptr = cmd_buffer, .length = sizeof(cmd_buffer) },
@@ -578,15 +542,8 @@ esp_err_t rc522_nxp_read_sig(const rc522_handle_t rc522, const rc522_picc_t *pic
         0 // CRC
     };
 
-    rc522_pcd_crc_t crc = { 0 };
-    RC522_RETURN_ON_ERROR(rc522_pcd_calculate_crc(rc522,
-        &(rc522_bytes_t) {
-            .ptr = cmd_buffer,
-            .length = sizeof(cmd_buffer) - 2,
-        },
-        &crc));
-    cmd_buffer[2] = crc.lsb;
-    cmd_buffer[3] = crc.msb;
+    RC522_RETURN_ON_ERROR(
+        rc522_pcd_append_crc(rc522, &(rc522_bytes_t) { .ptr = cmd_buffer, .length = sizeof(cmd_buffer) - 2 }));
 
     // TODO: Combine to single malloc() for both buffers?
     // Again, I'd rather not do a large malloc() here, but we need the space for
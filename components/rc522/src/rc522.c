@@ -1,6 +1,7 @@
 #include <esp_system.h>
 #include <esp_log.h>
 #include <esp_check.h>
+#include <esp_timer.h>
 #include <string.h>
 #include <sys/time.h>
 #include <freertos/FreeRTOS.h>
@@ -69,26 +70,105 @@ esp_err_t rc522_start(rc522_handle_t rc522)
 {
     RC522_CHECK(rc522 == NULL);
 
-    ESP_RETURN_ON_FALSE(rc522 != NULL, ESP_ERR_INVALID_ARG, TAG, "rc522 is null");
-    ESP_RETURN_ON_FALSE(rc522_is_able_to_start(rc522),
-        ESP_ERR_INVALID_STATE,
-        TAG,
-        "Unable to start (state=%d)",
-        rc522->state);
+    // One reader is just the smallest group: the same path, so the two can't drift apart
+    rc522_start_result_t result;
+    rc522_start_all(&rc522, 1, &result);
+
+    return result.err;
+}
+
+esp_err_t rc522_start_all(rc522_handle_t *readers, size_t count, rc522_start_result_t *out_results)
+{
+    RC522_CHECK(readers == NULL);
+    RC522_CHECK(out_results == NULL);
+    RC522_CHECK(count == 0 || count > RC522_START_ALL_MAX);
 
-    if (rc522->state == RC522_STATE_PAUSED) {
-        // Scanning has been paused. No need for reinitialization. Just resume
-        rc522->state = RC522_STATE_POLLING;
-        return ESP_OK;
+    int64_t start_us = esp_timer_get_time();
+    esp_err_t reset[RC522_START_ALL_MAX];
+    uint32_t calibrate = 0;
+
+    for (size_t i = 0; i < count; i++) {
+        out_results[i].ready_us = 0;
+        out_results[i].err = ESP_OK;
+        reset[i] = ESP_ERR_NOT_FINISHED; // Not part of the shared reset
+
+        if (readers[i] == NULL) {
+            out_results[i].err = ESP_ERR_INVALID_ARG;
+        }
+        else if (!rc522_is_able_to_start(readers[i])) {
+            RC522_LOGE("reader %u unable to start (state=%d)", (unsigned)i, readers[i]->state);
+            out_results[i].err = ESP_ERR_INVALID_STATE;
+        }
+        else if (readers[i]->state == RC522_STATE_PAUSED) {
+            readers[i]->state = RC522_STATE_POLLING; // No need for reinitialization
+        }
+        else {
+            reset[i] = ESP_OK;
+        }
     }
 
-    RC522_RETURN_ON_ERROR(rc522_pcd_reset(rc522, 150));
-    ESP_RETURN_ON_ERROR(rc522_pcd_rw_test(rc522), TAG, "rw test failed");
-    ESP_RETURN_ON_ERROR(rc522_pcd_init(rc522), TAG, "unable to init pcd");
+    rc522_pcd_reset_all(readers, count, 150, reset);
+
+    for (size_t i = 0; i < count; i++) {
+        if (reset[i] == ESP_ERR_NOT_FINISHED) {
+            continue;
+        }
 
-    rc522->state = RC522_STATE_POLLING;
+        out_results[i].err = reset[i];
 
-    return ESP_OK;
+        if (reset[i] != ESP_OK || !readers[i]->config->clock_calibration) {
+            reset[i] = ESP_ERR_NOT_FINISHED;
+            continue;
+        }
+
+        uint32_t clock_hz = 0;
+        if ((out_results[i].err = rc522_pcd_calibrate_clock(readers[i], &clock_hz)) != ESP_OK) {
+            RC522_LOGE("reader %u clock calibration failed", (unsigned)i);
+            reset[i] = ESP_ERR_NOT_FINISHED;
+            continue;
+        }
+
+        RC522_LOGI("reader %u bus clock calibrated to %" PRIu32 " Hz", (unsigned)i, clock_hz);
+        calibrate |= 1UL << i;
+    }
+
+    if (calibrate) {
+        // Writes at a failing clock may have landed in the wrong registers
+        rc522_pcd_reset_all(readers, count, 150, reset);
+
+        for (size_t i = 0; i < count; i++) {
+            if (calibrate & (1UL << i)) {
+                out_results[i].err = reset[i];
+            }
+        }
+    }
+
+    esp_err_t ret = ESP_OK;
+
+    for (size_t i = 0; i < count; i++) {
+        rc522_start_result_t *result = &out_results[i];
+        rc522_handle_t rc522 = readers[i];
+
+        if (result->err == ESP_OK && rc522->state != RC522_STATE_POLLING) {
+            if ((result->err = rc522_pcd_rw_test(rc522)) != ESP_OK) {
+                RC522_LOGE("reader %u rw test failed", (unsigned)i);
+            }
+            else if ((result->err = rc522_pcd_init(rc522)) != ESP_OK) {
+                RC522_LOGE("reader %u unable to init pcd", (unsigned)i);
+            }
+            else {
+                rc522->state = RC522_STATE_POLLING;
+                result->ready_us = (uint32_t)(esp_timer_get_time() - start_us);
+                RC522_LOGI("reader %u ready in %" PRIu32 " us", (unsigned)i, result->ready_us);
+            }
+        }
+
+        if (result->err != ESP_OK) {
+            ret = ESP_FAIL;
+        }
+    }
+
+    return ret;
 }
 
 esp_err_t rc522_pause(rc522_handle_t rc522)
@@ -128,6 +208,10 @@ esp_err_t rc522_create(const rc522_config_t *config, rc522_handle_t *out_rc522)
 
     ESP_GOTO_ON_ERROR(rc522_clone_config(config, &(rc522->config)), _error, TAG, "clone config failed");
 
+    if (rc522->config->irq_enabled) {
+        ESP_GOTO_ON_ERROR(rc522_pcd_irq_install(rc522), _error, TAG, "irq pin install failed");
+    }
+
     esp_event_loop_args_t event_args = {
         .queue_size = 1,
         .task_name = NULL, // no task will be created
@@ -141,12 +225,13 @@ esp_err_t rc522_create(const rc522_config_t *config, rc522_handle_t *out_rc522)
         TAG,
         "Failed to create event loop");
 
-    BaseType_t task_create_result = xTaskCreate(rc522_task,
+    BaseType_t task_create_result = xTaskCreatePinnedToCore(rc522_task,
         "rc522_polling_task",
         rc522->config->task_stack_size,
         rc522,
         rc522->config->task_priority,
-        &rc522->task_handle);
+        &rc522->task_handle,
+        rc522->config->task_pinned ? rc522->config->task_core_id : tskNO_AFFINITY);
 
     ESP_GOTO_ON_FALSE(task_create_result == pdTRUE, ESP_FAIL, _error, TAG, "task create failed");
 
@@ -179,6 +264,8 @@ esp_err_t rc522_destroy(rc522_handle_t rc522)
         rc522->bits = NULL;
     }
 
+    rc522_pcd_irq_uninstall(rc522);
+
     if (rc522->event_handle) {
         if (esp_event_loop_delete(rc522->event_handle) != ESP_OK) {
             ESP_LOGW(TAG, "Failed to delete event loop");
@@ -197,6 +284,21 @@ esp_err_t rc522_destroy(rc522_handle_t rc522)
     return ESP_OK;
 }
 
+TaskHandle_t rc522_task_handle(const rc522_handle_t rc522)
+{
+    return rc522 ? rc522->task_handle : NULL;
+}
+
+esp_err_t rc522_shadow_stats(const rc522_handle_t rc522, rc522_shadow_stats_t *out_stats)
+{
+    RC522_CHECK(rc522 == NULL);
+    RC522_CHECK(out_stats == NULL);
+
+    *out_stats = rc522->shadow_stats;
+
+    return ESP_OK;
+}
+
 esp_err_t rc522_dispatch_event(const rc522_handle_t rc522, rc522_event_t event, const void *data, size_t data_size)
 {
     RC522_RETURN_ON_ERROR(esp_event_post_to(rc522->event_handle, RC522_EVENTS, event, data, data_size, portMAX_DELAY));
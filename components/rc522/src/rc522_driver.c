@@ -0,0 +1,232 @@
+#include <string.h>
+#include <driver/gpio.h>
+#include <esp_timer.h>
+#include "rc522_types_internal.h"
+#include "rc522_driver_internal.h"
+
+RC522_LOG_DEFINE_BASE();
+
+esp_err_t rc522_driver_init_rst_pin(gpio_num_t rst_io_num)
+{
+    RC522_CHECK(rst_io_num < 0);
+
+    gpio_config_t io_conf = {
+        .intr_type = GPIO_INTR_DISABLE,
+        .mode = GPIO_MODE_OUTPUT,
+        .pin_bit_mask = (1ULL << rst_io_num),
+        .pull_down_en = GPIO_PULLDOWN_DISABLE,
+        .pull_up_en = GPIO_PULLUP_DISABLE,
+    };
+
+    RC522_RETURN_ON_ERROR(gpio_config(&io_conf));
+    RC522_RETURN_ON_ERROR(gpio_set_level(rst_io_num, !RC522_DRIVER_HARD_RST_PIN_PWR_DOWN_LEVEL));
+
+    return ESP_OK;
+}
+
+inline esp_err_t rc522_driver_install(const rc522_driver_handle_t driver)
+{
+    RC522_CHECK(driver == NULL);
+
+    return driver->install(driver);
+}
+
+inline esp_err_t rc522_driver_send(const rc522_driver_handle_t driver, uint8_t address, const rc522_bytes_t *bytes)
+{
+    RC522_CHECK(driver == NULL);
+    RC522_CHECK_BYTES(bytes);
+
+    driver->stats.writes++;
+    driver->stats.write_bytes += bytes->length;
+
+    int64_t start_us = esp_timer_get_time();
+    esp_err_t ret = driver->send(driver, address, bytes);
+    driver->stats.bus_us += (uint32_t)(esp_timer_get_time() - start_us);
+
+    return ret;
+}
+
+inline esp_err_t rc522_driver_receive(const rc522_driver_handle_t driver, uint8_t address, rc522_bytes_t *bytes)
+{
+    RC522_CHECK(driver == NULL);
+    RC522_CHECK_BYTES(bytes);
+
+    driver->stats.reads++;
+    driver->stats.read_bytes += bytes->length;
+
+    int64_t start_us = esp_timer_get_time();
+    esp_err_t ret = driver->receive(driver, address, bytes);
+    driver->stats.bus_us += (uint32_t)(esp_timer_get_time() - start_us);
+
+    return ret;
+}
+
+esp_err_t rc522_driver_receive_regs(
+    const rc522_driver_handle_t driver, const uint8_t *addresses, uint8_t *out, uint8_t count)
+{
+    RC522_CHECK(driver == NULL);
+    RC522_CHECK(addresses == NULL);
+    RC522_CHECK(out == NULL);
+    RC522_CHECK(count < 1);
+
+    driver->stats.reads += count;
+    driver->stats.read_bytes += count;
+
+    esp_err_t ret = ESP_OK;
+    int64_t start_us = esp_timer_get_time();
+
+    if (driver->receive_regs) {
+        ret = driver->receive_regs(driver, addresses, out, count);
+    }
+    else {
+        for (uint8_t i = 0; i < count && ret == ESP_OK; i++) {
+            ret = driver->receive(driver, addresses[i], &(rc522_bytes_t) { .ptr = &out[i], .length = 1 });
+        }
+    }
+
+    driver->stats.bus_us += (uint32_t)(esp_timer_get_time() - start_us);
+
+    return ret;
+}
+
+esp_err_t rc522_driver_acquire_bus(const rc522_driver_handle_t driver)
+{
+    RC522_CHECK(driver == NULL);
+
+    if (driver->hold_depth == 0 && driver->acquire) {
+        RC522_RETURN_ON_ERROR(driver->acquire(driver));
+    }
+    driver->hold_depth++;
+
+    return ESP_OK;
+}
+
+void rc522_driver_release_bus(const rc522_driver_handle_t driver)
+{
+    if (driver == NULL || driver->hold_depth == 0) {
+        return;
+    }
+
+    if (--driver->hold_depth == 0 && driver->release) {
+        driver->release(driver);
+    }
+}
+
+esp_err_t rc522_driver_set_clock(const rc522_driver_handle_t driver, uint32_t clock_hz)
+{
+    RC522_CHECK(driver == NULL);
+    RC522_CHECK(clock_hz == 0);
+    RC522_CHECK(driver->hold_depth > 0);
+
+    if (driver->set_clock == NULL) {
+        return ESP_ERR_NOT_SUPPORTED;
+    }
+
+    return driver->set_clock(driver, clock_hz);
+}
+
+inline esp_err_t rc522_driver_reset(const rc522_driver_handle_t driver)
+{
+    RC522_CHECK(driver == NULL);
+
+    return driver->reset(driver);
+}
+
+esp_err_t rc522_driver_rst_assert(const rc522_driver_handle_t driver)
+{
+    RC522_CHECK(driver == NULL);
+
+    if (driver->rst_io_num < 0) {
+        return RC522_ERR_RST_PIN_UNUSED;
+    }
+
+    return gpio_set_level(driver->rst_io_num, RC522_DRIVER_HARD_RST_PIN_PWR_DOWN_LEVEL);
+}
+
+esp_err_t rc522_driver_rst_release(const rc522_driver_handle_t driver)
+{
+    RC522_CHECK(driver == NULL);
+
+    if (driver->rst_io_num < 0) {
+        return RC522_ERR_RST_PIN_UNUSED;
+    }
+
+    return gpio_set_level(driver->rst_io_num, !RC522_DRIVER_HARD_RST_PIN_PWR_DOWN_LEVEL);
+}
+
+inline esp_err_t rc522_driver_uninstall(const rc522_driver_handle_t driver)
+{
+    RC522_CHECK(driver == NULL);
+
+    return driver->uninstall(driver);
+}
+
+esp_err_t rc522_driver_get_stats(const rc522_driver_handle_t driver, rc522_driver_stats_t *out_stats)
+{
+    RC522_CHECK(driver == NULL);
+    RC522_CHECK(out_stats == NULL);
+
+    *out_stats = driver->stats;
+
+    return ESP_OK;
+}
+
+esp_err_t rc522_driver_get_clock(const rc522_driver_handle_t driver, uint32_t *out_clock_hz)
+{
+    RC522_CHECK(driver == NULL);
+    RC522_CHECK(out_clock_hz == NULL);
+
+    *out_clock_hz = driver->clock_hz;
+
+    return ESP_OK;
+}
+
+esp_err_t rc522_driver_create(const void *config, size_t config_size, rc522_driver_handle_t *driver)
+{
+    RC522_CHECK(config == NULL);
+    RC522_CHECK(config_size == 0);
+    RC522_CHECK(driver == NULL);
+
+    esp_err_t ret = ESP_OK;
+
+    rc522_driver_handle_t _driver = calloc(1, sizeof(struct rc522_driver_handle));
+    ESP_RETURN_ON_FALSE(_driver != NULL, ESP_ERR_NO_MEM, TAG, "nomem");
+
+    _driver->config = calloc(1, config_size);
+    ESP_GOTO_ON_FALSE(_driver->config != NULL, ESP_ERR_NO_MEM, error, TAG, "nomem");
+
+    memcpy(_driver->config, config, config_size);
+
+    goto success;
+error:
+    rc522_driver_destroy(_driver);
+    goto exit;
+success:
+    *driver = _driver;
+exit:
+    return ret;
+}
+
+esp_err_t rc522_driver_destroy(rc522_driver_handle_t driver)
+{
+    RC522_CHECK(driver == NULL);
+
+    if (driver->config) {
+        free(driver->config);
+        driver->config = NULL;
+    }
+
+    driver->install = NULL;
+    driver->send = NULL;
+    driver->receive = NULL;
+    driver->acquire = NULL;
+    driver->release = NULL;
+    driver->set_clock = NULL;
+    driver->uninstall = NULL;
+
+    driver->device = NULL;
+
+    free(driver);
+
+    return ESP_OK;
+}
@@ -21,7 +21,11 @@ uint32_t rc522_millis()
 
 void rc522_delay_ms(uint32_t ms)
 {
-    vTaskDelay(pdMS_TO_TICKS(ms));
+    TickType_t ticks = pdMS_TO_TICKS(ms);
+
+    // At least one tick: with a 100 Hz tick a 1 ms poll would become
+    // vTaskDelay(0) and spin on the (maybe shared) bus
+    vTaskDelay((ms > 0 && ticks == 0) ? 1 : ticks);
 }
 
 esp_err_t rc522_buffer_to_hex_str(
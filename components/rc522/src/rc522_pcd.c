@@ -0,0 +1,993 @@
+#include <esp_system.h>
+#include <esp_check.h>
+#include <string.h>
+#include <sys/param.h>
+#include <driver/gpio.h>
+#include <esp_attr.h>
+
+#include "rc522_types_internal.h"
+#include "rc522_helpers_internal.h"
+#include "rc522_driver_internal.h"
+#include "rc522_pcd_internal.h"
+#include "rc522_crc_internal.h"
+
+RC522_LOG_DEFINE_BASE();
+
+#if CONFIG_RC522_CRC_CROSS_CHECK
+// The CRC_A right after bytes, as the software put it there, against the coprocessor
+static esp_err_t rc522_pcd_crc_cross_check(const rc522_handle_t rc522, const rc522_bytes_t *bytes)
+{
+    rc522_pcd_crc_t hw_crc = { 0 };
+    RC522_RETURN_ON_ERROR(rc522_pcd_calculate_crc_hw(rc522, bytes, &hw_crc));
+
+    if (bytes->ptr[bytes->length] != hw_crc.lsb || bytes->ptr[bytes->length + 1] != hw_crc.msb) {
+        RC522_LOGE("crc mismatch: software 0x%02" RC522_X "%02" RC522_X ", coprocessor 0x%04" RC522_X,
+            bytes->ptr[bytes->length + 1],
+            bytes->ptr[bytes->length],
+            hw_crc.value);
+
+        return ESP_ERR_INVALID_CRC;
+    }
+
+    return ESP_OK;
+}
+#endif
+
+esp_err_t rc522_pcd_append_crc(const rc522_handle_t rc522, const rc522_bytes_t *bytes)
+{
+    RC522_CHECK(rc522 == NULL);
+    RC522_CHECK_BYTES(bytes);
+
+    // The coprocessor is fed through the FIFO, so anything longer is
+    // computed in software whatever the engine is
+    if (bytes->length > RC522_PCD_FIFO_SIZE) {
+        rc522_crc_a_append(bytes->ptr, bytes->length);
+
+        return ESP_OK;
+    }
+
+#if CONFIG_RC522_CRC_HARDWARE
+    rc522_pcd_crc_t crc = { 0 };
+    RC522_RETURN_ON_ERROR(rc522_pcd_calculate_crc_hw(rc522, bytes, &crc));
+
+    bytes->ptr[bytes->length] = crc.lsb;
+    bytes->ptr[bytes->length + 1] = crc.msb;
+#else
+    rc522_crc_a_append(bytes->ptr, bytes->length);
+
+#if CONFIG_RC522_CRC_CROSS_CHECK
+    RC522_RETURN_ON_ERROR(rc522_pcd_crc_cross_check(rc522, bytes));
+#endif
+#endif
+
+    return ESP_OK;
+}
+
+esp_err_t rc522_pcd_check_crc(const rc522_handle_t rc522, const rc522_bytes_t *frame)
+{
+    RC522_CHECK(rc522 == NULL);
+    RC522_CHECK(frame == NULL || frame->ptr == NULL || frame->length < 3);
+
+    // See rc522_pcd_append_crc: e.g. a FAST_READ reply of more than 15 pages
+    if (frame->length - 2 > RC522_PCD_FIFO_SIZE) {
+        return rc522_crc_a_check(frame->ptr, frame->length) ? ESP_OK : RC522_ERR_CRC_WRONG;
+    }
+
+#if CONFIG_RC522_CRC_HARDWARE || CONFIG_RC522_CRC_CROSS_CHECK
+    const rc522_bytes_t data = { .ptr = frame->ptr, .length = frame->length - 2 };
+#endif
+
+#if CONFIG_RC522_CRC_HARDWARE
+    rc522_pcd_crc_t crc = { 0 };
+    RC522_RETURN_ON_ERROR(rc522_pcd_calculate_crc_hw(rc522, &data, &crc));
+
+    if (frame->ptr[data.length] != crc.lsb || frame->ptr[data.length + 1] != crc.msb) {
+        return RC522_ERR_CRC_WRONG;
+    }
+#else
+    if (!rc522_crc_a_check(frame->ptr, frame->length)) {
+        return RC522_ERR_CRC_WRONG;
+    }
+
+#if CONFIG_RC522_CRC_CROSS_CHECK
+    RC522_RETURN_ON_ERROR(rc522_pcd_crc_cross_check(rc522, &data));
+#endif
+#endif
+
+    return ESP_OK;
+}
+
+/**
+ * @see https://stackoverflow.com/a/48705557
+ */
+esp_err_t rc522_pcd_calculate_crc_hw(const rc522_handle_t rc522, const rc522_bytes_t *bytes, rc522_pcd_crc_t *result)
+{
+    RC522_CHECK(rc522 == NULL);
+    RC522_CHECK_BYTES(bytes);
+    RC522_CHECK(bytes->length > RC522_PCD_FIFO_SIZE);
+    RC522_CHECK(result == NULL);
+
+    rc522_pcd_batch_t setup;
+    rc522_pcd_batch_init(&setup);
+    rc522_pcd_batch_write(&setup, RC522_PCD_COMMAND_REG, RC522_PCD_IDLE_CMD);
+    // Set2 = 0: writing CRCIRq clears it
+    rc522_pcd_batch_write(&setup, RC522_PCD_DIV_INT_REQ_REG, RC522_PCD_CRC_IRQ_BIT);
+    rc522_pcd_batch_write(&setup, RC522_PCD_FIFO_LEVEL_REG, RC522_PCD_FLUSH_BUFFER_BIT);
+    rc522_pcd_batch_write_n(&setup, RC522_PCD_FIFO_DATA_REG, bytes);
+    rc522_pcd_batch_write(&setup, RC522_PCD_COMMAND_REG, RC522_PCD_CALC_CRC_CMD);
+    RC522_RETURN_ON_ERROR(rc522_pcd_batch_run(rc522, &setup));
+
+    uint8_t irq;
+    RC522_RETURN_ON_ERROR(rc522_pcd_wait_irq(rc522, RC522_PCD_DIV_INT_REQ_REG, RC522_PCD_CRC_IRQ_BIT, 90, &irq));
+
+    rc522_pcd_crc_t crc = { 0 };
+
+    rc522_pcd_batch_t result_batch;
+    rc522_pcd_batch_init(&result_batch);
+    rc522_pcd_batch_write(&result_batch, RC522_PCD_COMMAND_REG, RC522_PCD_IDLE_CMD);
+    rc522_pcd_batch_read(&result_batch, RC522_PCD_CRC_RESULT_MSB_REG, &crc.msb);
+    rc522_pcd_batch_read(&result_batch, RC522_PCD_CRC_RESULT_LSB_REG, &crc.lsb);
+    RC522_RETURN_ON_ERROR(rc522_pcd_batch_run(rc522, &result_batch));
+
+    if (RC522_LOG_LEVEL >= ESP_LOG_DEBUG) {
+        char debug_buffer[64];
+        rc522_buffer_to_hex_str(bytes->ptr, bytes->length, debug_buffer, sizeof(debug_buffer));
+        RC522_LOGD("crc(%s) = 0x%04" RC522_X, debug_buffer, crc.value);
+    }
+
+    *result = crc;
+
+    return ESP_OK;
+}
+
+static void IRAM_ATTR rc522_pcd_irq_isr(void *arg)
+{
+    rc522_handle_t rc522 = (rc522_handle_t)arg;
+    TaskHandle_t waiter = rc522->irq_waiter;
+
+    if (waiter != NULL) {
+        BaseType_t woken = pdFALSE;
+        vTaskNotifyGiveFromISR(waiter, &woken);
+        portYIELD_FROM_ISR(woken);
+    }
+}
+
+esp_err_t rc522_pcd_irq_install(const rc522_handle_t rc522)
+{
+    RC522_CHECK(rc522 == NULL);
+    RC522_CHECK(rc522->config->irq_io_num < 0);
+
+    gpio_config_t io_conf = {
+        .intr_type = GPIO_INTR_NEGEDGE,
+        .mode = GPIO_MODE_INPUT,
+        .pin_bit_mask = (1ULL << rc522->config->irq_io_num),
+        .pull_down_en = GPIO_PULLDOWN_DISABLE,
+        .pull_up_en = GPIO_PULLUP_ENABLE,
+    };
+
+    RC522_RETURN_ON_ERROR(gpio_config(&io_conf));
+
+    // The service may already be installed by another driver
+    esp_err_t ret = gpio_install_isr_service(0);
+    if (ret != ESP_OK && ret != ESP_ERR_INVALID_STATE) {
+        return ret;
+    }
+
+    RC522_RETURN_ON_ERROR(gpio_isr_handler_add(rc522->config->irq_io_num, rc522_pcd_irq_isr, rc522));
+    rc522->irq_installed = true;
+
+    return ESP_OK;
+}
+
+void rc522_pcd_irq_uninstall(const rc522_handle_t rc522)
+{
+    if (rc522 != NULL && rc522->irq_installed) {
+        gpio_isr_handler_remove(rc522->config->irq_io_num);
+        rc522->irq_installed = false;
+    }
+}
+
+static esp_err_t rc522_pcd_poll_irq(
+    const rc522_handle_t rc522, rc522_pcd_register_t irq_reg, uint8_t mask, uint32_t timeout_ms, uint8_t *out_irq)
+{
+    const uint32_t deadline_ms = rc522_millis() + timeout_ms;
+
+    do {
+        RC522_RETURN_ON_ERROR(rc522_pcd_read(rc522, irq_reg, out_irq));
+
+        if (*out_irq & mask) {
+            return ESP_OK;
+        }
+
+        taskYIELD();
+    }
+    while (rc522_millis() < deadline_ms);
+
+    return ESP_ERR_TIMEOUT;
+}
+
+static esp_err_t rc522_pcd_sleep_on_irq(
+    const rc522_handle_t rc522, rc522_pcd_register_t irq_reg, uint8_t mask, uint32_t timeout_ms, uint8_t *out_irq)
+{
+    const TickType_t timeout_ticks = pdMS_TO_TICKS(timeout_ms) + 1;
+    const TickType_t start = xTaskGetTickCount();
+    esp_err_t ret = ESP_ERR_TIMEOUT;
+
+    rc522->irq_waiter = xTaskGetCurrentTaskHandle();
+    ulTaskNotifyTake(pdTRUE, 0); // Drop edges from before this wait
+
+    while (true) {
+        // The edge may have come before the waiter was set: read once first
+        esp_err_t read_ret = rc522_pcd_read(rc522, irq_reg, out_irq);
+        if (read_ret != ESP_OK) {
+            ret = read_ret;
+            break;
+        }
+
+        if (*out_irq & mask) {
+            ret = ESP_OK;
+            break;
+        }
+
+        TickType_t elapsed = xTaskGetTickCount() - start;
+        if (elapsed >= timeout_ticks) {
+            break;
+        }
+
+        ulTaskNotifyTake(pdTRUE, timeout_ticks - elapsed);
+    }
+
+    rc522->irq_waiter = NULL;
+
+    if (ret == ESP_OK) {
+        // Set1/Set2 = 0: clears the request bits that are set, releasing the pin
+        ret = rc522_pcd_write(rc522, irq_reg, (uint8_t)(*out_irq & ~BIT7));
+    }
+
+    return ret;
+}
+
+esp_err_t rc522_pcd_wait_irq(
+    const rc522_handle_t rc522, rc522_pcd_register_t irq_reg, uint8_t mask, uint32_t timeout_ms, uint8_t *out_irq)
+{
+    RC522_CHECK(rc522 == NULL);
+    RC522_CHECK(out_irq == NULL);
+    RC522_CHECK(irq_reg != RC522_PCD_COM_INT_REQ_REG && irq_reg != RC522_PCD_DIV_INT_REQ_REG);
+
+    if (rc522->irq_installed) {
+        return rc522_pcd_sleep_on_irq(rc522, irq_reg, mask, timeout_ms, out_irq);
+    }
+
+    return rc522_pcd_poll_irq(rc522, irq_reg, mask, timeout_ms, out_irq);
+}
+
+// PowerDown is cleared once the oscillator runs and the PCD is ready
+static inline esp_err_t rc522_pcd_is_ready(const rc522_handle_t rc522, bool *out_ready)
+{
+    uint8_t cmd;
+    esp_err_t ret = rc522_pcd_read(rc522, RC522_PCD_COMMAND_REG, &cmd);
+
+    *out_ready = ret == ESP_OK && !(cmd & RC522_PCD_POWER_DOWN_BIT);
+
+    return ret;
+}
+
+static esp_err_t rc522_pcd_wait_for_reset(const rc522_handle_t rc522, uint32_t timeout_ms)
+{
+    RC522_CHECK(rc522 == NULL);
+
+    esp_err_t ret = ESP_OK;
+    bool ready = false;
+    uint32_t start_ms = rc522_millis();
+
+    // Wait for the PowerDown bit in CommandReg to be cleared.
+    // Delay first: a PCD still held in reset may read back as all zeros
+    do {
+        rc522_delay_ms(RC522_PCD_RESET_POLL_MS);
+
+        if ((ret = rc522_pcd_is_ready(rc522, &ready)) != ESP_OK) {
+            RC522_LOGD("wait for reset error %04" RC522_X, ret);
+        }
+    }
+    while (!ready && (rc522_millis() - start_ms) < timeout_ms);
+
+    return ready ? ESP_OK : ESP_ERR_TIMEOUT;
+}
+
+inline static esp_err_t rc522_pcd_hard_reset(const rc522_handle_t rc522, uint32_t timeout_ms)
+{
+    RC522_CHECK(rc522 == NULL);
+    RC522_LOGD("hard reset");
+
+    esp_err_t ret = rc522_driver_reset(rc522->config->driver);
+
+    return ret == ESP_OK ? rc522_pcd_wait_for_reset(rc522, timeout_ms) : ret;
+}
+
+inline static esp_err_t rc522_pcd_soft_reset(const rc522_handle_t rc522, uint32_t timeout_ms)
+{
+    RC522_CHECK(rc522 == NULL);
+    RC522_LOGD("soft reset");
+
+    RC522_RETURN_ON_ERROR(rc522_pcd_write(rc522, RC522_PCD_COMMAND_REG, RC522_PCD_SOFT_RESET_CMD));
+
+    return rc522_pcd_wait_for_reset(rc522, timeout_ms);
+}
+
+esp_err_t rc522_pcd_reset(const rc522_handle_t rc522, uint32_t timeout_ms)
+{
+    RC522_CHECK(rc522 == NULL);
+
+    esp_err_t ret = ESP_OK;
+
+    // Both resets bring every register back to its reset value
+    rc522->shadow_valid = 0;
+
+    if ((ret = rc522_pcd_hard_reset(rc522, timeout_ms)) != ESP_OK) {
+        if (ret != RC522_ERR_RST_PIN_UNUSED) {
+            RC522_LOGW("hard reset failed, trying soft reset");
+        }
+
+        ret = rc522_pcd_soft_reset(rc522, timeout_ms);
+    }
+
+    return ret;
+}
+
+esp_err_t rc522_pcd_reset_all(const rc522_handle_t *pcds, size_t count, uint32_t timeout_ms, esp_err_t *results)
+{
+    RC522_CHECK(pcds == NULL);
+    RC522_CHECK(results == NULL);
+    RC522_CHECK(count == 0 || count > RC522_PCD_RESET_ALL_MAX);
+
+    uint32_t hard = 0;    // Readers pulsed through their RST pin
+    uint32_t pending = 0; // Readers not ready yet
+
+    // One shared pulse: hold every RST line low at once
+    for (size_t i = 0; i < count; i++) {
+        if (results[i] != ESP_OK) {
+            continue;
+        }
+
+        pcds[i]->shadow_valid = 0;
+
+        esp_err_t ret = rc522_driver_rst_assert(pcds[i]->config->driver);
+        if (ret == ESP_OK) {
+            hard |= 1UL << i;
+        }
+        else if (ret != RC522_ERR_RST_PIN_UNUSED) {
+            results[i] = ret;
+        }
+    }
+
+    if (hard) {
+        rc522_delay_ms(RC522_DRIVER_HARD_RST_PULSE_DURATION_MS);
+    }
+
+    for (size_t i = 0; i < count; i++) {
+        if (results[i] != ESP_OK) {
+            continue;
+        }
+
+        results[i] = (hard & (1UL << i))
+                         ? rc522_driver_rst_release(pcds[i]->config->driver)
+                         : rc522_pcd_write(pcds[i], RC522_PCD_COMMAND_REG, RC522_PCD_SOFT_RESET_CMD);
+
+        if (results[i] == ESP_OK) {
+            pending |= 1UL << i;
+        }
+    }
+
+    uint32_t start_ms = rc522_millis();
+
+    while (pending && (rc522_millis() - start_ms) < timeout_ms) {
+        rc522_delay_ms(RC522_PCD_RESET_POLL_MS);
+
+        for (size_t i = 0; i < count; i++) {
+            bool ready = false;
+
+            // Read errors are expected while a reader is still in reset
+            if ((pending & (1UL << i)) && rc522_pcd_is_ready(pcds[i], &ready) == ESP_OK && ready) {
+                pending &= ~(1UL << i);
+            }
+        }
+    }
+
+    esp_err_t ret = ESP_OK;
+
+    for (size_t i = 0; i < count; i++) {
+        if (pending & (1UL << i)) {
+            results[i] = ESP_ERR_TIMEOUT;
+        }
+
+        if (results[i] != ESP_OK) {
+            ret = ESP_FAIL;
+        }
+    }
+
+    return ret;
+}
+
+static void rc522_pcd_batch_configure_timer(rc522_pcd_batch_t *batch, uint8_t mode, uint16_t prescaler)
+{
+    uint8_t prescaler_hi = (prescaler >> 8) & 0x0F;
+    uint8_t timer_mode = (mode & 0xF0) | prescaler_hi;
+    uint8_t prescaler_lo = (prescaler & 0xFF);
+
+    rc522_pcd_batch_write(batch, RC522_PCD_TIMER_MODE_REG, timer_mode);
+    rc522_pcd_batch_write(batch, RC522_PCD_TIMER_PRESCALER_REG, prescaler_lo);
+}
+
+inline static esp_err_t rc522_pcd_set_rx_gain(const rc522_handle_t rc522, rc522_pcd_rx_gain_t gain)
+{
+    return rc522_pcd_set_bits(rc522, RC522_PCD_RF_CFG_REG, gain);
+}
+
+esp_err_t rc522_pcd_init(const rc522_handle_t rc522)
+{
+    RC522_CHECK(rc522 == NULL);
+
+    // The whole register set goes out as one batch, with the bus held once
+    rc522_pcd_batch_t init;
+    rc522_pcd_batch_init(&init);
+
+    // Reset baud rates
+    rc522_pcd_batch_write(&init, RC522_PCD_TX_MODE_REG, RC522_PCD_TX_MODE_REG_RESET_VALUE);
+    rc522_pcd_batch_write(&init, RC522_PCD_RX_MODE_REG, RC522_PCD_RX_MODE_REG_RESET_VALUE);
+
+    // Reset modulation width
+    rc522_pcd_batch_write(&init, RC522_PCD_MOD_WIDTH_REG, RC522_PCD_MOD_WIDTH_REG_RESET_VALUE);
+
+    // When communicating with a PICC we need a timeout if something goes wrong.
+    // f_timer = 13.56 MHz / (2*TPreScaler+1) where TPreScaler = [TPrescaler_Hi:TPrescaler_Lo].
+    // TPrescaler_Hi are the four low bits in TModeReg. TPrescaler_Lo is TPrescalerReg.
+
+    // TAuto=1; timer starts automatically at the end of the transmission in all communication modes at all speeds
+    // TPreScaler = TModeReg[3..0]:TPrescalerReg, ie 0x0A9 = 169 => f_timer=40kHz, ie a timer period of 25μs.
+    rc522_pcd_batch_configure_timer(&init, RC522_PCD_T_AUTO_BIT, 169);
+
+    // Reload timer with 0x3E8 = 1000, ie 25ms before timeout.
+    // PICC transactions reprogram it with their own frame waiting time.
+    rc522_pcd_batch_set_timeout(rc522, &init, 1000 * RC522_PCD_TIMER_TICK_US);
+
+    rc522_pcd_batch_write(&init, RC522_PCD_TX_ASK_REG, RC522_PCD_FORCE_100_ASK_BIT);
+
+    // Default 0x3F. Set the preset value for the CRC coprocessor for the CalcCRC command to 0x6363 (ISO 14443-3
+    // part 6.2.4)
+    rc522_pcd_batch_write(&init,
+        RC522_PCD_MODE_REG,
+        (RC522_PCD_TX_WAIT_RF_BIT | RC522_PCD_POL_MFIN_BIT | RC522_PCD_CRC_PRESET_6363H));
+
+    // Alert levels for frames streamed through the FIFO
+    rc522_pcd_batch_write(&init, RC522_PCD_WATER_LEVEL_REG, RC522_PCD_STREAM_WATER_LEVEL);
+
+    if (rc522->config->irq_enabled) {
+        // Active-low push-pull IRQ for everything rc522_pcd_wait_irq waits on
+        rc522_pcd_batch_write(&init, RC522_PCD_COM_INT_EN_REG, RC522_PCD_COM_IEN_DEFAULT);
+        rc522_pcd_batch_write(&init, RC522_PCD_DIV_INT_EN_REG, (RC522_PCD_IRQ_PUSH_PULL_BIT | RC522_PCD_CRC_IEN_BIT));
+    }
+
+    // Enable the antenna driver pins TX1 and TX2 (they were disabled by the reset)
+    rc522_pcd_batch_set_bits(&init, RC522_PCD_TX_CONTROL_REG, (RC522_PCD_TX2_RF_EN_BIT | RC522_PCD_TX1_RF_EN_BIT));
+
+    uint8_t version = 0;
+    rc522_pcd_batch_read(&init, RC522_PCD_VERSION_REG, &version);
+
+    ESP_RETURN_ON_ERROR(rc522_pcd_batch_run(rc522, &init), TAG, "pcd init failed");
+
+    rc522_pcd_firmware_t fw = (rc522_pcd_firmware_t)version;
+
+    // When 0x00 or 0xFF is returned, communication probably failed
+    if (fw == 0x00 || fw == 0xFF) {
+        RC522_LOGE("Communication failure, is the MFRC522 properly connected?");
+
+        return ESP_FAIL; // TODO: use custom err
+    }
+
+    ESP_LOGI(TAG, "PCD (fw=%s) initialized", rc522_pcd_firmware_name(fw));
+
+    return ESP_OK;
+}
+
+esp_err_t rc522_pcd_firmware(const rc522_handle_t rc522, rc522_pcd_firmware_t *fw)
+{
+    RC522_CHECK(rc522 == NULL);
+    RC522_CHECK(fw == NULL);
+
+    uint8_t value;
+    RC522_RETURN_ON_ERROR(rc522_pcd_read(rc522, RC522_PCD_VERSION_REG, &value));
+
+    *fw = (rc522_pcd_firmware_t)value;
+
+    return ESP_OK;
+}
+
+char *rc522_pcd_firmware_name(rc522_pcd_firmware_t firmware)
+{
+    switch (firmware) {
+        case RC522_PCD_FIRMWARE_CLONE:
+            return "clone";
+        case RC522_PCD_FIRMWARE_00:
+            return "v0.0";
+        case RC522_PCD_FIRMWARE_10:
+            return "v1.0";
+        case RC522_PCD_FIRMWARE_20:
+            return "v2.0";
+        case RC522_PCD_FIRMWARE_COUNTERFEIT:
+            return "counterfeit_chip";
+        default:
+            return "unknown";
+    }
+}
+
+inline esp_err_t rc522_pcd_stop_active_command(const rc522_handle_t rc522)
+{
+    return rc522_pcd_write(rc522, RC522_PCD_COMMAND_REG, RC522_PCD_IDLE_CMD);
+}
+
+inline esp_err_t rc522_pcd_clear_all_com_interrupts(const rc522_handle_t rc522)
+{
+    return rc522_pcd_write(rc522, RC522_PCD_COM_INT_REQ_REG, (uint8_t)(~RC522_PCD_SET_1_BIT));
+}
+
+inline esp_err_t rc522_pcd_fifo_write(const rc522_handle_t rc522, const rc522_bytes_t *bytes)
+{
+    return rc522_pcd_write_n(rc522, RC522_PCD_FIFO_DATA_REG, bytes);
+}
+
+inline esp_err_t rc522_pcd_fifo_read(const rc522_handle_t rc522, rc522_bytes_t *bytes)
+{
+    return rc522_pcd_read_n(rc522, RC522_PCD_FIFO_DATA_REG, bytes);
+}
+
+inline esp_err_t rc522_pcd_fifo_flush(const rc522_handle_t rc522)
+{
+    return rc522_pcd_write(rc522, RC522_PCD_FIFO_LEVEL_REG, RC522_PCD_FLUSH_BUFFER_BIT);
+}
+
+inline esp_err_t rc522_pcd_start_data_transmission(const rc522_handle_t rc522)
+{
+    return rc522_pcd_set_bits(rc522, RC522_PCD_BIT_FRAMING_REG, RC522_PCD_START_SEND_BIT);
+}
+
+inline esp_err_t rc522_pcd_stop_data_transmission(const rc522_handle_t rc522)
+{
+    return rc522_pcd_clear_bits(rc522, RC522_PCD_BIT_FRAMING_REG, RC522_PCD_START_SEND_BIT);
+}
+
+inline esp_err_t rc522_pcd_stop_crypto1(const rc522_handle_t rc522)
+{
+    return rc522_pcd_clear_bits(rc522, RC522_PCD_STATUS_2_REG, RC522_PCD_MF_CRYPTO1_ON_BIT);
+}
+
+/**
+ * Writes pattern into the FIFO and reads it back into readback.
+ * Fails silently, since clock calibration expects some rounds to fail.
+ */
+static esp_err_t rc522_pcd_fifo_loopback(const rc522_handle_t rc522, const rc522_bytes_t *pattern, uint8_t *readback)
+{
+    uint8_t level = 0;
+
+    RC522_RETURN_ON_ERROR_SILENTLY(rc522_pcd_fifo_flush(rc522));
+    RC522_RETURN_ON_ERROR_SILENTLY(rc522_pcd_fifo_write(rc522, pattern));
+    RC522_RETURN_ON_ERROR_SILENTLY(rc522_pcd_read(rc522, RC522_PCD_FIFO_LEVEL_REG, &level));
+
+    if (level != pattern->length) {
+        return ESP_ERR_INVALID_SIZE;
+    }
+
+    RC522_RETURN_ON_ERROR_SILENTLY(
+        rc522_pcd_fifo_read(rc522, &(rc522_bytes_t) { .ptr = readback, .length = pattern->length }));
+
+    return memcmp(pattern->ptr, readback, pattern->length) == 0 ? ESP_OK : ESP_FAIL;
+}
+
+esp_err_t rc522_pcd_rw_test(const rc522_handle_t rc522)
+{
+    RC522_CHECK(rc522 == NULL);
+
+    uint8_t buffer1[] = { 0x13, 0x33, 0x37 };
+    const uint8_t buffer_size = sizeof(buffer1);
+    uint8_t buffer2[buffer_size];
+
+    esp_err_t ret = rc522_pcd_fifo_loopback(rc522, &(rc522_bytes_t) { .ptr = buffer1, .length = buffer_size }, buffer2);
+
+    if (ret == ESP_ERR_INVALID_SIZE) {
+        RC522_LOGE("FIFO length missmatch after write");
+    }
+    else if (ret == ESP_FAIL) {
+        RC522_LOGE("Buffers content missmatch");
+        RC522_LOGE("Buffer1: ");
+        ESP_LOG_BUFFER_HEX_LEVEL(TAG, buffer1, buffer_size, ESP_LOG_ERROR);
+        RC522_LOGE("Buffer2: ");
+        ESP_LOG_BUFFER_HEX_LEVEL(TAG, buffer2, buffer_size, ESP_LOG_ERROR);
+    }
+    else {
+        RC522_RETURN_ON_ERROR(ret);
+    }
+
+    return ret;
+}
+
+// SPI clocks tried by the calibration, slowest first; 10 MHz is the MFRC522 limit
+static const uint32_t rc522_pcd_clock_steps_hz[] = {
+    1000000,
+    2000000,
+    4000000,
+    5000000,
+    8000000,
+    10000000,
+};
+
+#define RC522_PCD_CLOCK_STEP_COUNT         (sizeof(rc522_pcd_clock_steps_hz) / sizeof(rc522_pcd_clock_steps_hz[0]))
+#define RC522_PCD_CLOCK_CALIBRATION_ROUNDS (4)
+
+esp_err_t rc522_pcd_calibrate_clock(const rc522_handle_t rc522, uint32_t *out_clock_hz)
+{
+    RC522_CHECK(rc522 == NULL);
+    RC522_CHECK(out_clock_hz == NULL);
+
+    rc522_driver_handle_t driver = rc522->config->driver;
+
+    if (driver->set_clock == NULL) {
+        RC522_LOGW("clock of this driver is fixed, calibration skipped");
+        *out_clock_hz = driver->clock_hz;
+
+        return ESP_OK;
+    }
+
+    // A nearly full FIFO of stuck-at, alternating and walking-bit patterns,
+    // which shows marginal timing much sooner than the three bytes of
+    // rw_test. One byte short of the FIFO so the address byte and the
+    // pattern still fit one 64-byte SPI transaction.
+    uint8_t pattern[RC522_PCD_FIFO_SIZE - 1];
+    uint8_t readback[RC522_PCD_FIFO_SIZE - 1];
+    static const uint8_t seeds[] = { 0x00, 0xFF, 0x55, 0xAA };
+
+    for (size_t i = 0; i < sizeof(pattern); i++) {
+        uint8_t walking = (uint8_t)(1 << (i & 0x07));
+
+        pattern[i] = (i < sizeof(pattern) / 2) ? seeds[i & 0x03] : ((i & 0x08) ? (uint8_t)~walking : walking);
+    }
+
+    const rc522_bytes_t pattern_bytes = { .ptr = pattern, .length = sizeof(pattern) };
+    int fastest = -1;
+
+    for (size_t step = 0; step < RC522_PCD_CLOCK_STEP_COUNT; step++) {
+        RC522_RETURN_ON_ERROR(rc522_driver_set_clock(driver, rc522_pcd_clock_steps_hz[step]));
+
+        bool passed = true;
+
+        for (int round = 0; round < RC522_PCD_CLOCK_CALIBRATION_ROUNDS && passed; round++) {
+            passed = rc522_pcd_fifo_loopback(rc522, &pattern_bytes, readback) == ESP_OK;
+        }
+
+        RC522_LOGD("clock %" PRIu32 " Hz: %s", driver->clock_hz, passed ? "pass" : "fail");
+
+        if (!passed) {
+            break;
+        }
+
+        fastest = (int)step;
+    }
+
+    if (fastest < 0) {
+        RC522_LOGE("FIFO loopback fails even at %" PRIu32 " Hz", rc522_pcd_clock_steps_hz[0]);
+
+        return ESP_FAIL;
+    }
+
+    // Keep one step of margin below the fastest passing clock. If the
+    // limit itself passed, every step below it did too. The slowest step
+    // has nothing below it, so a bus that only passes at 1 MHz runs there
+    // without margin.
+    int chosen = fastest;
+    if (fastest > 0 && fastest < (int)RC522_PCD_CLOCK_STEP_COUNT - 1) {
+        chosen = fastest - 1;
+    }
+
+    RC522_RETURN_ON_ERROR(rc522_driver_set_clock(driver, rc522_pcd_clock_steps_hz[chosen]));
+    *out_clock_hz = driver->clock_hz;
+
+    return ESP_OK;
+}
+
+static inline void rc522_pcd_shadow_store(const rc522_handle_t rc522, rc522_pcd_register_t addr, uint8_t value)
+{
+    if (!rc522_pcd_reg_is_volatile(addr)) {
+        rc522->shadow[addr] = value;
+        rc522->shadow_valid |= 1ULL << addr;
+    }
+}
+
+inline esp_err_t rc522_pcd_write_n(const rc522_handle_t rc522, rc522_pcd_register_t addr, const rc522_bytes_t *bytes)
+{
+    RC522_CHECK(rc522 == NULL);
+    RC522_CHECK_BYTES(bytes);
+
+    if (RC522_LOG_LEVEL >= ESP_LOG_VERBOSE) {
+        char debug_buffer[64];
+        rc522_buffer_to_hex_str(bytes->ptr, bytes->length, debug_buffer, sizeof(debug_buffer));
+        RC522_LOGV("pcd [0x%02" RC522_X "] <<< %s", addr, debug_buffer);
+    }
+
+    RC522_RETURN_ON_ERROR(rc522_driver_send(rc522->config->driver, addr, bytes));
+
+    rc522_pcd_shadow_store(rc522, addr, bytes->ptr[bytes->length - 1]);
+
+    return ESP_OK;
+}
+
+inline esp_err_t rc522_pcd_write(const rc522_handle_t rc522, rc522_pcd_register_t addr, uint8_t val)
+{
+    return rc522_pcd_write_n(rc522, addr, &(rc522_bytes_t) { .ptr = &val, .length = 1 });
+}
+
+inline esp_err_t rc522_pcd_read_n(const rc522_handle_t rc522, rc522_pcd_register_t addr, rc522_bytes_t *bytes)
+{
+    RC522_CHECK(rc522 == NULL);
+    RC522_CHECK_BYTES(bytes);
+
+    esp_err_t ret = rc522_driver_receive(rc522->config->driver, addr, bytes);
+
+    if (ret == ESP_OK) {
+        rc522_pcd_shadow_store(rc522, addr, bytes->ptr[bytes->length - 1]);
+    }
+
+    if (RC522_LOG_LEVEL >= ESP_LOG_VERBOSE) {
+        char debug_buffer[64];
+        rc522_buffer_to_hex_str(bytes->ptr, bytes->length, debug_buffer, sizeof(debug_buffer));
+        RC522_LOGV("pcd [0x%02" RC522_X "] >>> %s", addr, debug_buffer);
+    }
+
+    return ret;
+}
+
+inline esp_err_t rc522_pcd_read(const rc522_handle_t rc522, rc522_pcd_register_t addr, uint8_t *value_ref)
+{
+    return rc522_pcd_read_n(rc522, addr, &(rc522_bytes_t) { .ptr = value_ref, .length = 1 });
+}
+
+void rc522_pcd_batch_set_timeout(const rc522_handle_t rc522, rc522_pcd_batch_t *batch, uint32_t timeout_us)
+{
+    uint32_t ticks = (timeout_us + RC522_PCD_TIMER_TICK_US - 1) / RC522_PCD_TIMER_TICK_US;
+    uint16_t reload = (uint16_t)MIN(MAX(ticks, 1), UINT16_MAX);
+    const uint8_t bytes[] = { (uint8_t)(reload >> 8), (uint8_t)(reload & 0xFF) };
+    const rc522_pcd_register_t regs[] = { RC522_PCD_TIMER_RELOAD_MSB_REG, RC522_PCD_TIMER_RELOAD_LSB_REG };
+
+    for (size_t i = 0; i < sizeof(regs) / sizeof(regs[0]); i++) {
+        if ((rc522->shadow_valid & (1ULL << regs[i])) == 0 || rc522->shadow[regs[i]] != bytes[i]) {
+            rc522_pcd_batch_write(batch, regs[i], bytes[i]);
+        }
+    }
+}
+
+static esp_err_t rc522_pcd_update_bits(const rc522_handle_t rc522, rc522_pcd_register_t addr, uint8_t set, uint8_t clear)
+{
+    RC522_CHECK(rc522 == NULL);
+
+    uint8_t value;
+
+    if (rc522->shadow_valid & (1ULL << addr)) {
+        value = rc522->shadow[addr];
+        rc522->shadow_stats.hits++;
+    }
+    else {
+        RC522_RETURN_ON_ERROR(rc522_pcd_read(rc522, addr, &value));
+        rc522->shadow_stats.misses++;
+    }
+
+    return rc522_pcd_write(rc522, addr, (uint8_t)((value | set) & ~clear));
+}
+
+inline esp_err_t rc522_pcd_set_bits(const rc522_handle_t rc522, rc522_pcd_register_t addr, uint8_t bits)
+{
+    return rc522_pcd_update_bits(rc522, addr, bits, 0);
+}
+
+inline esp_err_t rc522_pcd_clear_bits(const rc522_handle_t rc522, rc522_pcd_register_t addr, uint8_t bits)
+{
+    return rc522_pcd_update_bits(rc522, addr, 0, bits);
+}
+
+bool rc522_pcd_reg_is_volatile(rc522_pcd_register_t addr)
+{
+    switch (addr) {
+        case RC522_PCD_COMMAND_REG:
+        case RC522_PCD_COM_INT_REQ_REG:
+        case RC522_PCD_DIV_INT_REQ_REG:
+        case RC522_PCD_ERROR_REG:
+        case RC522_PCD_STATUS_2_REG: // MFCrypto1On is set by MFAuthent
+        case RC522_PCD_FIFO_DATA_REG:
+        case RC522_PCD_FIFO_LEVEL_REG:
+            return true;
+        default:
+            // CollReg reads back collision status too, but only ValuesAfterColl is writable
+            return false;
+    }
+}
+
+void rc522_pcd_batch_init(rc522_pcd_batch_t *batch)
+{
+    batch->op_count = 0;
+    batch->data_length = 0;
+    batch->error = ESP_OK;
+}
+
+static rc522_pcd_batch_op_t *rc522_pcd_batch_append(
+    rc522_pcd_batch_t *batch, rc522_pcd_batch_op_type_t type, rc522_pcd_register_t addr)
+{
+    if (batch->op_count == RC522_PCD_BATCH_MAX_OPS) {
+        batch->error = ESP_ERR_NO_MEM;
+        return NULL;
+    }
+
+    rc522_pcd_batch_op_t *op = &batch->ops[batch->op_count++];
+    memset(op, 0, sizeof(*op));
+    op->type = type;
+    op->addr = addr;
+
+    return op;
+}
+
+void rc522_pcd_batch_write_n(rc522_pcd_batch_t *batch, rc522_pcd_register_t addr, const rc522_bytes_t *bytes)
+{
+    if (bytes == NULL || bytes->ptr == NULL || bytes->length < 1) {
+        batch->error = ESP_ERR_INVALID_ARG;
+        return;
+    }
+
+    rc522_pcd_batch_op_t *op = batch->op_count > 0 ? &batch->ops[batch->op_count - 1] : NULL;
+    bool merge = op != NULL && op->type == RC522_PCD_BATCH_WRITE && op->addr == addr;
+
+    if (merge && addr != RC522_PCD_FIFO_DATA_REG) {
+        if (rc522_pcd_reg_is_volatile(addr)) {
+            merge = false;
+        }
+        else {
+            // The previous write is the last data in the batch: overwrite it
+            batch->data_length = op->offset;
+            op->length = 0;
+        }
+    }
+
+    if (batch->data_length + bytes->length > RC522_PCD_BATCH_DATA_SIZE) {
+        batch->error = ESP_ERR_NO_MEM;
+        return;
+    }
+
+    if (!merge) {
+        op = rc522_pcd_batch_append(batch, RC522_PCD_BATCH_WRITE, addr);
+        if (op == NULL) {
+            return;
+        }
+        op->offset = batch->data_length;
+    }
+
+    memcpy(&batch->data[batch->data_length], bytes->ptr, bytes->length);
+    batch->data_length += bytes->length;
+    op->length += bytes->length;
+}
+
+void rc522_pcd_batch_write(rc522_pcd_batch_t *batch, rc522_pcd_register_t addr, uint8_t val)
+{
+    rc522_pcd_batch_write_n(batch, addr, &(rc522_bytes_t) { .ptr = &val, .length = 1 });
+}
+
+void rc522_pcd_batch_read(rc522_pcd_batch_t *batch, rc522_pcd_register_t addr, uint8_t *out)
+{
+    if (out == NULL) {
+        batch->error = ESP_ERR_INVALID_ARG;
+        return;
+    }
+
+    rc522_pcd_batch_op_t *op = rc522_pcd_batch_append(batch, RC522_PCD_BATCH_READ, addr);
+    if (op != NULL) {
+        op->out = out;
+    }
+}
+
+static void rc522_pcd_batch_modify(
+    rc522_pcd_batch_t *batch, rc522_pcd_batch_op_type_t type, rc522_pcd_register_t addr, uint8_t bits)
+{
+    const rc522_pcd_batch_op_t *written = NULL;
+
+    // Latest change of the register in this batch
+    for (uint8_t i = batch->op_count; i > 0; i--) {
+        const rc522_pcd_batch_op_t *op = &batch->ops[i - 1];
+        if (op->addr == addr && op->type != RC522_PCD_BATCH_READ) {
+            written = op;
+            break;
+        }
+    }
+
+    if (written != NULL && written->type == RC522_PCD_BATCH_WRITE && !rc522_pcd_reg_is_volatile(addr)) {
+        uint8_t value = batch->data[written->offset + written->length - 1];
+
+        rc522_pcd_batch_write(
+            batch, addr, type == RC522_PCD_BATCH_SET_BITS ? (uint8_t)(value | bits) : (uint8_t)(value & ~bits));
+        return;
+    }
+
+    rc522_pcd_batch_op_t *op = rc522_pcd_batch_append(batch, type, addr);
+    if (op != NULL) {
+        op->bits = bits;
+    }
+}
+
+void rc522_pcd_batch_set_bits(rc522_pcd_batch_t *batch, rc522_pcd_register_t addr, uint8_t bits)
+{
+    rc522_pcd_batch_modify(batch, RC522_PCD_BATCH_SET_BITS, addr, bits);
+}
+
+void rc522_pcd_batch_clear_bits(rc522_pcd_batch_t *batch, rc522_pcd_register_t addr, uint8_t bits)
+{
+    rc522_pcd_batch_modify(batch, RC522_PCD_BATCH_CLEAR_BITS, addr, bits);
+}
+
+static esp_err_t rc522_pcd_batch_run_reads(const rc522_handle_t rc522, const rc522_pcd_batch_op_t *ops, uint8_t count)
+{
+    uint8_t addresses[RC522_PCD_BATCH_MAX_OPS];
+    uint8_t values[RC522_PCD_BATCH_MAX_OPS];
+
+    for (uint8_t i = 0; i < count; i++) {
+        addresses[i] = ops[i].addr;
+    }
+
+    RC522_RETURN_ON_ERROR(rc522_driver_receive_regs(rc522->config->driver, addresses, values, count));
+
+    for (uint8_t i = 0; i < count; i++) {
+        *ops[i].out = values[i];
+        rc522_pcd_shadow_store(rc522, ops[i].addr, values[i]);
+        RC522_LOGV("pcd [0x%02" RC522_X "] >>> %02" RC522_X, ops[i].addr, values[i]);
+    }
+
+    return ESP_OK;
+}
+
+esp_err_t rc522_pcd_batch_run(const rc522_handle_t rc522, rc522_pcd_batch_t *batch)
+{
+    RC522_CHECK(rc522 == NULL);
+    RC522_CHECK(batch == NULL);
+    RC522_RETURN_ON_ERROR(batch->error);
+
+    esp_err_t ret = ESP_OK;
+
+    RC522_RETURN_ON_ERROR(rc522_driver_acquire_bus(rc522->config->driver));
+
+    for (uint8_t i = 0; i < batch->op_count && ret == ESP_OK; i++) {
+        const rc522_pcd_batch_op_t *op = &batch->ops[i];
+        uint8_t reads = 1;
+
+        switch (op->type) {
+            case RC522_PCD_BATCH_WRITE:
+                ret = rc522_pcd_write_n(rc522,
+                    op->addr,
+                    &(rc522_bytes_t) { .ptr = &batch->data[op->offset], .length = op->length });
+                break;
+            case RC522_PCD_BATCH_READ:
+                // Adjacent reads share one transaction, whatever their registers
+                while (i + reads < batch->op_count && batch->ops[i + reads].type == RC522_PCD_BATCH_READ) {
+                    reads++;
+                }
+                ret = rc522_pcd_batch_run_reads(rc522, op, reads);
+                i += reads - 1;
+                break;
+            case RC522_PCD_BATCH_SET_BITS:
+                ret = rc522_pcd_set_bits(rc522, op->addr, op->bits);
+                break;
+            case RC522_PCD_BATCH_CLEAR_BITS:
+                ret = rc522_pcd_clear_bits(rc522, op->addr, op->bits);
+                break;
+            default:
+                ret = ESP_ERR_INVALID_ARG;
+                break;
+        }
+    }
+
+    rc522_driver_release_bus(rc522->config->driver);
+
+    RC522_RETURN_ON_ERROR(ret);
+
+    return ESP_OK;
+}
@@ -1,6 +1,7 @@
 #include <esp_system.h>
 #include <esp_check.h>
 #include <string.h>
+#include <sys/param.h>
 
 #include "rc522_internal.h"
 #include "rc522_types_internal.h"
@@ -16,10 +17,92 @@ struct rc522_picc_transaction_context
     uint8_t interrupts;
     bool completed;
     uint8_t error_reg;
+    uint8_t fifo_level;  // FIFOLevelReg and ControlReg as read on completion
+    uint8_t control_reg;
+    uint8_t received; // Bytes drained from the FIFO while the reply was coming in
 };
 
-esp_err_t rc522_picc_send(const rc522_handle_t rc522, const rc522_picc_transaction_t *transaction,
-    rc522_picc_transaction_context_t *out_context)
+/**
+ * Receive buffer of a streamed exchange, filled while the PICC is still sending
+ */
+typedef struct
+{
+    uint8_t *ptr;
+    uint8_t capacity;
+    uint8_t length;
+} rc522_picc_rx_stream_t;
+
+#define RC522_PICC_FIFO_ALERT_BITS (RC522_PCD_HI_ALERT_IRQ_BIT | RC522_PCD_LO_ALERT_IRQ_BIT)
+
+/**
+ * Requests a streamed exchange still has to act on. Until the frame is out
+ * only LoAlert is of use: HiAlert would fire on the bytes still waiting to
+ * be sent, so with rx_stream set the wait is for TxIRq instead, and HiAlert
+ * takes over once the transmitter is done. LoAlert only while there is
+ * something left to send: it stays raised as the FIFO empties and would
+ * otherwise wake the wait over and over for nothing.
+ */
+static inline uint8_t rc522_picc_stream_irqs(
+    const rc522_bytes_t *tx, uint8_t tx_sent, bool tx_done, const rc522_picc_rx_stream_t *rx_stream)
+{
+    if (tx_done) {
+        return rx_stream ? RC522_PCD_HI_ALERT_IRQ_BIT : 0;
+    }
+
+    return (tx_sent < tx->length ? (RC522_PCD_LO_ALERT_IRQ_BIT | RC522_PCD_TX_IRQ_BIT) : 0)
+           | (rx_stream ? RC522_PCD_TX_IRQ_BIT : 0);
+}
+
+// Software deadline on top of the PCD timer, in case its interrupt never comes
+#define RC522_PICC_DEADLINE_MARGIN_MS (11)
+
+/**
+ * LoAlert: tops the FIFO up with the next bytes of the frame being sent
+ */
+static esp_err_t rc522_picc_stream_refill(const rc522_handle_t rc522, const rc522_bytes_t *tx, uint8_t *tx_sent)
+{
+    uint8_t fifo_level = 0;
+    RC522_RETURN_ON_ERROR(rc522_pcd_read(rc522, RC522_PCD_FIFO_LEVEL_REG, &fifo_level));
+
+    uint8_t chunk = MIN(RC522_PCD_FIFO_SIZE - fifo_level, tx->length - *tx_sent);
+
+    if (chunk > 0) {
+        RC522_RETURN_ON_ERROR(
+            rc522_pcd_fifo_write(rc522, &(rc522_bytes_t) { .ptr = tx->ptr + *tx_sent, .length = chunk }));
+        *tx_sent += chunk;
+    }
+
+    return ESP_OK;
+}
+
+/**
+ * HiAlert: moves what the PICC has sent so far into the receive buffer
+ */
+static esp_err_t rc522_picc_stream_drain(const rc522_handle_t rc522, rc522_picc_rx_stream_t *rx)
+{
+    uint8_t fifo_level = 0;
+    RC522_RETURN_ON_ERROR(rc522_pcd_read(rc522, RC522_PCD_FIFO_LEVEL_REG, &fifo_level));
+
+    // A full FIFO is 64 bytes, one more than an SPI burst: the driver
+    // splits the read (RC522_SPI_BURST_MAX)
+    if (fifo_level > 0) {
+        RC522_RETURN_ON_FALSE(fifo_level <= rx->capacity - rx->length, ESP_ERR_INVALID_SIZE);
+        RC522_RETURN_ON_ERROR(
+            rc522_pcd_fifo_read(rc522, &(rc522_bytes_t) { .ptr = rx->ptr + rx->length, .length = fifo_level }));
+        rx->length += fifo_level;
+    }
+
+    return ESP_OK;
+}
+
+/**
+ * Sends a frame and waits for the command to complete. A frame longer
+ * than the FIFO is fed in while it goes out (LoAlert), and with rx_stream
+ * set the reply is drained while it comes in (HiAlert, once TxIRq marks the
+ * frame as sent), so neither is limited to 64 bytes.
+ */
+static esp_err_t rc522_picc_send_frame(const rc522_handle_t rc522, const rc522_picc_transaction_t *transaction,
+    rc522_picc_rx_stream_t *rx_stream, rc522_picc_transaction_context_t *out_context)
 {
     RC522_CHECK(rc522 == NULL);
     RC522_CHECK(transaction == NULL);
@@ -28,6 +111,15 @@ esp_err_t rc522_picc_send(const rc522_handle_t rc522, const rc522_picc_transacti
         transaction->pcd_command != RC522_PCD_TRANSCEIVE_CMD && transaction->pcd_command != RC522_PCD_MF_AUTH_CMD);
     RC522_CHECK(transaction->expected_interrupts == 0);
 
+    const rc522_bytes_t *tx = &transaction->bytes;
+    const bool streaming = rx_stream != NULL || tx->length > RC522_PCD_FIFO_SIZE;
+    uint8_t tx_sent = MIN(tx->length, RC522_PCD_FIFO_SIZE);
+    uint8_t stream_irqs = streaming ? rc522_picc_stream_irqs(tx, tx_sent, false, rx_stream) : 0;
+    const uint32_t fwt_us = transaction->fwt_us ? transaction->fwt_us : RC522_PICC_FWT_DEFAULT_US;
+    const uint32_t deadline_ms = (fwt_us + 999) / 1000 + RC522_PICC_DEADLINE_MARGIN_MS;
+
+    RC522_CHECK(streaming && transaction->pcd_command != RC522_PCD_TRANSCEIVE_CMD);
+
     rc522_picc_transaction_context_t context = {
         .transaction = transaction,
     };
@@ -46,47 +138,116 @@ esp_err_t rc522_picc_send(const rc522_handle_t rc522, const rc522_picc_transacti
         RC522_LOGD("picc << %s", debug_buffer);
     }
 
-    RC522_RETURN_ON_ERROR(rc522_pcd_stop_active_command(rc522));
-    RC522_RETURN_ON_ERROR(rc522_pcd_clear_all_com_interrupts(rc522));
-    RC522_RETURN_ON_ERROR(rc522_pcd_fifo_flush(rc522));
-    RC522_RETURN_ON_ERROR(rc522_pcd_fifo_write(rc522, &transaction->bytes));
-    RC522_RETURN_ON_ERROR(rc522_pcd_write(rc522, RC522_PCD_BIT_FRAMING_REG, bit_framing));
-    RC522_RETURN_ON_ERROR(rc522_pcd_write(rc522, RC522_PCD_COMMAND_REG, transaction->pcd_command));
+    // Command setup in one go, with the bus held throughout. StartSend is
+    // folded into a plain write, since BitFramingReg was just written.
+    rc522_pcd_batch_t setup;
+    rc522_pcd_batch_init(&setup);
+    rc522_pcd_batch_write(&setup, RC522_PCD_COMMAND_REG, RC522_PCD_IDLE_CMD);
+    rc522_pcd_batch_write(&setup, RC522_PCD_COM_INT_REQ_REG, (uint8_t)(~RC522_PCD_SET_1_BIT));
+    rc522_pcd_batch_set_timeout(rc522, &setup, fwt_us);
+
+    if (streaming && rc522->irq_installed) {
+        // The streaming requests have to wake the wait below as well
+        rc522_pcd_batch_write(&setup, RC522_PCD_COM_INT_EN_REG, RC522_PCD_COM_IEN_DEFAULT | stream_irqs);
+    }
+
+    rc522_pcd_batch_write(&setup, RC522_PCD_FIFO_LEVEL_REG, RC522_PCD_FLUSH_BUFFER_BIT);
+    rc522_pcd_batch_write_n(&setup, RC522_PCD_FIFO_DATA_REG, &(rc522_bytes_t) { .ptr = tx->ptr, .length = tx_sent });
+    rc522_pcd_batch_write(&setup, RC522_PCD_BIT_FRAMING_REG, bit_framing);
+    rc522_pcd_batch_write(&setup, RC522_PCD_COMMAND_REG, transaction->pcd_command);
 
     if (transaction->pcd_command == RC522_PCD_TRANSCEIVE_CMD) {
-        RC522_RETURN_ON_ERROR(rc522_pcd_start_data_transmission(rc522));
+        rc522_pcd_batch_set_bits(&setup, RC522_PCD_BIT_FRAMING_REG, RC522_PCD_START_SEND_BIT);
     }
 
+    RC522_RETURN_ON_ERROR(rc522_pcd_batch_run(rc522, &setup));
+
     // TAuto flag in TModeReg is set.
     // This means the timer automatically starts when the PCD stops transmitting.
 
-    const uint32_t deadline = rc522_millis() + 36;
+    const uint8_t done_irq = transaction->expected_interrupts | RC522_PCD_TIMER_IRQ_BIT;
+    esp_err_t ret = ESP_OK;
 
-    do {
-        RC522_RETURN_ON_ERROR(rc522_pcd_read(rc522, RC522_PCD_COM_INT_REQ_REG, &context.interrupts));
+    while (ret == ESP_OK && (context.interrupts & done_irq) == 0) {
+        uint8_t irq = 0;
+        ret = rc522_pcd_wait_irq(rc522, RC522_PCD_COM_INT_REQ_REG, (done_irq | stream_irqs), deadline_ms, &irq);
 
-        if (context.interrupts & transaction->expected_interrupts) {
-            context.completed = true;
-            break;
+        if (ret != ESP_OK || !streaming) {
+            context.interrupts |= irq;
+            continue;
+        }
+
+        // Alert requests are stored events: clear them before acting, so a
+        // level crossed while refilling or draining raises them again
+        if (irq & RC522_PICC_FIFO_ALERT_BITS) {
+            ret = rc522_pcd_write(rc522, RC522_PCD_COM_INT_REQ_REG, (irq & RC522_PICC_FIFO_ALERT_BITS));
+        }
+
+        context.interrupts |= irq;
+
+        if (ret != ESP_OK) {
+            continue;
+        }
+
+        if (tx_sent < tx->length) {
+            if (context.interrupts & (RC522_PCD_TX_IRQ_BIT | done_irq)) {
+                // The transmitter ran dry before the frame was complete
+                ret = RC522_ERR_PCD_FIFO_UNDERFLOW;
+            }
+            else if (irq & RC522_PCD_LO_ALERT_IRQ_BIT) {
+                ret = rc522_picc_stream_refill(rc522, tx, &tx_sent);
+            }
+        }
+        else if ((stream_irqs & RC522_PCD_HI_ALERT_IRQ_BIT) && (irq & RC522_PCD_HI_ALERT_IRQ_BIT)) {
+            ret = rc522_picc_stream_drain(rc522, rx_stream);
         }
 
+        // Last byte queued, or frame sent: move on to the next set of
+        // requests. A HiAlert raised by the frame itself came with this read
+        // and was cleared above, so it is never taken for received bytes.
+        uint8_t next_irqs =
+            rc522_picc_stream_irqs(tx, tx_sent, (context.interrupts & RC522_PCD_TX_IRQ_BIT) != 0, rx_stream);
+
+        if (ret == ESP_OK && next_irqs != stream_irqs) {
+            stream_irqs = next_irqs;
+
+            if (rc522->irq_installed) {
+                ret = rc522_pcd_write(rc522, RC522_PCD_COM_INT_EN_REG, RC522_PCD_COM_IEN_DEFAULT | stream_irqs);
+            }
+        }
+    }
+
+    if (streaming && rc522->irq_installed) {
+        RC522_RETURN_ON_ERROR(rc522_pcd_write(rc522, RC522_PCD_COM_INT_EN_REG, RC522_PCD_COM_IEN_DEFAULT));
+    }
+
+    if (ret == ESP_OK) {
+        context.completed = (context.interrupts & transaction->expected_interrupts) != 0;
+
         // Timer interrupt - nothing received
-        if (context.interrupts & RC522_PCD_TIMER_IRQ_BIT) {
+        if (!context.completed) {
             RC522_LOGD("timer interrupt (irq=0x%02" RC522_X ")", context.interrupts);
 
             return RC522_ERR_RX_TIMER_TIMEOUT;
         }
-
-        taskYIELD();
     }
-    while (rc522_millis() < deadline);
+    else if (ret != ESP_ERR_TIMEOUT) {
+        RC522_RETURN_ON_ERROR(ret);
+    }
 
     // Deadline reached and nothing happened.
     // Communication with the MFRC522 might be down.
     RC522_RETURN_ON_FALSE(context.completed, RC522_ERR_RX_TIMEOUT);
 
+    // Error, FIFO level and RxLastBits in one transaction
+    rc522_pcd_batch_t status;
+    rc522_pcd_batch_init(&status);
+    rc522_pcd_batch_read(&status, RC522_PCD_ERROR_REG, &context.error_reg);
+    rc522_pcd_batch_read(&status, RC522_PCD_FIFO_LEVEL_REG, &context.fifo_level);
+    rc522_pcd_batch_read(&status, RC522_PCD_CONTROL_REG, &context.control_reg);
+    RC522_RETURN_ON_ERROR(rc522_pcd_batch_run(rc522, &status));
+
     // Stop now if any errors except collisions were detected.
-    RC522_RETURN_ON_ERROR(rc522_pcd_read(rc522, RC522_PCD_ERROR_REG, &context.error_reg));
 
     if (context.error_reg & RC522_PCD_BUFFER_OVFL_BIT) {
         return RC522_ERR_PCD_FIFO_BUFFER_OVERFLOW;
@@ -102,6 +263,10 @@ esp_err_t rc522_picc_send(const rc522_handle_t rc522, const rc522_picc_transacti
         return RC522_ERR_PCD_PROTOCOL_ERROR;
     }
 
+    if (rx_stream) {
+        context.received = rx_stream->length;
+    }
+
     if (out_context) {
         memcpy(out_context, &context, sizeof(context));
     }
@@ -109,6 +274,12 @@ esp_err_t rc522_picc_send(const rc522_handle_t rc522, const rc522_picc_transacti
     return ESP_OK;
 }
 
+esp_err_t rc522_picc_send(const rc522_handle_t rc522, const rc522_picc_transaction_t *transaction,
+    rc522_picc_transaction_context_t *out_context)
+{
+    return rc522_picc_send_frame(rc522, transaction, NULL, out_context);
+}
+
 static esp_err_t rc522_picc_receive(const rc522_handle_t rc522, const rc522_picc_transaction_context_t *context,
     rc522_picc_transaction_result_t *out_result)
 {
@@ -118,25 +289,28 @@ static esp_err_t rc522_picc_receive(const rc522_handle_t rc522, const rc522_picc
     RC522_CHECK(out_result == NULL);
     RC522_CHECK_BYTES(&context->transaction->bytes);
 
-    uint8_t fifo_level = 0;
-    RC522_RETURN_ON_ERROR(rc522_pcd_read(rc522, RC522_PCD_FIFO_LEVEL_REG, &fifo_level));
+    uint8_t fifo_level = context->fifo_level;
 
-    if (fifo_level < 1) {
+    if (context->received + fifo_level < 1) {
         RC522_LOGW("fifo empty (irq=0x%02" RC522_X ")", context->interrupts);
 
         return RC522_ERR_PCD_FIFO_EMPTY;
     }
 
-    RC522_CHECK(fifo_level > out_result->bytes.length);
+    RC522_CHECK(context->received + fifo_level > out_result->bytes.length);
 
+    // A streamed reply already has its first bytes in the caller's buffer
     rc522_picc_transaction_result_t result = {
         .bytes = { 
             .ptr = out_result->bytes.ptr, // Use buffer provided by caller
-            .length = fifo_level,
+            .length = (uint8_t)(context->received + fifo_level),
         },
     };
 
-    RC522_RETURN_ON_ERROR(rc522_pcd_fifo_read(rc522, &result.bytes));
+    if (fifo_level > 0) {
+        RC522_RETURN_ON_ERROR(rc522_pcd_fifo_read(rc522,
+            &(rc522_bytes_t) { .ptr = result.bytes.ptr + context->received, .length = fifo_level }));
+    }
 
     if (RC522_LOG_LEVEL >= ESP_LOG_DEBUG) {
         char debug_buffer[64];
@@ -153,8 +327,7 @@ static esp_err_t rc522_picc_receive(const rc522_handle_t rc522, const rc522_picc
 
     // RxLastBits[2:0] indicates the number of valid bits in the last received byte.
     // If this value is 0, the whole byte is valid.
-    RC522_RETURN_ON_ERROR(rc522_pcd_read(rc522, RC522_PCD_CONTROL_REG, &result.valid_bits));
-    result.valid_bits &= 0x07;
+    result.valid_bits = context->control_reg & 0x07;
 
     if (result.valid_bits) {
         RC522_LOGD("not full byte received, valid_bits=%d", result.valid_bits);
@@ -172,14 +345,7 @@ static esp_err_t rc522_picc_receive(const rc522_handle_t rc522, const rc522_picc
         RC522_CHECK_AND_RETURN(result.valid_bits != 0, ESP_ERR_INVALID_STATE);
 
         // Verify CRC_A
-        rc522_pcd_crc_t crc = { 0 };
-        RC522_RETURN_ON_ERROR(rc522_pcd_calculate_crc(rc522,
-            &(rc522_bytes_t) { .ptr = result.bytes.ptr, .length = result.bytes.length - 2 },
-            &crc));
-
-        if (memcmp(result.bytes.ptr + result.bytes.length - 2, &crc, sizeof(crc)) != 0) {
-            return RC522_ERR_CRC_WRONG;
-        }
+        RC522_RETURN_ON_ERROR_SILENTLY(rc522_pcd_check_crc(rc522, &result.bytes));
     }
 
     memcpy(out_result, &result, sizeof(result));
@@ -199,8 +365,18 @@ esp_err_t rc522_picc_transceive(const rc522_handle_t rc522, const rc522_picc_tra
     transaction_clone.pcd_command = RC522_PCD_TRANSCEIVE_CMD;
     transaction_clone.expected_interrupts = RC522_PCD_RX_IRQ_BIT | RC522_PCD_IDLE_IRQ_BIT;
 
+    // A reply that may not fit the FIFO is drained while it comes in
+    rc522_picc_rx_stream_t rx_stream = { 0 };
+    bool stream_reply = out_result != NULL && out_result->bytes.length > RC522_PCD_FIFO_SIZE;
+
+    if (stream_reply) {
+        rx_stream.ptr = out_result->bytes.ptr;
+        rx_stream.capacity = out_result->bytes.length;
+    }
+
     rc522_picc_transaction_context_t context = { 0 };
-    RC522_RETURN_ON_ERROR_SILENTLY(rc522_picc_send(rc522, &transaction_clone, &context));
+    RC522_RETURN_ON_ERROR_SILENTLY(
+        rc522_picc_send_frame(rc522, &transaction_clone, stream_reply ? &rx_stream : NULL, &context));
 
     if (out_result) {
         RC522_RETURN_ON_ERROR(rc522_picc_receive(rc522, &context, out_result));
@@ -236,6 +412,7 @@ static esp_err_t rc522_picc_reqa_or_wupa(const rc522_handle_t rc522, uint8_t pic
     rc522_picc_transaction_t transaction = {
         .bytes = { .ptr = &picc_cmd, .length = 1 },
         .valid_bits = 7, // REQA and WUPA use short frame format
+        .fwt_us = RC522_PICC_FWT_ACTIVATION_US,
     };
 
     rc522_picc_transaction_result_t transaction_result = {
@@ -420,12 +597,7 @@ esp_err_t rc522_picc_select(const rc522_handle_t rc522, rc522_picc_uid_t *out_ui
                 buffer[6] = buffer[2] ^ buffer[3] ^ buffer[4] ^ buffer[5];
                 // Calculate CRC_A
 
-                rc522_pcd_crc_t crc = { 0 };
-                RC522_RETURN_ON_ERROR(
-                    rc522_pcd_calculate_crc(rc522, &(rc522_bytes_t) { .ptr = buffer, .length = 7 }, &crc));
-
-                buffer[7] = crc.lsb;
-                buffer[8] = crc.msb;
+                RC522_RETURN_ON_ERROR(rc522_pcd_append_crc(rc522, &(rc522_bytes_t) { .ptr = buffer, .length = 7 }));
 
                 tx_last_bits = 0; // 0 => All 8 bits are valid.
                 buffer_used = 9;
@@ -458,6 +630,7 @@ esp_err_t rc522_picc_select(const rc522_handle_t rc522, rc522_picc_uid_t *out_ui
                 .bytes = { .ptr = buffer, .length = buffer_used },
                 .rx_align = rx_align,
                 .valid_bits = tx_last_bits,
+                .fwt_us = RC522_PICC_FWT_ACTIVATION_US,
             };
 
             rc522_picc_transaction_result_t transaction_result = {
@@ -545,24 +718,16 @@ esp_err_t rc522_picc_select(const rc522_handle_t rc522, rc522_picc_uid_t *out_ui
             RC522_LOGD("invalid sak");
             return RC522_ERR_INVALID_SAK;
         }
-        // Verify CRC_A - do our own calculation and store the control in buffer[2..3] - those bytes are not needed
-        // anymore.
+        // Verify CRC_A
 
 // compiler complains about uninitialized response_buffer even is
 // no chance that response_buffer is NULL here, so ignore warning here
 #pragma GCC diagnostic ignored "-Wmaybe-uninitialized"
-        rc522_pcd_crc_t crc = { 0 };
-        RC522_RETURN_ON_ERROR(
-            rc522_pcd_calculate_crc(rc522, &(rc522_bytes_t) { .ptr = response_buffer, .length = 1 }, &crc));
-
-        if (memcmp(response_buffer + 1, &crc, sizeof(crc)) != 0) {
+        if (rc522_pcd_check_crc(rc522, &(rc522_bytes_t) { .ptr = response_buffer, .length = 3 }) != ESP_OK) {
             RC522_LOGD("crc wrong");
             return RC522_ERR_CRC_WRONG;
         }
 
-        buffer[2] = crc.lsb;
-        buffer[3] = crc.msb;
-
         if (response_buffer[0] & 0x04) { // Cascade bit set - UID not complete yes
             cascade_level++;
         }
@@ -686,14 +851,11 @@ esp_err_t rc522_picc_halta(const rc522_handle_t rc522, rc522_picc_t *picc)
     buffer[0] = RC522_PICC_CMD_HLTA;
     buffer[1] = 0;
 
-    rc522_pcd_crc_t crc = { 0 };
-    RC522_RETURN_ON_ERROR(rc522_pcd_calculate_crc(rc522, &(rc522_bytes_t) { .ptr = buffer, .length = 2 }, &crc));
-
-    buffer[2] = crc.lsb;
-    buffer[3] = crc.msb;
+    RC522_RETURN_ON_ERROR(rc522_pcd_append_crc(rc522, &(rc522_bytes_t) { .ptr = buffer, .length = 2 }));
 
     rc522_picc_transaction_t transaction = {
         .bytes = { .ptr = buffer, .length = sizeof(buffer) },
+        .fwt_us = RC522_PICC_FWT_ACTIVATION_US,
     };
 
     esp_err_t ret = rc522_picc_transceive(rc522, &transaction, NULL);
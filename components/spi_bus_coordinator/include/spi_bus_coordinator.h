@@ -0,0 +1,95 @@
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "driver/spi_master.h"
+#include "esp_err.h"
+#include "freertos/FreeRTOS.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * Owns one SPI host shared by several drivers.
+ *
+ * The coordinator initializes the bus once; each driver then adds its own
+ * SPI device on it (own CS and clock) and registers with the coordinator.
+ * Drivers bracket every burst of transactions with acquire/release. The
+ * bus is handed directly to the waiting device of highest priority on
+ * release, so a high-priority device waits at most for one burst of a
+ * lower-priority device.
+ *
+ * max_hold_us is advisory: a transaction in flight cannot be preempted,
+ * so the coordinator only counts longer holds as overruns. Drivers meet
+ * the bound by splitting their work into bursts that fit it and releasing
+ * in between.
+ */
+
+#define SPI_BUS_COORDINATOR_MAX_DEVICES 4
+
+typedef enum {
+    SPI_BUS_PRIORITY_LOW = 0,
+    SPI_BUS_PRIORITY_HIGH = 1,
+} spi_bus_priority_t;
+
+typedef struct spi_bus_coordinator *spi_bus_coordinator_handle_t;
+typedef struct spi_bus_client *spi_bus_client_handle_t;
+
+typedef struct {
+    const char *name;
+    spi_bus_priority_t priority;
+    uint32_t max_hold_us;   /*<! Advisory burst bound, checked on release; 0 = unbounded */
+} spi_bus_client_config_t;
+
+typedef struct {
+    uint32_t acquisitions;
+    uint32_t contended;     /*<! Acquisitions that had to wait */
+    uint32_t overruns;      /*<! Bursts longer than max_hold_us */
+    int64_t busy_us;        /*<! Total time holding the bus */
+    int64_t wait_us;        /*<! Total time waiting for the bus */
+    int64_t wait_max_us;
+    int64_t hold_max_us;
+} spi_bus_client_stats_t;
+
+/**
+ * Initializes the SPI bus. The quad pins of bus_config are forced unused.
+ */
+esp_err_t spi_bus_coordinator_create(spi_host_device_t host_id, const spi_bus_config_t *bus_config,
+                                     spi_dma_chan_t dma_chan, spi_bus_coordinator_handle_t *out_coordinator);
+
+spi_host_device_t spi_bus_coordinator_host(spi_bus_coordinator_handle_t coordinator);
+
+/**
+ * Registers a driver. Safe while other clients are using the bus.
+ */
+esp_err_t spi_bus_coordinator_add_client(spi_bus_coordinator_handle_t coordinator,
+                                         const spi_bus_client_config_t *config,
+                                         spi_bus_client_handle_t *out_client);
+
+/**
+ * Blocks until the client owns the bus. Acquires by the owner nest; the
+ * bus is handed over on the matching outermost release. Not for ISRs.
+ */
+esp_err_t spi_bus_client_acquire(spi_bus_client_handle_t client, TickType_t timeout);
+
+void spi_bus_client_release(spi_bus_client_handle_t client);
+
+/**
+ * Copies the statistics gathered since the last call and, if reset is
+ * set, clears them. window_us receives the time they cover, for
+ * computing utilisation as busy_us / window_us.
+ */
+void spi_bus_client_stats(spi_bus_client_handle_t client, bool reset,
+                          spi_bus_client_stats_t *out_stats, int64_t *window_us);
+
+/**
+ * Logs utilisation, contention and worst-case wait of every client and
+ * clears the statistics.
+ */
+void spi_bus_coordinator_log_stats(spi_bus_coordinator_handle_t coordinator);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,254 @@
+#include <stdlib.h>
+#include <string.h>
+
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "freertos/semphr.h"
+#include "spi_bus_coordinator.h"
+
+static const char *TAG = "spi_bus";
+
+struct spi_bus_client
+{
+    struct spi_bus_coordinator *coordinator;
+    spi_bus_client_config_t config;
+    SemaphoreHandle_t granted;   // Given by release() when the bus is handed over
+    bool waiting;
+    uint32_t depth;              // Nested acquires by the owner
+    int64_t acquired_us;
+    spi_bus_client_stats_t stats;
+    int64_t stats_since_us;
+};
+
+struct spi_bus_coordinator
+{
+    spi_host_device_t host_id;
+    portMUX_TYPE lock;
+    struct spi_bus_client *owner;
+    // Sorted by priority, highest first, so release() hands the bus to the
+    // first waiting client
+    struct spi_bus_client *clients[SPI_BUS_COORDINATOR_MAX_DEVICES];
+    size_t client_count;
+};
+
+esp_err_t spi_bus_coordinator_create(spi_host_device_t host_id, const spi_bus_config_t *bus_config,
+                                     spi_dma_chan_t dma_chan, spi_bus_coordinator_handle_t *out_coordinator)
+{
+    if (bus_config == NULL || out_coordinator == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    struct spi_bus_coordinator *coordinator = calloc(1, sizeof(struct spi_bus_coordinator));
+    if (coordinator == NULL) {
+        return ESP_ERR_NO_MEM;
+    }
+
+    spi_bus_config_t config = *bus_config;
+    config.quadwp_io_num = -1;
+    config.quadhd_io_num = -1;
+
+    esp_err_t ret = spi_bus_initialize(host_id, &config, dma_chan);
+    if (ret != ESP_OK) {
+        free(coordinator);
+        return ret;
+    }
+
+    coordinator->host_id = host_id;
+    portMUX_INITIALIZE(&coordinator->lock);
+    *out_coordinator = coordinator;
+
+    return ESP_OK;
+}
+
+spi_host_device_t spi_bus_coordinator_host(spi_bus_coordinator_handle_t coordinator)
+{
+    return coordinator->host_id;
+}
+
+esp_err_t spi_bus_coordinator_add_client(spi_bus_coordinator_handle_t coordinator,
+                                         const spi_bus_client_config_t *config,
+                                         spi_bus_client_handle_t *out_client)
+{
+    if (coordinator == NULL || config == NULL || out_client == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    if (coordinator->client_count == SPI_BUS_COORDINATOR_MAX_DEVICES) {
+        return ESP_ERR_NO_MEM;
+    }
+
+    struct spi_bus_client *client = calloc(1, sizeof(struct spi_bus_client));
+    if (client == NULL) {
+        return ESP_ERR_NO_MEM;
+    }
+
+    client->granted = xSemaphoreCreateBinary();
+    if (client->granted == NULL) {
+        free(client);
+        return ESP_ERR_NO_MEM;
+    }
+
+    client->coordinator = coordinator;
+    client->config = *config;
+    client->stats_since_us = esp_timer_get_time();
+
+    // release() may be walking the list on another core
+    portENTER_CRITICAL(&coordinator->lock);
+    if (coordinator->client_count == SPI_BUS_COORDINATOR_MAX_DEVICES) {
+        portEXIT_CRITICAL(&coordinator->lock);
+        vSemaphoreDelete(client->granted);
+        free(client);
+        return ESP_ERR_NO_MEM;
+    }
+
+    // Equal priorities keep registration order
+    size_t i = coordinator->client_count;
+    while (i > 0 && coordinator->clients[i - 1]->config.priority < config->priority) {
+        coordinator->clients[i] = coordinator->clients[i - 1];
+        i--;
+    }
+    coordinator->clients[i] = client;
+    coordinator->client_count++;
+    portEXIT_CRITICAL(&coordinator->lock);
+
+    *out_client = client;
+
+    return ESP_OK;
+}
+
+static void account_acquired(struct spi_bus_client *client, int64_t requested_us, int64_t now_us)
+{
+    int64_t waited_us = now_us - requested_us;
+
+    client->acquired_us = now_us;
+    client->stats.acquisitions++;
+    client->stats.wait_us += waited_us;
+    if (waited_us > client->stats.wait_max_us) {
+        client->stats.wait_max_us = waited_us;
+    }
+}
+
+esp_err_t spi_bus_client_acquire(spi_bus_client_handle_t client, TickType_t timeout)
+{
+    struct spi_bus_coordinator *coordinator = client->coordinator;
+    int64_t requested_us = esp_timer_get_time();
+
+    portENTER_CRITICAL(&coordinator->lock);
+    if (coordinator->owner == client) {
+        client->depth++;
+        portEXIT_CRITICAL(&coordinator->lock);
+        return ESP_OK;
+    }
+    if (coordinator->owner == NULL) {
+        coordinator->owner = client;
+        client->depth = 1;
+        account_acquired(client, requested_us, requested_us);
+        portEXIT_CRITICAL(&coordinator->lock);
+        return ESP_OK;
+    }
+    client->waiting = true;
+    client->stats.contended++;
+    portEXIT_CRITICAL(&coordinator->lock);
+
+    if (xSemaphoreTake(client->granted, timeout) != pdTRUE) {
+        portENTER_CRITICAL(&coordinator->lock);
+        bool handed_over = coordinator->owner == client;
+        client->waiting = false;
+        portEXIT_CRITICAL(&coordinator->lock);
+
+        if (!handed_over) {
+            return ESP_ERR_TIMEOUT;
+        }
+        // The bus was handed over between the timeout and the lock. The
+        // releaser gives the semaphore after leaving the lock, so wait for
+        // it; a leftover give would let the next contended acquire through
+        // while another client owns the bus.
+        xSemaphoreTake(client->granted, portMAX_DELAY);
+    }
+
+    portENTER_CRITICAL(&coordinator->lock);
+    client->depth = 1;
+    account_acquired(client, requested_us, esp_timer_get_time());
+    portEXIT_CRITICAL(&coordinator->lock);
+
+    return ESP_OK;
+}
+
+void spi_bus_client_release(spi_bus_client_handle_t client)
+{
+    struct spi_bus_coordinator *coordinator = client->coordinator;
+    struct spi_bus_client *next = NULL;
+
+    if (--client->depth > 0) {
+        return;
+    }
+
+    int64_t held_us = esp_timer_get_time() - client->acquired_us;
+
+    portENTER_CRITICAL(&coordinator->lock);
+    client->stats.busy_us += held_us;
+    if (held_us > client->stats.hold_max_us) {
+        client->stats.hold_max_us = held_us;
+    }
+    if (client->config.max_hold_us > 0 && held_us > client->config.max_hold_us) {
+        client->stats.overruns++;
+    }
+
+    for (size_t i = 0; i < coordinator->client_count; i++) {
+        if (coordinator->clients[i]->waiting) {
+            next = coordinator->clients[i];
+            next->waiting = false;
+            break;
+        }
+    }
+    coordinator->owner = next;
+    portEXIT_CRITICAL(&coordinator->lock);
+
+    if (next != NULL) {
+        xSemaphoreGive(next->granted);
+    }
+}
+
+void spi_bus_client_stats(spi_bus_client_handle_t client, bool reset,
+                          spi_bus_client_stats_t *out_stats, int64_t *window_us)
+{
+    struct spi_bus_coordinator *coordinator = client->coordinator;
+    int64_t now_us = esp_timer_get_time();
+
+    portENTER_CRITICAL(&coordinator->lock);
+    *out_stats = client->stats;
+    if (window_us != NULL) {
+        *window_us = now_us - client->stats_since_us;
+    }
+    if (reset) {
+        memset(&client->stats, 0, sizeof(client->stats));
+        client->stats_since_us = now_us;
+    }
+    portEXIT_CRITICAL(&coordinator->lock);
+}
+
+void spi_bus_coordinator_log_stats(spi_bus_coordinator_handle_t coordinator)
+{
+    for (size_t i = 0;; i++) {
+        portENTER_CRITICAL(&coordinator->lock);
+        struct spi_bus_client *client = i < coordinator->client_count ? coordinator->clients[i] : NULL;
+        portEXIT_CRITICAL(&coordinator->lock);
+
+        if (client == NULL) {
+            break;
+        }
+
+        spi_bus_client_stats_t stats;
+        int64_t window_us;
+
+        spi_bus_client_stats(client, true, &stats, &window_us);
+
+        ESP_LOGI(TAG, "%-8s busy %5.2f%% | %lu bursts, %lu contended | wait avg %lld us, max %lld us | "
+                 "hold max %lld us, %lu over %lu us",
+                 client->config.name,
+                 window_us > 0 ? 100.0 * (double)stats.busy_us / (double)window_us : 0.0,
+                 (unsigned long)stats.acquisitions, (unsigned long)stats.contended,
+                 (long long)(stats.acquisitions ? stats.wait_us / stats.acquisitions : 0),
+                 (long long)stats.wait_max_us, (long long)stats.hold_max_us,
+                 (unsigned long)stats.overruns, (unsigned long)client->config.max_hold_us);
+    }
+}
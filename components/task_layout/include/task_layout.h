@@ -0,0 +1,100 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "esp_err.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "sdkconfig.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * One table per firmware places every subsystem task.
+ *
+ * Latency-critical work goes on TASK_LAYOUT_CORE_RT: the tasks that drain
+ * ISRs, the ISRs themselves (an interrupt is serviced on the core that
+ * installed it, so install them from a task on this core) and esp_timer
+ * dispatch, which runs on core 0. Logging, reports and other housekeeping
+ * go on TASK_LAYOUT_CORE_HOUSEKEEPING.
+ *
+ * Tasks are created from the table with task_layout_create(), or adopted
+ * (app_main) or attached (tasks created by a driver). The monitor then
+ * checks stack high-water marks and, with
+ * CONFIG_FREERTOS_GENERATE_RUN_TIME_STATS, CPU use against each budget.
+ * Registered tasks must not be deleted.
+ */
+
+#if CONFIG_FREERTOS_UNICORE
+#define TASK_LAYOUT_CORE_RT           0
+#define TASK_LAYOUT_CORE_HOUSEKEEPING 0
+#else
+#define TASK_LAYOUT_CORE_RT           0
+#define TASK_LAYOUT_CORE_HOUSEKEEPING 1
+#endif
+
+#define TASK_LAYOUT_MAX_TASKS 12
+
+// Free stack below this is reported as a violation
+#define TASK_LAYOUT_STACK_MARGIN 512
+
+typedef struct {
+    const char *name;
+    BaseType_t core_id;         /*<! Core to pin to, or tskNO_AFFINITY */
+    UBaseType_t priority;
+    uint32_t stack_size;        /*<! Bytes */
+    uint32_t period_ms;         /*<! 0 = event driven */
+    uint8_t cpu_budget_pct;     /*<! Share of one core, 0 = unchecked */
+} task_layout_entry_t;
+
+/**
+ * Validates and installs the table, which must outlive the program.
+ */
+esp_err_t task_layout_init(const task_layout_entry_t *table, size_t count);
+
+const task_layout_entry_t *task_layout_get(const char *name);
+
+/**
+ * Period of a table entry in ticks, at least one.
+ */
+TickType_t task_layout_period(const char *name);
+
+esp_err_t task_layout_create(const char *name, TaskFunction_t fn, void *arg, TaskHandle_t *out_handle);
+
+/**
+ * Applies the entry to the calling task: sets its priority and registers
+ * it. A running task cannot change core; a mismatch is reported with
+ * ESP_ERR_INVALID_STATE (for app_main, see CONFIG_ESP_MAIN_TASK_AFFINITY).
+ */
+esp_err_t task_layout_adopt(const char *name);
+
+/**
+ * Registers a task created elsewhere, e.g. by a driver from the entry's
+ * parameters.
+ */
+esp_err_t task_layout_attach(const char *name, TaskHandle_t handle);
+
+/**
+ * Logs stack and CPU use of every registered task since the last call and
+ * warns about budget or stack violations. Returns the number of violations.
+ */
+uint32_t task_layout_check(void);
+
+/**
+ * Creates the entry's task, which runs task_layout_check() every period.
+ */
+esp_err_t task_layout_start_monitor(const char *name);
+
+/**
+ * Routes ESP_LOG output through a buffer drained by the entry's task, so
+ * logging from real-time tasks only costs a formatted copy. Lines that do
+ * not fit are dropped and counted.
+ */
+esp_err_t task_layout_defer_logging(const char *name, size_t buffer_size);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,309 @@
+#include <stdarg.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "freertos/message_buffer.h"
+#include "freertos/semphr.h"
+#include "task_layout.h"
+
+static const char *TAG = "task_layout";
+
+// Longest deferred log line; longer lines are truncated
+#define TASK_LAYOUT_LOG_LINE 200
+
+struct task_slot
+{
+    TaskHandle_t handle;
+    uint32_t last_runtime;
+};
+
+static const task_layout_entry_t *layout;
+static size_t layout_count;
+static struct task_slot slots[TASK_LAYOUT_MAX_TASKS];
+static int64_t last_check_us;
+
+#if CONFIG_FREERTOS_GENERATE_RUN_TIME_STATS
+static uint32_t idle_runtime[portNUM_PROCESSORS];
+#endif
+
+static MessageBufferHandle_t log_buffer;
+static SemaphoreHandle_t log_mutex;
+static volatile uint32_t log_dropped;
+
+// Restarts the load window: the first report covers only the time since here
+static void reset_window(void)
+{
+    last_check_us = esp_timer_get_time();
+#if CONFIG_FREERTOS_GENERATE_RUN_TIME_STATS
+    for (int core = 0; core < portNUM_PROCESSORS; core++) {
+        idle_runtime[core] = ulTaskGetIdleRunTimeCounterForCore(core);
+    }
+#endif
+}
+
+static int find(const char *name)
+{
+    for (size_t i = 0; i < layout_count; i++) {
+        if (strcmp(layout[i].name, name) == 0) {
+            return (int)i;
+        }
+    }
+    return -1;
+}
+
+esp_err_t task_layout_init(const task_layout_entry_t *table, size_t count)
+{
+    if (table == NULL || count == 0 || count > TASK_LAYOUT_MAX_TASKS) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    for (size_t i = 0; i < count; i++) {
+        const task_layout_entry_t *e = &table[i];
+        bool core_ok = e->core_id == tskNO_AFFINITY || (e->core_id >= 0 && e->core_id < portNUM_PROCESSORS);
+
+        if (e->name == NULL || !core_ok || e->priority >= configMAX_PRIORITIES || e->cpu_budget_pct > 100) {
+            ESP_LOGE(TAG, "invalid entry %u (%s)", (unsigned)i, e->name ? e->name : "?");
+            return ESP_ERR_INVALID_ARG;
+        }
+        for (size_t j = 0; j < i; j++) {
+            if (strcmp(table[j].name, e->name) == 0) {
+                ESP_LOGE(TAG, "duplicate entry %s", e->name);
+                return ESP_ERR_INVALID_ARG;
+            }
+        }
+    }
+
+    layout = table;
+    layout_count = count;
+    memset(slots, 0, sizeof(slots));
+    reset_window();
+
+    return ESP_OK;
+}
+
+const task_layout_entry_t *task_layout_get(const char *name)
+{
+    int i = find(name);
+    return i < 0 ? NULL : &layout[i];
+}
+
+TickType_t task_layout_period(const char *name)
+{
+    const task_layout_entry_t *e = task_layout_get(name);
+    TickType_t ticks = e ? pdMS_TO_TICKS(e->period_ms) : 0;
+    return ticks > 0 ? ticks : 1;
+}
+
+static void register_slot(int i, TaskHandle_t handle)
+{
+    slots[i].handle = handle;
+#if CONFIG_FREERTOS_GENERATE_RUN_TIME_STATS
+    slots[i].last_runtime = ulTaskGetRunTimeCounter(handle);
+#endif
+}
+
+esp_err_t task_layout_create(const char *name, TaskFunction_t fn, void *arg, TaskHandle_t *out_handle)
+{
+    int i = find(name);
+    if (i < 0) {
+        return ESP_ERR_NOT_FOUND;
+    }
+
+    const task_layout_entry_t *e = &layout[i];
+    TaskHandle_t handle;
+    if (xTaskCreatePinnedToCore(fn, e->name, e->stack_size, arg, e->priority, &handle, e->core_id) != pdPASS) {
+        return ESP_ERR_NO_MEM;
+    }
+
+    register_slot(i, handle);
+    if (out_handle != NULL) {
+        *out_handle = handle;
+    }
+
+    return ESP_OK;
+}
+
+esp_err_t task_layout_adopt(const char *name)
+{
+    int i = find(name);
+    if (i < 0) {
+        return ESP_ERR_NOT_FOUND;
+    }
+
+    const task_layout_entry_t *e = &layout[i];
+    vTaskPrioritySet(NULL, e->priority);
+    register_slot(i, xTaskGetCurrentTaskHandle());
+
+    if (e->core_id != tskNO_AFFINITY && e->core_id != xPortGetCoreID()) {
+        ESP_LOGW(TAG, "%s runs on core %d, layout wants core %d", e->name, xPortGetCoreID(), (int)e->core_id);
+        return ESP_ERR_INVALID_STATE;
+    }
+
+    return ESP_OK;
+}
+
+esp_err_t task_layout_attach(const char *name, TaskHandle_t handle)
+{
+    int i = find(name);
+    if (i < 0 || handle == NULL) {
+        return i < 0 ? ESP_ERR_NOT_FOUND : ESP_ERR_INVALID_ARG;
+    }
+
+    register_slot(i, handle);
+
+    return ESP_OK;
+}
+
+uint32_t task_layout_check(void)
+{
+    uint32_t violations = 0;
+
+#if CONFIG_FREERTOS_GENERATE_RUN_TIME_STATS
+    int64_t now_us = esp_timer_get_time();
+    int64_t window_us = now_us - last_check_us;
+    last_check_us = now_us;
+
+    for (int core = 0; core < portNUM_PROCESSORS; core++) {
+        uint32_t runtime = ulTaskGetIdleRunTimeCounterForCore(core);
+        uint32_t idle_us = runtime - idle_runtime[core];
+        idle_runtime[core] = runtime;
+        if (window_us > 0) {
+            ESP_LOGI(TAG, "core %d load %5.1f%%", core, 100.0 - 100.0 * (double)idle_us / (double)window_us);
+        }
+    }
+#endif
+
+    for (size_t i = 0; i < layout_count; i++) {
+        const task_layout_entry_t *e = &layout[i];
+        struct task_slot *slot = &slots[i];
+
+        if (slot->handle == NULL) {
+            continue;
+        }
+
+        uint32_t free_stack = uxTaskGetStackHighWaterMark(slot->handle);
+        bool stack_low = free_stack < TASK_LAYOUT_STACK_MARGIN;
+        double cpu_pct = -1.0;
+
+#if CONFIG_FREERTOS_GENERATE_RUN_TIME_STATS
+        // 32-bit counter in us: the difference survives one wrap (~71 min)
+        uint32_t runtime = ulTaskGetRunTimeCounter(slot->handle);
+        uint32_t ran_us = runtime - slot->last_runtime;
+        slot->last_runtime = runtime;
+        if (window_us > 0) {
+            cpu_pct = 100.0 * (double)ran_us / (double)window_us;
+        }
+#endif
+        bool over_budget = e->cpu_budget_pct > 0 && cpu_pct > e->cpu_budget_pct;
+
+        char cpu[32] = "cpu n/a";
+        if (cpu_pct >= 0.0) {
+            snprintf(cpu, sizeof(cpu), "cpu %5.1f%% of %u%%%s", cpu_pct, (unsigned)e->cpu_budget_pct,
+                     over_budget ? " OVER" : "");
+        }
+
+        if (stack_low || over_budget) {
+            violations++;
+            ESP_LOGW(TAG, "%-12s core %2d prio %2u | stack free %5lu B%s | %s", e->name, (int)e->core_id,
+                     (unsigned)e->priority, (unsigned long)free_stack, stack_low ? " LOW" : "", cpu);
+        } else {
+            ESP_LOGI(TAG, "%-12s core %2d prio %2u | stack free %5lu B | %s", e->name, (int)e->core_id,
+                     (unsigned)e->priority, (unsigned long)free_stack, cpu);
+        }
+    }
+
+    return violations;
+}
+
+static void monitor_task(void *arg)
+{
+    const char *name = (const char *)arg;
+    TickType_t period = task_layout_period(name);
+    TickType_t last_wake = xTaskGetTickCount();
+
+    while (1) {
+        vTaskDelayUntil(&last_wake, period);
+        task_layout_check();
+    }
+}
+
+esp_err_t task_layout_start_monitor(const char *name)
+{
+    const task_layout_entry_t *e = task_layout_get(name);
+    if (e == NULL) {
+        return ESP_ERR_NOT_FOUND;
+    }
+
+    reset_window();
+
+    return task_layout_create(name, monitor_task, (void *)e->name, NULL);
+}
+
+static int deferred_vprintf(const char *fmt, va_list args)
+{
+    // Before the scheduler runs, or from an ISR, the mutex cannot be taken
+    if (xPortInIsrContext() || xTaskGetSchedulerState() != taskSCHEDULER_RUNNING) {
+        return vprintf(fmt, args);
+    }
+
+    // Message buffers take one writer at a time, and the same mutex guards
+    // the line: no task that logs needs room for it on its own stack
+    static char line[TASK_LAYOUT_LOG_LINE];
+
+    xSemaphoreTake(log_mutex, portMAX_DELAY);
+    int len = vsnprintf(line, sizeof(line), fmt, args);
+    size_t sent = 0;
+    if (len >= 0) {
+        size_t n = (size_t)len < sizeof(line) ? (size_t)len : sizeof(line) - 1;
+        sent = xMessageBufferSend(log_buffer, line, n, 0);
+    }
+    xSemaphoreGive(log_mutex);
+
+    if (len >= 0 && sent == 0) {
+        log_dropped++;
+    }
+
+    return len;
+}
+
+static void log_task(void *arg)
+{
+    char line[TASK_LAYOUT_LOG_LINE];
+    uint32_t reported_dropped = 0;
+
+    while (1) {
+        size_t n = xMessageBufferReceive(log_buffer, line, sizeof(line), portMAX_DELAY);
+        fwrite(line, 1, n, stdout);
+
+        uint32_t dropped = log_dropped;
+        if (dropped != reported_dropped && xMessageBufferIsEmpty(log_buffer)) {
+            printf("W (%lu) %s: %lu log lines dropped\n", (unsigned long)esp_log_timestamp(), TAG,
+                   (unsigned long)(dropped - reported_dropped));
+            reported_dropped = dropped;
+        }
+    }
+}
+
+esp_err_t task_layout_defer_logging(const char *name, size_t buffer_size)
+{
+    if (log_buffer != NULL) {
+        return ESP_ERR_INVALID_STATE;
+    }
+
+    log_mutex = xSemaphoreCreateMutex();
+    log_buffer = xMessageBufferCreate(buffer_size);
+    if (log_mutex == NULL || log_buffer == NULL) {
+        return ESP_ERR_NO_MEM;
+    }
+
+    esp_err_t err = task_layout_create(name, log_task, NULL, NULL);
+    if (err != ESP_OK) {
+        return err;
+    }
+
+    esp_log_set_vprintf(deferred_vprintf);
+
+    return ESP_OK;
+}